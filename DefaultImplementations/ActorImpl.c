@@ -0,0 +1,249 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <Actor.h>
+#include <ConsoleLog.h>
+#include <assert.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ACTOR_LOG( str, ... )      ConsoleLogLine( str, ##__VA_ARGS__ )
+
+static void WorkerThread( void* arg );
+
+static KMutex* MailboxLock( KActor* pActor )
+{
+  uintptr_t hash = ( ( uintptr_t )pActor >> 4 ) * 2654435761u;
+  return &pActor->pSystem->mailboxLocks[ ( hash >> 8 ) % KACTOR_MAILBOX_LOCKS ];
+}
+
+static void MakeReady( KActor* pActor )
+{
+  KActorSystem* pSystem = pActor->pSystem;
+  KMutexLock( &pSystem->readyMutex, WAIT_FOREVER );
+  KQueueInsert( &pSystem->readyQueue, &pActor->runElem );
+  KMutexUnlock( &pSystem->readyMutex );
+  KSemaPut( &pSystem->readySema );
+}
+
+static KActor* NextReady( KActorSystem* pSystem )
+{
+  KActor* pActor = NULL;
+  KMutexLock( &pSystem->readyMutex, WAIT_FOREVER );
+  pActor = ( KActor* )KQueueDequeue( &pSystem->readyQueue );
+  KMutexUnlock( &pSystem->readyMutex );
+  return pActor;
+}
+
+/**
+ * Takes the next message of a scheduled actor. Finding the
+ * mailbox empty unschedules the actor under the same lock, so a
+ * concurrent KActorSend() either lands before and is taken, or
+ * after and makes the actor ready again.
+ */
+static KActorMessage* TakeMessage( KActor* pActor, KMutex* pLock )
+{
+  KActorMessage* pMessage = NULL;
+  KMutexLock( pLock, WAIT_FOREVER );
+  pMessage = ( KActorMessage* )KQueueDequeue( &pActor->mailbox );
+  if ( !pMessage ) {
+    pActor->isScheduled = false;
+  }
+  KMutexUnlock( pLock );
+  return pMessage;
+}
+
+static void RunActor( KActorSystem* pSystem, KActor* pActor )
+{
+  KMutex* pLock = MailboxLock( pActor );
+  KActorMessage* pMessage = NULL;
+  uint32_t handled = 0;
+  bool isReady = false;
+
+  while( handled < pSystem->batch && ( pMessage = TakeMessage( pActor, pLock ) ) ) {
+    pActor->fnHandler( pActor, pMessage );
+    handled++;
+  }
+  if ( handled == pSystem->batch ) {
+    //Out of turns, go to the back of the line if there is more mail
+    KMutexLock( pLock, WAIT_FOREVER );
+    if ( KQueueIsEmpty( &pActor->mailbox ) ) {
+      pActor->isScheduled = false;
+    }
+    else {
+      isReady = true;
+    }
+    KMutexUnlock( pLock );
+    if ( isReady ) {
+      MakeReady( pActor );
+    }
+  }
+}
+
+static void DeleteLocks( KActorSystem* pSystem, uint32_t count )
+{
+  uint32_t i = 0;
+  for( i = 0; i < count; i++ ) {
+    KMutexDelete( &pSystem->mailboxLocks[ i ] );
+  }
+}
+
+static bool StartWorker( KActorSystem* pSystem, const KActorSystemDef* pDef )
+{
+  uint8_t* pStack = ( pDef->pStack ) ? 
+    ( uint8_t* )pDef->pStack + ( pSystem->workerCount * pDef->stackSize ) : NULL;
+  bool retval = false;
+  KTHREAD_CREATE_PARAMS( actorWorker, 
+                         pDef->pName, 
+                         WorkerThread, 
+                         pSystem,
+                         pStack,
+                         pDef->stackSize, 
+                         pDef->priority );
+  if ( KThreadCreate( &pSystem->workers[ pSystem->workerCount ], KTHREAD_PARAMS( actorWorker ) ) ) {
+    pSystem->workerCount++;
+    retval = true;
+  }
+  return retval;
+}
+
+bool KActorSystemCreate( KActorSystem* pSystem, const KActorSystemDef* pDef )
+{
+  assert( pSystem && pDef );
+  uint32_t workerCount = ( pDef->workerCount ) ? pDef->workerCount : KThreadGetCpuCount();
+  uint32_t locks = 0;
+  bool retval = false;
+
+  memset( pSystem, 0, sizeof( KActorSystem ) );
+  if ( workerCount > KACTOR_WORKERS_MAX ) {
+    workerCount = KACTOR_WORKERS_MAX;
+  }
+  while( locks < KACTOR_MAILBOX_LOCKS &&
+         KMutexCreateEx( &pSystem->mailboxLocks[ locks ], pDef->pName, KMUTEX_KIND_ADAPTIVE, 0 ) ) {
+    locks++;
+  }
+
+  if ( locks < KACTOR_MAILBOX_LOCKS ) {
+    ACTOR_LOG( "%s(): %s: Couldn't create mailbox locks", __FUNCTION__, pDef->pName );
+    DeleteLocks( pSystem, locks );
+  }
+  else if ( !KMutexCreate( &pSystem->readyMutex, pDef->pName ) ) {
+    ACTOR_LOG( "%s(): %s: Couldn't create mutex", __FUNCTION__, pDef->pName );
+    DeleteLocks( pSystem, locks );
+  }
+  else if ( !KSemaCreate( &pSystem->readySema, pDef->pName, 0 ) ) {
+    ACTOR_LOG( "%s(): %s: Couldn't create semaphore", __FUNCTION__, pDef->pName );
+    KMutexDelete( &pSystem->readyMutex );
+    DeleteLocks( pSystem, locks );
+  }
+  else {
+    KQueueInit( &pSystem->readyQueue );
+    pSystem->batch = ( pDef->batch ) ? pDef->batch : KACTOR_DEFAULT_BATCH;
+    KAtomicStore32( &pSystem->keepRunning, true, KATOMIC_RELAXED );
+    pSystem->isInitialized = true;
+    retval = true;
+    while( retval && pSystem->workerCount < workerCount ) {
+      if ( !StartWorker( pSystem, pDef ) ) {
+        ACTOR_LOG( "%s(): %s: Couldn't create Worker %u", __FUNCTION__, pDef->pName, pSystem->workerCount );
+        KActorSystemDestroy( pSystem );
+        retval = false;
+      }
+    }
+  }
+  return retval;
+}
+
+void KActorSystemDestroy( KActorSystem* pSystem )
+{
+  uint32_t i = 0;
+  if ( pSystem && pSystem->isInitialized ) {
+    KAtomicStore32( &pSystem->keepRunning, false, KATOMIC_RELEASE );
+    for( i = 0; i < pSystem->workerCount; i++ ) {
+      KSemaPut( &pSystem->readySema );
+    }
+    for( i = 0; i < pSystem->workerCount; i++ ) {
+      if ( !KThreadDelete( &pSystem->workers[ i ] ) ) {
+        ACTOR_LOG( "%s(): Couldn't Delete Worker %u", __FUNCTION__, i );
+        assert( 0 );
+      }
+    }
+    pSystem->workerCount = 0;
+    KSemaDelete( &pSystem->readySema );
+    KMutexDelete( &pSystem->readyMutex );
+    DeleteLocks( pSystem, KACTOR_MAILBOX_LOCKS );
+    pSystem->isInitialized = false;
+  }
+}
+
+void KActorInit( KActor* pActor, KActorSystem* pSystem, KActorHandler fnHandler, void* pContext )
+{
+  assert( pActor && pSystem && fnHandler );
+  memset( pActor, 0, sizeof( KActor ) );
+  KQueueInit( &pActor->mailbox );
+  pActor->fnHandler = fnHandler;
+  pActor->pContext = pContext;
+  pActor->pSystem = pSystem;
+}
+
+void KActorSend( KActor* pActor, KActorMessage* pMessage )
+{
+  assert( pActor && pMessage );
+  KMutex* pLock = MailboxLock( pActor );
+  bool isReady = false;
+  KMutexLock( pLock, WAIT_FOREVER );
+  KQueueInsert( &pActor->mailbox, &pMessage->listElem );
+  if ( !pActor->isScheduled ) {
+    pActor->isScheduled = isReady = true;
+  }
+  KMutexUnlock( pLock );
+  if ( isReady ) {
+    MakeReady( pActor );
+  }
+}
+
+void* KActorGetContext( KActor* pActor )
+{
+  return pActor->pContext;
+}
+
+static void WorkerThread( void* arg )
+{
+  KActorSystem* pSystem = ( KActorSystem* )arg;
+  KActor* pActor = NULL;
+
+  while( KAtomicLoad32( &pSystem->keepRunning, KATOMIC_ACQUIRE ) ) {
+    KSemaGet( &pSystem->readySema, WAIT_FOREVER );
+    //Destroy puts the semaphore without queueing an actor
+    pActor = NextReady( pSystem );
+    if ( pActor ) {
+      RunActor( pSystem, pActor );
+    }
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
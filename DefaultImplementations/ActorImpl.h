@@ -0,0 +1,96 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __ACTOR_IMPL_H__
+#define __ACTOR_IMPL_H__
+
+#include <ThreadInterface.h>
+#include <MutexInterface.h>
+#include <SemaphoreInterface.h>
+#include <AtomicInterface.h>
+#include <klist.h>
+#include <AbstractUtilsConfig.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Mailboxes are guarded by a small set of locks shared by all the
+ * actors of a system, picked by the address of the actor, so
+ * that an actor costs no OS object of its own.
+ */
+#define KACTOR_MAILBOX_LOCKS          ( 16 )
+
+/**
+ * Messages an actor handles before its worker moves on to the
+ * next ready actor, when KActorSystemDef.batch is 0.
+ */
+#define KACTOR_DEFAULT_BATCH          ( 16 )
+
+struct _KActor;
+
+/**
+ * @struct KActorMessage - Header of every message sent to an
+ *         actor. Must be the first member of the message.
+ */
+typedef struct _KActorMessage
+{
+  KListElem listElem;
+}KActorMessage;
+
+/**
+ * Handles one message. Runs on one of the workers of the
+ * system, never on two workers at once for the same actor. The
+ * handler owns the message from then on.
+ */
+typedef void (*KActorHandler)( struct _KActor* pActor, KActorMessage* pMessage );
+
+typedef struct _KActor
+{
+  KListElem runElem;                /**< Links the actor into the ready queue, must stay first */
+  KQueue mailbox;
+  KActorHandler fnHandler;
+  void* pContext;
+  struct _KActorSystem* pSystem;
+  bool isScheduled;                 /**< Queued as ready or running, guarded by the mailbox lock */
+}KActor;
+
+typedef struct _KActorSystem
+{
+  KThread workers[ KACTOR_WORKERS_MAX ];
+  uint32_t workerCount;             /**< Workers whose thread has been started */
+  uint32_t batch;
+  KMutex mailboxLocks[ KACTOR_MAILBOX_LOCKS ];
+  KMutex readyMutex;
+  KQueue readyQueue;                /**< Actors with mail that no worker has picked up yet */
+  KSema readySema;                  /**< Put once for every actor made ready */
+  KAtomicU32 keepRunning;
+  bool isInitialized;
+}KActorSystem;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __ACTOR_IMPL_H__
@@ -0,0 +1,118 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <Barrier.h>
+#include <ConsoleLog.h>
+#include <assert.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BARRIER_LOG( str, ... )     ConsoleLogLine( str, ##__VA_ARGS__ )
+
+/**
+ * Event flag that releases a phase. Consecutive phases use 
+ * different flags, so the flag of a phase can be cleared while 
+ * the threads of the previous one may still be waking up. 
+ */
+#define BARRIER_SENSE_FLAG( phase ) ( 1 << ( ( phase ) & 1 ) )
+
+static void Await( KBarrier* pBarrier, uint32_t phase )
+{
+  uint32_t spins = 0;
+  while( spins++ < pBarrier->spinCount && KAtomicLoad32( &pBarrier->phase, KATOMIC_ACQUIRE ) == phase ) {
+    KCPU_RELAX();
+  }
+  if ( KAtomicLoad32( &pBarrier->phase, KATOMIC_ACQUIRE ) == phase ) {
+    //Either the last thread sees this sleeper or this thread sees the phase change
+    KAtomicFetchAdd32( &pBarrier->sleepers, 1, KATOMIC_SEQ_CST );
+    if ( KAtomicLoad32( &pBarrier->phase, KATOMIC_SEQ_CST ) == phase ) {
+      KEventWait( &pBarrier->event, BARRIER_SENSE_FLAG( phase ), KEVENT_WAIT_ANY, WAIT_FOREVER );
+    }
+  }
+}
+
+static void Release( KBarrier* pBarrier, uint32_t phase )
+{
+  KAtomicStore32( &pBarrier->remaining, pBarrier->threadCount, KATOMIC_RELAXED );
+  //Cleared before anyone can get to the next phase and wait on it
+  KEventClear( &pBarrier->event, BARRIER_SENSE_FLAG( phase + 1 ) );
+  KAtomicStore32( &pBarrier->phase, phase + 1, KATOMIC_SEQ_CST );
+  if ( KAtomicExchange32( &pBarrier->sleepers, 0, KATOMIC_SEQ_CST ) ) {
+    KEventSet( &pBarrier->event, BARRIER_SENSE_FLAG( phase ) );
+  }
+}
+
+bool KBarrierCreate( KBarrier* pBarrier, const KBarrierDef* pDef )
+{
+  bool retval = false;
+  if ( pBarrier && pDef && pDef->threadCount ) {
+    memset( pBarrier, 0, sizeof( KBarrier ) );
+    KAtomicStore32( &pBarrier->remaining, pDef->threadCount, KATOMIC_RELAXED );
+    pBarrier->threadCount = pDef->threadCount;
+    pBarrier->spinCount = pDef->spinCount;
+    pBarrier->fnLast = pDef->fnLast;
+    pBarrier->pContext = pDef->pContext;
+    if ( KEventCreate( &pBarrier->event, pDef->pName ) ) {
+      pBarrier->isInitialized = true;
+      retval = true;
+    }
+    else {
+      BARRIER_LOG( "%s(): Couldn't create the event of %s", __FUNCTION__, pDef->pName );
+    }
+  }
+  return retval;
+}
+
+void KBarrierDestroy( KBarrier* pBarrier )
+{
+  if ( pBarrier && pBarrier->isInitialized ) {
+    KEventDelete( &pBarrier->event );
+    pBarrier->isInitialized = false;
+  }
+}
+
+bool KBarrierWait( KBarrier* pBarrier )
+{
+  uint32_t phase = 0;
+  bool retval = false;
+  assert( pBarrier && pBarrier->isInitialized );
+  phase = KAtomicLoad32( &pBarrier->phase, KATOMIC_ACQUIRE );
+  if ( KAtomicFetchSub32( &pBarrier->remaining, 1, KATOMIC_ACQ_REL ) == 1 ) {
+    if ( pBarrier->fnLast ) {
+      pBarrier->fnLast( pBarrier->pContext );
+    }
+    Release( pBarrier, phase );
+    retval = true;
+  }
+  else {
+    Await( pBarrier, phase );
+  }
+  return retval;
+}
+
+#ifdef __cplusplus
+}
+#endif
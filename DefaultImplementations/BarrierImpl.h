@@ -0,0 +1,57 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __BARRIER_IMPL_H__
+#define __BARRIER_IMPL_H__
+
+#include <EventInterface.h>
+#include <AtomicInterface.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Called by the last thread to reach a KBarrier, before the
+ * others are let go. 
+ */
+typedef void (*KBarrierCallback)( void* pContext );
+
+typedef struct _KBarrier
+{
+  KAtomicU32 remaining;             /**< Threads yet to arrive in this phase */
+  KAtomicU32 phase;                 /**< Phases completed, its low bit is the sense */
+  KAtomicU32 sleepers;              /**< Threads that may be blocked on the event */
+  uint32_t threadCount;
+  uint32_t spinCount;
+  KBarrierCallback fnLast;
+  void* pContext;
+  KEvent event;                     /**< One flag per sense, set to release a phase */
+  bool isInitialized;
+}KBarrier;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BARRIER_IMPL_H__
@@ -0,0 +1,169 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <Epoch.h>
+#include <ConsoleLog.h>
+#include <assert.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EPOCH_LOG( str, ... )       ConsoleLogLine( str, ##__VA_ARGS__ )
+
+#define EPOCH_STATE_ACTIVE          ( 1 )
+#define EPOCH_STATE( epoch )        ( ( ( epoch ) << 1 ) | EPOCH_STATE_ACTIVE )
+
+/**
+ * The epoch can only move on once every thread in a critical 
+ * section has entered it in the current epoch. 
+ */
+static void TryAdvance( KEpochDomain* pDomain )
+{
+  uint32_t epoch = KAtomicLoad32( &pDomain->epoch, KATOMIC_SEQ_CST );
+  uint32_t state = 0;
+  uint32_t i = 0;
+  //Pairs with the fence in KEpochEnter(), a thread entering now is seen here or sees the new epoch
+  KAtomicFence( KATOMIC_SEQ_CST );
+  for( i = 0; i < KEPOCH_THREADS_MAX; i++ ) {
+    state = KAtomicLoad32( &pDomain->threads[ i ].state, KATOMIC_ACQUIRE );
+    if ( ( state & EPOCH_STATE_ACTIVE ) && state != EPOCH_STATE( epoch ) ) {
+      return;
+    }
+  }
+  KAtomicCompareExchange32( &pDomain->epoch, &epoch, epoch + 1, KATOMIC_ACQ_REL );
+}
+
+static uint32_t FreeLimbo( KEpochThread* pThread, uint32_t epoch, bool isAll )
+{
+  KEpochNode* pNode = NULL;
+  //Retired in order, the first node that isn't safe ends the run
+  while( pThread->pLimboHead && ( isAll || pThread->pLimboHead->epoch + 2 <= epoch ) ) {
+    pNode = pThread->pLimboHead;
+    pThread->pLimboHead = pNode->pNext;
+    pThread->limboCount--;
+    PoolFree( pNode->pPool, pNode->pObject );
+  }
+  if ( !pThread->pLimboHead ) {
+    pThread->pLimboTail = NULL;
+  }
+  return pThread->limboCount;
+}
+
+void KEpochDomainCreate( KEpochDomain* pDomain )
+{
+  assert( pDomain );
+  memset( pDomain, 0, sizeof( KEpochDomain ) );
+  KAtomicStore32( &pDomain->epoch, 0, KATOMIC_RELAXED );
+  pDomain->isInitialized = true;
+}
+
+void KEpochDomainDestroy( KEpochDomain* pDomain )
+{
+  uint32_t i = 0;
+  if ( pDomain && pDomain->isInitialized ) {
+    for( i = 0; i < KEPOCH_THREADS_MAX; i++ ) {
+      FreeLimbo( &pDomain->threads[ i ], 0, true );
+    }
+    pDomain->isInitialized = false;
+  }
+}
+
+KEpochThread* KEpochRegister( KEpochDomain* pDomain )
+{
+  KEpochThread* retval = NULL;
+  uint32_t isClaimed = 0;
+  uint32_t i = 0;
+  assert( pDomain && pDomain->isInitialized );
+  for( i = 0; i < KEPOCH_THREADS_MAX && !retval; i++ ) {
+    isClaimed = 0;
+    //Acquire takes over the limbo list left by the last owner
+    if ( KAtomicCompareExchange32( &pDomain->threads[ i ].isClaimed, &isClaimed, 1, KATOMIC_ACQUIRE ) ) {
+      retval = &pDomain->threads[ i ];
+      retval->pDomain = pDomain;
+      retval->nesting = 0;
+    }
+  }
+  if ( !retval ) {
+    EPOCH_LOG( "%s(): All %u threads of the domain are in use", __FUNCTION__, KEPOCH_THREADS_MAX );
+  }
+  return retval;
+}
+
+void KEpochUnregister( KEpochThread* pThread )
+{
+  assert( pThread && pThread->nesting == 0 );
+  KEpochReclaim( pThread );
+  KAtomicStore32( &pThread->isClaimed, 0, KATOMIC_RELEASE );
+}
+
+void KEpochEnter( KEpochThread* pThread )
+{
+  uint32_t epoch = 0;
+  if ( pThread->nesting++ == 0 ) {
+    epoch = KAtomicLoad32( &pThread->pDomain->epoch, KATOMIC_RELAXED );
+    KAtomicStore32( &pThread->state, EPOCH_STATE( epoch ), KATOMIC_RELAXED );
+    //The state must be visible before any shared pointer is read
+    KAtomicFence( KATOMIC_SEQ_CST );
+  }
+}
+
+void KEpochExit( KEpochThread* pThread )
+{
+  assert( pThread->nesting > 0 );
+  if ( --pThread->nesting == 0 ) {
+    KAtomicStore32( &pThread->state, 0, KATOMIC_RELEASE );
+  }
+}
+
+void KEpochRetire( KEpochThread* pThread, KEpochNode* pNode, MemPool* pPool, void* pObject )
+{
+  assert( pThread && pNode && pPool && pObject );
+  pNode->pNext = NULL;
+  pNode->pPool = pPool;
+  pNode->pObject = pObject;
+  //Read after the object was unlinked, any reader that can still reach it is in this epoch or an earlier one
+  pNode->epoch = KAtomicLoad32( &pThread->pDomain->epoch, KATOMIC_SEQ_CST );
+  if ( pThread->pLimboTail ) {
+    pThread->pLimboTail->pNext = pNode;
+  }
+  else {
+    pThread->pLimboHead = pNode;
+  }
+  pThread->pLimboTail = pNode;
+  if ( ++pThread->limboCount >= KEPOCH_RECLAIM_BATCH ) {
+    KEpochReclaim( pThread );
+  }
+}
+
+uint32_t KEpochReclaim( KEpochThread* pThread )
+{
+  assert( pThread );
+  TryAdvance( pThread->pDomain );
+  return FreeLimbo( pThread, KAtomicLoad32( &pThread->pDomain->epoch, KATOMIC_ACQUIRE ), false );
+}
+
+#ifdef __cplusplus
+}
+#endif
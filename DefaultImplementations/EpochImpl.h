@@ -0,0 +1,80 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __EPOCH_IMPL_H__
+#define __EPOCH_IMPL_H__
+
+#include <AtomicInterface.h>
+#include <Pool.h>
+#include <AbstractUtilsConfig.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Objects a thread retires before it tries to reclaim the ones
+ * that are safe to free. 
+ */
+#define KEPOCH_RECLAIM_BATCH          ( 32 )
+
+/**
+ * @struct KEpochNode - Retires an object. Must be embedded in
+ *         the object, it is only touched once no reader can
+ *         reach the object anymore.
+ */
+typedef struct _KEpochNode
+{
+  struct _KEpochNode* pNext;
+  MemPool* pPool;
+  void* pObject;
+  uint32_t epoch;                   /**< Global epoch when the object was retired */
+}KEpochNode;
+
+/**
+ * @struct KEpochThread - Record of a thread taking part in a
+ *         domain. Only state is read by other threads.
+ */
+typedef struct _KEpochThread
+{
+  KAtomicU32 state;                 /**< Epoch seen on entry << 1 | 1 while in a critical section, 0 outside */
+  KAtomicU32 isClaimed;             /**< Owned by a registered thread */
+  struct _KEpochDomain* pDomain;
+  uint32_t nesting;
+  KEpochNode* pLimboHead;           /**< Retired objects, oldest first */
+  KEpochNode* pLimboTail;
+  uint32_t limboCount;
+}KEpochThread;
+
+typedef struct _KEpochDomain
+{
+  KAtomicU32 epoch;
+  KEpochThread threads[ KEPOCH_THREADS_MAX ];
+  bool isInitialized;
+}KEpochDomain;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPOCH_IMPL_H__
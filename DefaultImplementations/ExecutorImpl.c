@@ -0,0 +1,422 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <Executor.h>
+#include <EventInterface.h>
+#include <ConsoleLog.h>
+#include <assert.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EXECUTOR_LOG( str, ... )      ConsoleLogLine( str, ##__VA_ARGS__ )
+
+#define TASK_GROUP_DONE               ( 1 << 0 )
+/** Polls a joined group this many times before yielding the CPU to the workers running it */
+#define EXECUTOR_JOIN_SPINS           ( 64 )
+
+static void WorkerThread( void* arg );
+
+/**
+ * The deques follow Chase and Lev, "Dynamic Circular 
+ * Work-Stealing Deque", without the growing: a full deque makes 
+ * the caller run the task itself. top and bottom only ever 
+ * increase and are compared by their difference, so they are 
+ * free to wrap. 
+ */
+static bool DequePush( KExecutorWorker* pWorker, KExecutorTask* pTask )
+{
+  uint32_t mask = pWorker->pExecutor->dequeMask;
+  uint32_t bottom = KAtomicLoad32( &pWorker->bottom, KATOMIC_RELAXED );
+  uint32_t top = KAtomicLoad32( &pWorker->top, KATOMIC_ACQUIRE );
+  bool retval = false;
+  if ( ( bottom - top ) <= mask ) {
+    KAtomicStorePtr( &pWorker->pDeque[ bottom & mask ], pTask, KATOMIC_RELAXED );
+    KAtomicStore32( &pWorker->bottom, bottom + 1, KATOMIC_SEQ_CST );
+    retval = true;
+  }
+  return retval;
+}
+
+static KExecutorTask* DequeTake( KExecutorWorker* pWorker )
+{
+  uint32_t mask = pWorker->pExecutor->dequeMask;
+  uint32_t bottom = KAtomicLoad32( &pWorker->bottom, KATOMIC_RELAXED ) - 1;
+  uint32_t top = 0;
+  KExecutorTask* retval = NULL;
+
+  //Claim the bottom slot before looking at top, thieves do the opposite
+  KAtomicStore32( &pWorker->bottom, bottom, KATOMIC_SEQ_CST );
+  top = KAtomicLoad32( &pWorker->top, KATOMIC_SEQ_CST );
+  if ( ( int32_t )( bottom - top ) >= 0 ) {
+    retval = KAtomicLoadPtr( &pWorker->pDeque[ bottom & mask ], KATOMIC_RELAXED );
+    if ( bottom == top ) {
+      //Last task, a thief may be after it as well
+      if ( !KAtomicCompareExchange32( &pWorker->top, &top, top + 1, KATOMIC_SEQ_CST ) ) {
+        retval = NULL;
+      }
+      KAtomicStore32( &pWorker->bottom, bottom + 1, KATOMIC_RELAXED );
+    }
+  }
+  else {
+    KAtomicStore32( &pWorker->bottom, bottom + 1, KATOMIC_RELAXED );
+  }
+  return retval;
+}
+
+static KExecutorTask* DequeSteal( KExecutorWorker* pVictim )
+{
+  uint32_t mask = pVictim->pExecutor->dequeMask;
+  uint32_t top = KAtomicLoad32( &pVictim->top, KATOMIC_SEQ_CST );
+  uint32_t bottom = KAtomicLoad32( &pVictim->bottom, KATOMIC_SEQ_CST );
+  KExecutorTask* retval = NULL;
+  if ( ( int32_t )( bottom - top ) > 0 ) {
+    retval = KAtomicLoadPtr( &pVictim->pDeque[ top & mask ], KATOMIC_RELAXED );
+    //Lost to the owner or another thief
+    if ( !KAtomicCompareExchange32( &pVictim->top, &top, top + 1, KATOMIC_SEQ_CST ) ) {
+      retval = NULL;
+    }
+  }
+  return retval;
+}
+
+static KExecutorTask* InjectPop( KExecutor* pExecutor )
+{
+  KExecutorTask* retval = NULL;
+  if ( KAtomicLoad32( &pExecutor->injectCount, KATOMIC_SEQ_CST ) ) {
+    KMutexLock( &pExecutor->injectMutex, WAIT_FOREVER );
+    retval = ( KExecutorTask* )KQueueDequeue( &pExecutor->injectQueue );
+    KMutexUnlock( &pExecutor->injectMutex );
+    if ( retval ) {
+      KAtomicFetchSub32( &pExecutor->injectCount, 1, KATOMIC_RELAXED );
+    }
+  }
+  return retval;
+}
+
+static uint32_t NextVictim( KExecutorWorker* pWorker )
+{
+  //xorshift32, only needs to spread the thieves over the workers
+  uint32_t x = pWorker->stealSeed;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  pWorker->stealSeed = x;
+  return x % pWorker->pExecutor->workerCount;
+}
+
+static KExecutorTask* FindTask( KExecutorWorker* pWorker )
+{
+  KExecutor* pExecutor = pWorker->pExecutor;
+  KExecutorTask* retval = DequeTake( pWorker );
+  uint32_t start = 0;
+  uint32_t i = 0;
+
+  if ( !retval ) {
+    retval = InjectPop( pExecutor );
+  }
+  if ( !retval && pExecutor->workerCount > 1 ) {
+    start = NextVictim( pWorker );
+    for( i = 0; !retval && i < pExecutor->workerCount; i++ ) {
+      KExecutorWorker* pVictim = &pExecutor->workers[ ( start + i ) % pExecutor->workerCount ];
+      if ( pVictim != pWorker ) {
+        retval = DequeSteal( pVictim );
+      }
+    }
+  }
+  return retval;
+}
+
+static void WakeWorker( KExecutor* pExecutor )
+{
+  if ( KAtomicLoad32( &pExecutor->sleepers, KATOMIC_SEQ_CST ) ) {
+    KSemaPut( &pExecutor->wakeSema );
+  }
+}
+
+static void TaskDone( KTaskGroup* pGroup )
+{
+  if ( pGroup && KAtomicFetchSub32( &pGroup->pending, 1, KATOMIC_SEQ_CST ) == 1 ) {
+    //Taking the waiter out tells it the event will be set
+    KEvent* pWaiter = ( KEvent* )KAtomicExchangePtr( &pGroup->pWaiter, NULL, KATOMIC_SEQ_CST );
+    if ( pWaiter ) {
+      KEventSet( pWaiter, TASK_GROUP_DONE );
+    }
+  }
+}
+
+static KExecutorTask* AllocateTask( KExecutor* pExecutor, KTaskGroup* pGroup, KExecutorTaskFn fn, void* arg )
+{
+  KExecutorTask* retval = ( KExecutorTask* )PoolAlloc( &pExecutor->taskPool );
+  if ( retval ) {
+    retval->fn = fn;
+    retval->arg = arg;
+    retval->pGroup = pGroup;
+  }
+  return retval;
+}
+
+static void RunTask( KExecutorWorker* pWorker, KExecutorTask* pTask )
+{
+  KExecutorTaskFn fn = pTask->fn;
+  void* arg = pTask->arg;
+  KTaskGroup* pGroup = pTask->pGroup;
+
+  //Handed back first so that the tasks fn spawns can use it
+  PoolFree( &pWorker->pExecutor->taskPool, pTask );
+  fn( pWorker, arg );
+  TaskDone( pGroup );
+}
+
+static void InitWorker( KExecutor* pExecutor, const KExecutorDef* pDef, uint32_t index )
+{
+  KExecutorWorker* pWorker = &pExecutor->workers[ index ];
+  pWorker->pExecutor = pExecutor;
+  pWorker->pDeque = ( KAtomicPtr* )( pDef->pBackingStore + ( index * pDef->dequeDepth * sizeof( KAtomicPtr ) ) );
+  KAtomicStore32( &pWorker->top, 0, KATOMIC_RELAXED );
+  KAtomicStore32( &pWorker->bottom, 0, KATOMIC_RELAXED );
+  pWorker->index = index;
+  pWorker->stealSeed = 2654435761u * ( index + 1 );
+}
+
+static bool StartWorker( KExecutor* pExecutor, const KExecutorDef* pDef )
+{
+  KExecutorWorker* pWorker = &pExecutor->workers[ pExecutor->threadCount ];
+  uint8_t* pStack = ( pDef->pStack ) ? 
+    ( uint8_t* )pDef->pStack + ( pExecutor->threadCount * pDef->stackSize ) : NULL;
+  bool retval = false;
+  KTHREAD_CREATE_PARAMS( executorWorker, 
+                         pDef->pName, 
+                         WorkerThread, 
+                         pWorker,
+                         pStack,
+                         pDef->stackSize, 
+                         pDef->priority );
+  if ( KThreadCreate( &pWorker->thread, KTHREAD_PARAMS( executorWorker ) ) ) {
+    pExecutor->threadCount++;
+    retval = true;
+  }
+  return retval;
+}
+
+bool KExecutorCreate( KExecutor* pExecutor, const KExecutorDef* pDef )
+{
+  assert( pExecutor && pDef );
+  uint32_t workerCount = ( pDef->workerCount ) ? pDef->workerCount : KThreadGetCpuCount();
+  uint32_t dequeStoreSize = KEXECUTOR_WORKERS_MAX * pDef->dequeDepth * sizeof( KAtomicPtr );
+  uint32_t i = 0;
+  bool retval = false;
+
+  memset( pExecutor, 0, sizeof( KExecutor ) );
+  if ( workerCount > KEXECUTOR_WORKERS_MAX ) {
+    workerCount = KEXECUTOR_WORKERS_MAX;
+  }
+
+  if ( !pDef->dequeDepth || ( pDef->dequeDepth & ( pDef->dequeDepth - 1 ) ) ) {
+    EXECUTOR_LOG( "%s(): %s: deque depth %u is not a power of 2", __FUNCTION__, pDef->pName, pDef->dequeDepth );
+  }
+  else if ( !PoolCreate( &pExecutor->taskPool,
+                         pDef->pBackingStore + dequeStoreSize,
+                         POOL_STORE_SIZE( pDef->taskCount, sizeof( KExecutorTask ) ),
+                         pDef->taskCount ) ) {
+    EXECUTOR_LOG( "%s(): %s: Couldn't create task pool", __FUNCTION__, pDef->pName );
+  }
+  else if ( !KMutexCreate( &pExecutor->injectMutex, pDef->pName ) ) {
+    EXECUTOR_LOG( "%s(): %s: Couldn't create mutex", __FUNCTION__, pDef->pName );
+    PoolRelease( &pExecutor->taskPool );
+  }
+  else if ( !KSemaCreate( &pExecutor->wakeSema, pDef->pName, 0 ) ) {
+    EXECUTOR_LOG( "%s(): %s: Couldn't create semaphore", __FUNCTION__, pDef->pName );
+    KMutexDelete( &pExecutor->injectMutex );
+    PoolRelease( &pExecutor->taskPool );
+  }
+  else {
+    KQueueInit( &pExecutor->injectQueue );
+    pExecutor->dequeMask = pDef->dequeDepth - 1;
+    KAtomicStore32( &pExecutor->keepRunning, 1, KATOMIC_RELAXED );
+    pExecutor->isInitialized = true;
+    //Every worker is set up before any starts, they steal from one another
+    pExecutor->workerCount = workerCount;
+    for( i = 0; i < workerCount; i++ ) {
+      InitWorker( pExecutor, pDef, i );
+    }
+    retval = true;
+    while( retval && pExecutor->threadCount < workerCount ) {
+      if ( !StartWorker( pExecutor, pDef ) ) {
+        EXECUTOR_LOG( "%s(): %s: Couldn't create Worker %u", __FUNCTION__, pDef->pName, pExecutor->threadCount );
+        KExecutorDestroy( pExecutor );
+        retval = false;
+      }
+    }
+  }
+  return retval;
+}
+
+void KExecutorDestroy( KExecutor* pExecutor )
+{
+  uint32_t i = 0;
+  if ( pExecutor && pExecutor->isInitialized ) {
+    KAtomicStore32( &pExecutor->keepRunning, 0, KATOMIC_RELEASE );
+    for( i = 0; i < pExecutor->threadCount; i++ ) {
+      KSemaPut( &pExecutor->wakeSema );
+    }
+    for( i = 0; i < pExecutor->threadCount; i++ ) {
+      if ( !KThreadDelete( &pExecutor->workers[ i ].thread ) ) {
+        EXECUTOR_LOG( "%s(): Couldn't Delete Worker %u", __FUNCTION__, i );
+        assert( 0 );
+      }
+    }
+    pExecutor->threadCount = 0;
+    KSemaDelete( &pExecutor->wakeSema );
+    KMutexDelete( &pExecutor->injectMutex );
+    PoolRelease( &pExecutor->taskPool );
+    pExecutor->isInitialized = false;
+  }
+}
+
+uint32_t KExecutorGetWorkerCount( KExecutor* pExecutor )
+{
+  return pExecutor->workerCount;
+}
+
+bool KExecutorSubmit( KExecutor* pExecutor, KTaskGroup* pGroup, KExecutorTaskFn fn, void* arg )
+{
+  assert( pExecutor && fn );
+  KExecutorTask* pTask = AllocateTask( pExecutor, pGroup, fn, arg );
+  bool retval = false;
+  if ( pTask ) {
+    if ( pGroup ) {
+      KAtomicFetchAdd32( &pGroup->pending, 1, KATOMIC_RELAXED );
+    }
+    KMutexLock( &pExecutor->injectMutex, WAIT_FOREVER );
+    KQueueInsert( &pExecutor->injectQueue, &pTask->listElem );
+    KMutexUnlock( &pExecutor->injectMutex );
+    KAtomicFetchAdd32( &pExecutor->injectCount, 1, KATOMIC_SEQ_CST );
+    WakeWorker( pExecutor );
+    retval = true;
+  }
+  return retval;
+}
+
+void KExecutorSpawn( KExecutorWorker* pWorker, KTaskGroup* pGroup, KExecutorTaskFn fn, void* arg )
+{
+  assert( pWorker && fn );
+  KExecutorTask* pTask = AllocateTask( pWorker->pExecutor, pGroup, fn, arg );
+  if ( pGroup ) {
+    KAtomicFetchAdd32( &pGroup->pending, 1, KATOMIC_RELAXED );
+  }
+  if ( pTask && DequePush( pWorker, pTask ) ) {
+    WakeWorker( pWorker->pExecutor );
+  }
+  else if ( pTask ) {
+    RunTask( pWorker, pTask );
+  }
+  else {
+    fn( pWorker, arg );
+    TaskDone( pGroup );
+  }
+}
+
+void KExecutorJoin( KExecutorWorker* pWorker, KTaskGroup* pGroup )
+{
+  assert( pWorker && pGroup );
+  KExecutorTask* pTask = NULL;
+  uint32_t idle = 0;
+  while( KAtomicLoad32( &pGroup->pending, KATOMIC_ACQUIRE ) ) {
+    pTask = FindTask( pWorker );
+    if ( pTask ) {
+      RunTask( pWorker, pTask );
+      idle = 0;
+    }
+    else if ( ++idle < EXECUTOR_JOIN_SPINS ) {
+      KCPU_RELAX();
+    }
+    else {
+      //The rest of the group is running on other workers
+      KThreadYield();
+    }
+  }
+}
+
+bool KTaskGroupInit( KTaskGroup* pGroup )
+{
+  assert( pGroup );
+  KAtomicStore32( &pGroup->pending, 0, KATOMIC_RELAXED );
+  KAtomicStorePtr( &pGroup->pWaiter, NULL, KATOMIC_RELAXED );
+  return true;
+}
+
+void KTaskGroupDestroy( KTaskGroup* pGroup )
+{
+  assert( pGroup && !KAtomicLoad32( &pGroup->pending, KATOMIC_RELAXED ) );
+}
+
+/**
+ * The event lives on the stack of the waiter, so it is only 
+ * deleted once it is known whether the last task took it. 
+ */
+void KTaskGroupWait( KTaskGroup* pGroup )
+{
+  assert( pGroup );
+  KEvent done;
+  if ( KAtomicLoad32( &pGroup->pending, KATOMIC_ACQUIRE ) &&
+       KEventCreate( &done, "KTaskGroupWait" ) ) {
+    while( KAtomicLoad32( &pGroup->pending, KATOMIC_SEQ_CST ) ) {
+      KAtomicStorePtr( &pGroup->pWaiter, &done, KATOMIC_SEQ_CST );
+      if ( KAtomicLoad32( &pGroup->pending, KATOMIC_SEQ_CST ) ||
+           !KAtomicExchangePtr( &pGroup->pWaiter, NULL, KATOMIC_SEQ_CST ) ) {
+        KEventWait( &done, TASK_GROUP_DONE, KEVENT_WAIT_ANY | KEVENT_CLEAR_ON_EXIT, WAIT_FOREVER );
+      }
+    }
+    KEventDelete( &done );
+  }
+}
+
+static void WorkerThread( void* arg )
+{
+  KExecutorWorker* pWorker = ( KExecutorWorker* )arg;
+  KExecutor* pExecutor = pWorker->pExecutor;
+  KExecutorTask* pTask = NULL;
+
+  while( KAtomicLoad32( &pExecutor->keepRunning, KATOMIC_ACQUIRE ) ) {
+    pTask = FindTask( pWorker );
+    if ( !pTask ) {
+      KAtomicFetchAdd32( &pExecutor->sleepers, 1, KATOMIC_SEQ_CST );
+      //Tasks pushed before this worker was counted as a sleeper did not wake anyone
+      pTask = FindTask( pWorker );
+      if ( !pTask && KAtomicLoad32( &pExecutor->keepRunning, KATOMIC_ACQUIRE ) ) {
+        KSemaGet( &pExecutor->wakeSema, WAIT_FOREVER );
+      }
+      KAtomicFetchSub32( &pExecutor->sleepers, 1, KATOMIC_SEQ_CST );
+    }
+    if ( pTask ) {
+      RunTask( pWorker, pTask );
+    }
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,120 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __EXECUTOR_IMPL_H__
+#define __EXECUTOR_IMPL_H__
+
+#include <ThreadInterface.h>
+#include <MutexInterface.h>
+#include <SemaphoreInterface.h>
+#include <AtomicInterface.h>
+#include <Pool.h>
+#include <klist.h>
+#include <AbstractUtilsConfig.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct _KExecutorWorker;
+
+/**
+ * A task. Runs on one of the workers of the executor, pWorker
+ * can be used to spawn and join further tasks from within the
+ * task.
+ */
+typedef void (*KExecutorTaskFn)( struct _KExecutorWorker* pWorker, void* arg );
+
+/**
+ * @struct KTaskGroup - Counts the tasks submitted against it
+ *         that have not completed yet, so that they can be
+ *         waited on as a whole. Holds no OS object, forking a
+ *         group costs nothing but the counter.
+ */
+typedef struct _KTaskGroup
+{
+  KAtomicU32 pending;
+  KAtomicPtr pWaiter;       /**< KEvent of the thread in KTaskGroupWait(), set by the task that completes the group */
+}KTaskGroup;
+
+typedef struct _KExecutorTask
+{
+  KListElem listElem;       /**< Links the task into the injection queue */
+  KExecutorTaskFn fn;
+  void* arg;
+  KTaskGroup* pGroup;
+}KExecutorTask;
+
+/**
+ * @struct KExecutorWorker - A worker thread and its Chase-Lev
+ *         deque. Only the worker pushes and takes at the bottom
+ *         of its deque, other workers steal from the top.
+ */
+typedef struct _KExecutorWorker
+{
+  struct _KExecutor* pExecutor;
+  KThread thread;
+  KAtomicPtr* pDeque;               /**< dequeMask + 1 slots of KExecutorTask* */
+  KAtomicU32 top;
+  KAtomicU32 bottom;
+  uint32_t index;
+  uint32_t stealSeed;
+}KExecutorWorker;
+
+typedef struct _KExecutor
+{
+  KExecutorWorker workers[ KEXECUTOR_WORKERS_MAX ];
+  uint32_t workerCount;
+  uint32_t threadCount;             /**< Workers whose thread has been started */
+  uint32_t dequeMask;
+  MemPool taskPool;
+  KMutex injectMutex;
+  KQueue injectQueue;               /**< Tasks submitted from outside the executor */
+  KAtomicU32 injectCount;           /**< Lets workers skip the mutex while injectQueue is empty */
+  KSema wakeSema;
+  KAtomicU32 sleepers;              /**< Workers that are, or are about to, block on wakeSema */
+  KAtomicU32 keepRunning;
+  bool isInitialized;
+}KExecutor;
+
+/**
+ * Backing store needed for an executor whose workers each have
+ * a deque of dequeDepth tasks and that can have taskCount tasks
+ * in flight. It is sized for KEXECUTOR_WORKERS_MAX workers.
+ */
+#define KEXECUTOR_BACKING_STORE_SIZE( dequeDepth, taskCount )\
+  ( ( KEXECUTOR_WORKERS_MAX * ( dequeDepth ) * sizeof( KAtomicPtr ) ) +\
+    POOL_STORE_SIZE( ( taskCount ), sizeof( KExecutorTask ) ) )
+
+#define KEXECUTOR_DEF( name, dequeDepth, taskCount )\
+  uint8_t kExecutorStore_##name[ KEXECUTOR_BACKING_STORE_SIZE( dequeDepth, taskCount ) ];\
+  KExecutor kExecutor_##name
+
+#define KEXECUTOR( name ) kExecutor_##name
+#define KEXECUTOR_STORE( name ) kExecutorStore_##name
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EXECUTOR_IMPL_H__
@@ -0,0 +1,71 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __MESSAGE_COROUTINE_IMPL_H__
+#define __MESSAGE_COROUTINE_IMPL_H__
+
+#include "MessageThreadImpl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+  MESSAGE_CO_WAITING = 0,   /**< Suspended on an await, resumed by the message thread */
+  MESSAGE_CO_DONE,          /**< Ran to MESSAGE_CO_END() */
+}MessageCoStatus;
+
+struct _MessageCoroutine;
+
+/**
+ * Body of a coroutine, written between MESSAGE_CO_BEGIN() and 
+ * MESSAGE_CO_END(). Called again from the top every time the 
+ * coroutine is resumed. 
+ */
+typedef MessageCoStatus (*MessageCoroutineFn)( struct _MessageCoroutine* pCo, void* pArg );
+
+/**
+ * @struct MessageCoroutine - A stackless coroutine run by a 
+ *         message thread. The coroutine is its own wake up 
+ *         message, it is queued on ( or armed for ) its thread
+ *         without allocating anything. 
+ */
+typedef struct _MessageCoroutine
+{
+  MessageHeader header;           /**< Must be first */
+  uint32_t resumeLine;            /**< Line MESSAGE_CO_BEGIN() jumps to, 0 to start over */
+  MessageCoroutineFn fn;
+  void* pArg;
+  const void* pThread;            /**< Message thread running the coroutine */
+  void* hReply;                   /**< Message handed back by MESSAGE_CO_AWAIT_CALL() */
+  struct _MessageCoroutine* pNext;      /**< Coroutines running on the same thread */
+  struct _MessageCoroutine* pPrev;
+  struct _MessageCoroutine* pNextWake;  /**< Wake ups that didn't fit in the message Q */
+}MessageCoroutine;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MESSAGE_COROUTINE_IMPL_H__
@@ -23,13 +23,175 @@
  */
 
 #include <MessageQueue.h>
+#include <TimeInterface.h>
 #include <ConsoleLog.h>
 #include <assert.h>
+#include <string.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define INDEX_SLOT_EMPTY        ( 0xFFFFFFFF )
+
+static uint32_t IndexHash( MessageQueue* pQueue, uint32_t key )
+{
+  return ( key * 2654435761u ) % pQueue->indexSize;
+}
+
+static uint32_t IndexFind( MessageQueue* pQueue, uint32_t key )
+{
+  uint32_t i = IndexHash( pQueue, key );
+  while( pQueue->pIndex[ i ].slot != INDEX_SLOT_EMPTY ) {
+    if ( pQueue->pIndex[ i ].key == key ) {
+      return i;
+    }
+    i = ( i + 1 ) % pQueue->indexSize;
+  }
+  return pQueue->indexSize;
+}
+
+static void IndexInsert( MessageQueue* pQueue, uint32_t key, uint32_t slot )
+{
+  uint32_t i = IndexHash( pQueue, key );
+  while( pQueue->pIndex[ i ].slot != INDEX_SLOT_EMPTY ) {
+    i = ( i + 1 ) % pQueue->indexSize;
+  }
+  pQueue->pIndex[ i ].key = key;
+  pQueue->pIndex[ i ].slot = slot;
+}
+
+/**
+ * Removes entry i using backward shift deletion, so that no
+ * tombstones are needed and lookups never degrade.
+ */
+static void IndexRemove( MessageQueue* pQueue, uint32_t i )
+{
+  uint32_t j = i;
+  for( ;; ) {
+    uint32_t home;
+    j = ( j + 1 ) % pQueue->indexSize;
+    if ( pQueue->pIndex[ j ].slot == INDEX_SLOT_EMPTY ) {
+      break;
+    }
+    home = IndexHash( pQueue, pQueue->pIndex[ j ].key );
+    //Move j into the hole at i unless its home lies cyclically in ( i, j ]
+    if ( ( i <= j ) ? ( ( i < home ) && ( home <= j ) ) : ( ( i < home ) || ( home <= j ) ) ) {
+      continue;
+    }
+    pQueue->pIndex[ i ] = pQueue->pIndex[ j ];
+    i = j;
+  }
+  pQueue->pIndex[ i ].slot = INDEX_SLOT_EMPTY;
+}
+
+/**
+ * Must be called with the queue mutex held. Returns true if
+ * pItem was folded into a pending item, in which case
+ * *ppDiscard holds the item that has to be discarded.
+ */
+static bool CoalesceLocked( MessageQueue* pQueue, void* pItem, void** ppDiscard )
+{
+  bool retval = false;
+  uint32_t key = 0;
+  if ( pQueue->pIndex && pQueue->fnKey( pQueue->pContext, pItem, &key ) ) {
+    uint32_t i = IndexFind( pQueue, key );
+    if ( i < pQueue->indexSize ) {
+      uint32_t slot = pQueue->pIndex[ i ].slot;
+      void* pPending = pQueue->arrayQueueOfItems[ slot ];
+      void* pKeep = ( pQueue->fnMerge ) ? pQueue->fnMerge( pQueue->pContext, pPending, pItem ) : pItem;
+      pQueue->arrayQueueOfItems[ slot ] = pKeep;
+      *ppDiscard = ( pKeep == pPending ) ? pItem : pPending;
+      retval = true;
+    }
+  }
+  return retval;
+}
+
+static void PushLocked( MessageQueue* pQueue, void* pItem )
+{
+  uint32_t key = 0;
+  if ( pQueue->pIndex && pQueue->fnKey( pQueue->pContext, pItem, &key ) ) {
+    IndexInsert( pQueue, key, pQueue->head );
+  }
+  pQueue->arrayQueueOfItems[ pQueue->head ] = pItem;
+  pQueue->head = ( pQueue->head + 1 ) % pQueue->size;
+}
+
+/**
+ * Must be called with the queue mutex held. Points the index
+ * entry of pItem, if it has one, from slot from to slot to.
+ * INDEX_SLOT_EMPTY as to removes the entry.
+ */
+static void IndexMoveLocked( MessageQueue* pQueue, void* pItem, uint32_t from, uint32_t to )
+{
+  uint32_t key = 0;
+  if ( pQueue->pIndex && pQueue->fnKey( pQueue->pContext, pItem, &key ) ) {
+    uint32_t i = IndexFind( pQueue, key );
+    if ( i < pQueue->indexSize && pQueue->pIndex[ i ].slot == from ) {
+      if ( to == INDEX_SLOT_EMPTY ) {
+        IndexRemove( pQueue, i );
+      } else {
+        pQueue->pIndex[ i ].slot = to;
+      }
+    }
+  }
+}
+
+/**
+ * Must be called with the queue mutex held. Takes the item in
+ * slot out of the queue, the items queued before it move up one
+ * slot to close the gap.
+ */
+static void* RemoveLocked( MessageQueue* pQueue, uint32_t slot )
+{
+  void* pItem = pQueue->arrayQueueOfItems[ slot ];
+  IndexMoveLocked( pQueue, pItem, slot, INDEX_SLOT_EMPTY );
+  while( slot != pQueue->tail ) {
+    uint32_t prev = ( slot + pQueue->size - 1 ) % pQueue->size;
+    pQueue->arrayQueueOfItems[ slot ] = pQueue->arrayQueueOfItems[ prev ];
+    IndexMoveLocked( pQueue, pQueue->arrayQueueOfItems[ slot ], prev, slot );
+    slot = prev;
+  }
+  pQueue->tail = ( pQueue->tail + 1 ) % pQueue->size;
+  return pItem;
+}
+
+static void* PopLocked( MessageQueue* pQueue )
+{
+  return RemoveLocked( pQueue, pQueue->tail );
+}
+
+/**
+ * Must be called with the queue mutex held and an item claimed
+ * from the empty sema, so the queue isn't empty. Returns the
+ * slot of the oldest item that may be dropped, the queue size
+ * if there is none.
+ */
+static uint32_t OldestEvictableLocked( MessageQueue* pQueue )
+{
+  uint32_t count = ( pQueue->head + pQueue->size - pQueue->tail ) % pQueue->size;
+  uint32_t slot = pQueue->tail;
+  uint32_t i = 0;
+  if ( count == 0 ) {
+    count = pQueue->size;
+  }
+  for( i = 0; i < count; i++ ) {
+    if ( !pQueue->fnEvictable || pQueue->fnEvictable( pQueue->pContext, pQueue->arrayQueueOfItems[ slot ] ) ) {
+      break;
+    }
+    slot = ( slot + 1 ) % pQueue->size;
+  }
+  return ( i < count ) ? slot : pQueue->size;
+}
+
+static void Discard( MessageQueue* pQueue, void* pItem )
+{
+  if ( pItem && pQueue->fnDiscard ) {
+    pQueue->fnDiscard( pQueue->pContext, pItem );
+  }
+}
+
 bool MessageQueueInitialize( MessageQueue* pQueue, void** pQueueStore, uint32_t queueSize )
 {
   bool retval = false;
@@ -40,6 +202,17 @@ bool MessageQueueInitialize( MessageQueue* pQueue, void** pQueueStore, uint32_t
       pQueue->arrayQueueOfItems = pQueueStore;
       pQueue->head = pQueue->tail = 0;
       pQueue->size = queueSize;   
+      pQueue->pIndex = 0;
+      pQueue->indexSize = 0;
+      pQueue->fnKey = 0;
+      pQueue->fnMerge = 0;
+      pQueue->fnDiscard = 0;
+      pQueue->fnEvictable = 0;
+      pQueue->pContext = 0;
+      pQueue->overflowPolicy = MESSAGE_QUEUE_OVERFLOW_BLOCK;
+      pQueue->overflowTimeout = 0;
+      pQueue->spinUs = 0;
+      memset( &pQueue->stats, 0, sizeof( pQueue->stats ) );
       pQueue->isInitialized = true;
       retval = true;
     }
@@ -47,6 +220,76 @@ bool MessageQueueInitialize( MessageQueue* pQueue, void** pQueueStore, uint32_t
   return retval;
 }
 
+bool MessageQueueInitializeCoalescing( MessageQueue* pQueue,
+                                       void** pQueueStore,
+                                       uint32_t queueSize,
+                                       MessageQueueIndexEntry* pIndexStore,
+                                       MessageQueueKey fnKey,
+                                       MessageQueueMerge fnMerge )
+{
+  bool retval = false;
+  if ( pIndexStore && fnKey ) {
+    if ( MessageQueueInitialize( pQueue, pQueueStore, queueSize ) ) {
+      uint32_t i = 0;
+      pQueue->pIndex = pIndexStore;
+      pQueue->indexSize = MESSAGE_QUEUE_INDEX_SIZE( queueSize );
+      for( i = 0; i < pQueue->indexSize; i++ ) {
+        pQueue->pIndex[ i ].slot = INDEX_SLOT_EMPTY;
+      }
+      pQueue->fnKey = fnKey;
+      pQueue->fnMerge = fnMerge;
+      retval = true;
+    }
+  }
+  return retval;
+}
+
+void MessageQueueSetDiscardHandler( MessageQueue* pQueue, MessageQueueDiscard fnDiscard )
+{
+  if ( pQueue ) {
+    pQueue->fnDiscard = fnDiscard;
+  }
+}
+
+void MessageQueueSetEvictFilter( MessageQueue* pQueue, MessageQueueEvictable fnEvictable )
+{
+  if ( pQueue ) {
+    pQueue->fnEvictable = fnEvictable;
+  }
+}
+
+void MessageQueueSetContext( MessageQueue* pQueue, void* pContext )
+{
+  if ( pQueue ) {
+    pQueue->pContext = pContext;
+  }
+}
+
+void MessageQueueSetOverflowPolicy( MessageQueue* pQueue, MessageQueueOverflowPolicy policy, uint32_t timeout )
+{
+  if ( pQueue ) {
+    pQueue->overflowPolicy = policy;
+    pQueue->overflowTimeout = timeout;
+  }
+}
+
+void MessageQueueSetSpin( MessageQueue* pQueue, uint32_t spinUs )
+{
+  if ( pQueue ) {
+    pQueue->spinUs = spinUs;
+  }
+}
+
+void MessageQueueGetStats( MessageQueue* pQueue, MessageQueueStats* pStats )
+{
+  if ( pQueue && pQueue->isInitialized && pStats ) {
+    if ( KMutexLock( &pQueue->mutex, WAIT_FOREVER ) ) {
+      *pStats = pQueue->stats;
+      KMutexUnlock( &pQueue->mutex );
+    }
+  }
+}
+
 void MessageQueueDeInitialize( MessageQueue* pQueue )
 {
   if ( pQueue ) {
@@ -55,6 +298,8 @@ void MessageQueueDeInitialize( MessageQueue* pQueue )
     KSemaDelete( &pQueue->emptySema );
     pQueue->arrayQueueOfItems = 0;
     pQueue->head = pQueue->tail = pQueue->size = 0;
+    pQueue->pIndex = 0;
+    pQueue->indexSize = 0;
     pQueue->isInitialized = false;
   }
 }
@@ -62,36 +307,202 @@ void MessageQueueDeInitialize( MessageQueue* pQueue )
 bool MessageQueueEnQueue( MessageQueue* pQueue, void *pItem )
 {
   bool retval = false;
+  if ( pQueue ) {
+    retval = MessageQueueEnQueueEx( pQueue, pItem, pQueue->overflowPolicy, pQueue->overflowTimeout );
+  }
+  return retval;
+}
+
+/**
+ * Where an enqueued item comes from. Either the item itself, or a
+ * produce callback that is only called once the queue is locked,
+ * see MessageQueueEnQueueFrom().
+ */
+typedef struct _EnQueueSource
+{
+  void* pItem;
+  MessageQueueProduce fnProduce;
+  void* pArg;
+  bool isProduced;          /**< pItem came from fnProduce, the producer can't get it back */
+}EnQueueSource;
+
+/**
+ * Must be called with the queue mutex held. Produces the item on
+ * the first call, NULL if the producer has nothing to enqueue.
+ */
+static void* SourceItemLocked( EnQueueSource* pSource )
+{
+  if ( !pSource->pItem && pSource->fnProduce ) {
+    pSource->pItem = pSource->fnProduce( pSource->pArg );
+    pSource->fnProduce = 0;
+    pSource->isProduced = true;
+  }
+  return pSource->pItem;
+}
+
+static bool EnQueueSourced( MessageQueue* pQueue,
+                            EnQueueSource* pSource,
+                            MessageQueueOverflowPolicy policy,
+                            uint32_t timeout )
+{
+  bool retval = false;
+  void* pDiscard = 0;
+  void* pItem = 0;
   if ( pQueue && pQueue->isInitialized ) {
-    if( KSemaGet ( &pQueue->fullSema, WAIT_FOREVER ) ) {
+    bool haveSlot = KSemaGet( &pQueue->fullSema, NO_SLEEP );
+    if ( !haveSlot ) {
+      //Queue is full, see if the overflow can be resolved without waiting
+      bool mustWait = false;
       if ( KMutexLock( &pQueue->mutex, WAIT_FOREVER ) ) {
-        KSemaPut( &pQueue->emptySema );
-        pQueue->arrayQueueOfItems[ pQueue->head ] = pItem;
-        pQueue->head = ( pQueue->head + 1 ) % pQueue->size;
+        //Only produce an item that can go in without a free slot
+        bool needItem = ( pQueue->pIndex || policy == MESSAGE_QUEUE_OVERFLOW_DROP_OLDEST );
+        pItem = ( needItem ) ? SourceItemLocked( pSource ) : pSource->pItem;
+        if ( !pItem && !pSource->fnProduce ) {
+          //The producer had nothing to enqueue
+        } else if ( pItem && CoalesceLocked( pQueue, pItem, &pDiscard ) ) {
+          pQueue->stats.coalesced++;
+          retval = true;
+        } else if ( policy == MESSAGE_QUEUE_OVERFLOW_DROP_NEWEST ) {
+          pQueue->stats.droppedNewest++;
+          pDiscard = pItem;
+          retval = true;
+        } else if ( policy == MESSAGE_QUEUE_OVERFLOW_DROP_OLDEST &&
+                    KSemaGet( &pQueue->emptySema, NO_SLEEP ) ) {
+          //Take over the slot of the oldest item that may go. If the empty sema wasn't 
+          //available the consumer has claimed every item and a slot will free up shortly.
+          uint32_t slot = OldestEvictableLocked( pQueue );
+          if ( slot < pQueue->size ) {
+            pQueue->stats.droppedOldest++;
+            pDiscard = RemoveLocked( pQueue, slot );
+            PushLocked( pQueue, pItem );
+          } else {
+            pQueue->stats.droppedNewest++;
+            pDiscard = pItem;
+          }
+          KSemaPut( &pQueue->emptySema );
+          retval = true;
+        } else if ( policy == MESSAGE_QUEUE_OVERFLOW_FAIL ) {
+          pQueue->stats.rejected++;
+          pDiscard = ( pSource->isProduced ) ? pItem : 0;
+        } else {
+          mustWait = true;
+        }
+        KMutexUnlock( &pQueue->mutex );
+      }
+      if ( mustWait ) {
+        uint32_t waitTime = ( policy == MESSAGE_QUEUE_OVERFLOW_BLOCK_DEADLINE ) ? timeout : WAIT_FOREVER;
+        haveSlot = KSemaGet( &pQueue->fullSema, waitTime );
+        if ( !haveSlot ) {
+          if ( waitTime == WAIT_FOREVER ) {
+            ConsoleLogLine( "%s(): Unable to Get Full Semaphore", __FUNCTION__ );
+          } else if ( KMutexLock( &pQueue->mutex, WAIT_FOREVER ) ) {
+            pQueue->stats.timedOut++;
+            KMutexUnlock( &pQueue->mutex );
+          }
+          pDiscard = ( pSource->isProduced ) ? pItem : 0;
+        }
+      }
+    }
+    if ( haveSlot ) {
+      if ( KMutexLock( &pQueue->mutex, WAIT_FOREVER ) ) {
+        pItem = SourceItemLocked( pSource );
+        if ( !pItem ) {
+          //Hand the slot back, the producer had nothing
+          KSemaPut( &pQueue->fullSema );
+        } else if ( CoalesceLocked( pQueue, pItem, &pDiscard ) ) {
+          pQueue->stats.coalesced++;
+          KSemaPut( &pQueue->fullSema );
+          retval = true;
+        } else {
+          KSemaPut( &pQueue->emptySema );
+          PushLocked( pQueue, pItem );
+          retval = true;
+        }
         KMutexUnlock( &pQueue->mutex );
-        retval = true;
       } else {
         ConsoleLogLine( "%s(): Could'n't Get Queue Mutex", __FUNCTION__ );
       }
     }
-    else {
-      ConsoleLogLine( "%s(): Unable to Get Full Semaphore", __FUNCTION__ );
-    }
+    Discard( pQueue, pDiscard );
   } else {
     ConsoleLogLine( "%s(): Invalid Queue( %p ) or not init", __FUNCTION__, pQueue );
   }
   return retval;
 }
 
+bool MessageQueueEnQueueEx( MessageQueue* pQueue,
+                            void *pItem,
+                            MessageQueueOverflowPolicy policy,
+                            uint32_t timeout )
+{
+  EnQueueSource source = { pItem, 0, 0, false };
+  return EnQueueSourced( pQueue, &source, policy, timeout );
+}
+
+bool MessageQueueEnQueueFrom( MessageQueue* pQueue, MessageQueueProduce fnProduce, void* pArg )
+{
+  bool retval = false;
+  EnQueueSource source = { 0, fnProduce, pArg, false };
+  if ( pQueue ) {
+    retval = EnQueueSourced( pQueue, &source, pQueue->overflowPolicy, pQueue->overflowTimeout );
+  }
+  return retval;
+}
+
+/**
+ * Polls for an item till spinUs runs out. The clock is only read
+ * every few iterations, a try get is a lot cheaper than a time
+ * read on most platforms.
+ */
+#define SPIN_ITERATIONS_PER_CLOCK_READ  ( 64 )
+static bool SpinForItem( MessageQueue* pQueue )
+{
+  bool retval = false;
+  uint64_t deadline = KTimeGetMicroseconds() + pQueue->spinUs;
+  uint32_t i = 0;
+  while( !retval ) {
+    retval = KSemaGet( &pQueue->emptySema, NO_SLEEP );
+    if ( !retval ) {
+      KCPU_RELAX();
+      if ( ( ++i % SPIN_ITERATIONS_PER_CLOCK_READ ) == 0 &&
+           KTimeGetMicroseconds() >= deadline ) {
+        break;
+      }
+    }
+  }
+  return retval;
+}
+
+typedef enum
+{
+  DEQUEUE_WAIT_NONE = 0,
+  DEQUEUE_WAIT_POLLED,
+  DEQUEUE_WAIT_BLOCKED,
+}DequeueWait;
+
 void* MessageQueueDeQueue( MessageQueue* pQueue )
 {
   void* retval = 0;
   if ( pQueue && pQueue->isInitialized ) {
-    if( KSemaGet( &pQueue->emptySema, WAIT_FOREVER ) ) {
+    DequeueWait wait = DEQUEUE_WAIT_NONE;
+    bool gotItem = KSemaGet( &pQueue->emptySema, NO_SLEEP );
+    if ( !gotItem && pQueue->spinUs ) {
+      gotItem = SpinForItem( pQueue );
+      wait = DEQUEUE_WAIT_POLLED;
+    }
+    if ( !gotItem ) {
+      gotItem = KSemaGet( &pQueue->emptySema, WAIT_FOREVER );
+      wait = DEQUEUE_WAIT_BLOCKED;
+    }
+    if( gotItem ) {
       if ( KMutexLock( &pQueue->mutex, WAIT_FOREVER ) ) {
+        if ( wait == DEQUEUE_WAIT_POLLED ) {
+          pQueue->stats.polled++;
+        } else if ( wait == DEQUEUE_WAIT_BLOCKED ) {
+          pQueue->stats.blocked++;
+        }
         KSemaPut( &pQueue->fullSema );
-        retval = pQueue->arrayQueueOfItems[ pQueue->tail ];
-        pQueue->tail = ( pQueue->tail + 1 ) % pQueue->size;
+        retval = PopLocked( pQueue );
         KMutexUnlock( &pQueue->mutex );
       } else {
         ConsoleLogLine( "%s(): Coulnd't Get Queue Mutex", __FUNCTION__ );
@@ -31,6 +31,82 @@
 extern "C" {
 #endif
 
+/**
+ * Used by a coalescing queue to find the key of an item. Return
+ * false if the item should never be coalesced (eg. control
+ * messages), it will then always be appended.
+ */
+typedef bool (*MessageQueueKey)( void* pContext, void* pItem, uint32_t* pKey );
+
+/**
+ * Called when an item is enqueued while an item with the same
+ * key is still pending. Returns the item that stays in the
+ * queue, the other one is discarded. When no merge function is
+ * provided the newer item replaces the pending one.
+ */
+typedef void* (*MessageQueueMerge)( void* pContext, void* pPending, void* pNew );
+
+/**
+ * Called for every item the queue drops on behalf of the
+ * producer, so that the owner can release it. Never called with
+ * the queue lock held.
+ */
+typedef void (*MessageQueueDiscard)( void* pContext, void* pItem );
+
+/**
+ * Tells MESSAGE_QUEUE_OVERFLOW_DROP_OLDEST if a pending item may
+ * be dropped. Return false for items that must be delivered
+ * (eg. control messages), the next oldest one is dropped
+ * instead. Called with the queue lock held.
+ */
+typedef bool (*MessageQueueEvictable)( void* pContext, void* pItem );
+
+/**
+ * Called by MessageQueueEnQueueFrom() with the queue lock held,
+ * once the queue has room for the item. Returns the item to
+ * enqueue, NULL if there is none.
+ */
+typedef void* (*MessageQueueProduce)( void* pArg );
+
+/**
+ * What MessageQueueEnQueue() does when the queue is full.
+ */
+typedef enum
+{
+  MESSAGE_QUEUE_OVERFLOW_BLOCK = 0,       /**< Block till a slot frees up ( default ) */
+  MESSAGE_QUEUE_OVERFLOW_FAIL,            /**< Fail right away, the item is left with the producer */
+  MESSAGE_QUEUE_OVERFLOW_DROP_NEWEST,     /**< Discard the item being enqueued */
+  MESSAGE_QUEUE_OVERFLOW_DROP_OLDEST,     /**< Discard the oldest queued item to make room ( overwrite ) */
+  MESSAGE_QUEUE_OVERFLOW_BLOCK_DEADLINE,  /**< Block for at most the overflow timeout, then fail */
+}MessageQueueOverflowPolicy;
+
+/**
+ * @struct MessageQueueStats - Counts of items that were not
+ *         simply appended to the queue, and of how consumers
+ *         waited for items.
+ */
+typedef struct _MessageQueueStats
+{
+  uint32_t coalesced;       /**< Items folded into a pending item with the same key */
+  uint32_t droppedNewest;   /**< Items discarded by MESSAGE_QUEUE_OVERFLOW_DROP_NEWEST */
+  uint32_t droppedOldest;   /**< Items discarded by MESSAGE_QUEUE_OVERFLOW_DROP_OLDEST */
+  uint32_t rejected;        /**< Enqueues failed by MESSAGE_QUEUE_OVERFLOW_FAIL */
+  uint32_t timedOut;        /**< Enqueues failed by MESSAGE_QUEUE_OVERFLOW_BLOCK_DEADLINE */
+  uint32_t polled;          /**< Dequeues that found their item while spinning on an empty queue */
+  uint32_t blocked;         /**< Dequeues that had to block for their item */
+}MessageQueueStats;
+
+/**
+ * @struct MessageQueueIndexEntry - One entry of the open
+ *         addressed key index of a coalescing queue. Maps a key
+ *         to the queue slot holding the pending item.
+ */
+typedef struct _MessageQueueIndexEntry
+{
+  uint32_t key;
+  uint32_t slot;
+}MessageQueueIndexEntry;
+
 typedef struct _MessageQueue
 {
   KMutex mutex;
@@ -39,6 +115,17 @@ typedef struct _MessageQueue
   void** arrayQueueOfItems;
   uint32_t head, tail, size;
   bool isInitialized;
+  MessageQueueIndexEntry* pIndex;   /**< Key index, only present on coalescing queues */
+  uint32_t indexSize;
+  MessageQueueKey fnKey;
+  MessageQueueMerge fnMerge;
+  MessageQueueDiscard fnDiscard;
+  MessageQueueEvictable fnEvictable;
+  void* pContext;                   /**< Passed to all the callbacks above */
+  MessageQueueOverflowPolicy overflowPolicy;
+  uint32_t overflowTimeout;         /**< In ms, used by MESSAGE_QUEUE_OVERFLOW_BLOCK_DEADLINE */
+  uint32_t spinUs;                  /**< How long a dequeue polls an empty queue before blocking */
+  MessageQueueStats stats;
 }MessageQueue;
 
 #define MESSAGE_QUEUE_STORE_OVERHEAD( queueSize ) ( sizeof( void* ) * ( queueSize ) )
@@ -49,6 +136,20 @@ typedef struct _MessageQueue
 #define MESSAGE_QUEUE( name ) msgQueue_##name
 #define MESSAGE_QUEUE_STORE( name ) msgQueueDataStore_##name
 
+/**
+ * The key index is kept at most half full so that probe
+ * sequences stay short.
+ */
+#define MESSAGE_QUEUE_INDEX_SIZE( queueSize )   ( 2 * ( queueSize ) )
+#define MESSAGE_QUEUE_INDEX_STORE_OVERHEAD( queueSize )\
+  ( sizeof( MessageQueueIndexEntry ) * MESSAGE_QUEUE_INDEX_SIZE( queueSize ) )
+#define MESSAGE_QUEUE_COALESCING_DEF( name, maxSize )  \
+  void* msgQueueDataStore_##name[ maxSize ];\
+  MessageQueueIndexEntry msgQueueIndexStore_##name[ MESSAGE_QUEUE_INDEX_SIZE( maxSize ) ];\
+  MessageQueue msgQueue_##name
+
+#define MESSAGE_QUEUE_INDEX_STORE( name ) msgQueueIndexStore_##name
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,52 +22,650 @@
  * THE SOFTWARE.
  */
 #include <MessageThread.h>
+#include <MessageCoroutine.h>
 #include <assert.h>
 #include <ConsoleLog.h>
 #include <Pool.h>
 #include <MessageQueue.h>
 #include <ThreadInterface.h>
 #include <SemaphoreInterface.h>
+#include <MutexInterface.h>
+#include <TimeInterface.h>
+#include <TimerWheel.h>
+#include <AbstractUtilsConfig.h>
+#include <string.h>
+#include <stdio.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * Profile of a single worker, only written by that worker so 
+ * that the hot path takes no lock. The counters are atomics 
+ * since MessageThreadGetStats() reads them from other threads. 
+ */
+typedef struct _MessageWorkerStats
+{
+  KAtomicU64 processed;
+  KAtomicU64 busyUs;
+  KAtomicU64 idleUs;
+  KAtomicU64 idleSinceUs;         /**< Start of the current wait on the Q, 0 while busy */
+  KAtomicU32 maxProcessUs;
+  KAtomicU32 histogram[ MESSAGE_THREAD_STATS_BUCKETS ];
+  KAtomicU32 queueOverruns;
+  KAtomicU32 processOverruns;
+  KAtomicU64 busySinceUs;         /**< Start of the current fnProcess call, 0 while idle */
+  KAtomicPtr pCurrent;            /**< Message being processed */
+  KAtomicU32 messageSeq;          /**< Bumped for every message, tells the watchdog calls apart */
+  uint32_t stuckSeq;              /**< Last call reported stuck, only used by the watchdog */
+  KAtomicU32 stuck;               /**< Only written by the watchdog */
+}MessageWorkerStats;
+
 typedef struct _MessageThread
 {
   const char *threadName;
-  KThread threadHandle;
+  KThread workers[ MESSAGE_THREAD_WORKERS_MAX ];
+  uint32_t workerCount;     /**< Workers started, they all drain messageQ */
+  MessageWorkerStats workerStats[ MESSAGE_THREAD_WORKERS_MAX ];
+  KAtomicU32 statsClaimed;          /**< Workers claim their workerStats entry in the order they start */
+  uint64_t createdUs;
+  uint32_t processBudgetUs;
+  uint32_t queueBudgetUs;
   void* pPrivateData;
-  bool keepRunning;
+  KAtomicU32 keepRunning;   /**< Cleared once the thread is being destroyed */
   MessageThreadInit fnInit;
   MessageThreadProcess fnProcess;
+  MessageThreadMessageKey fnMessageKey;
+  MessageThreadMessageMerge fnMessageMerge;
   MemPool pool;
   MessageQueue messageQ;
   uint32_t messageSize;
+  uint32_t slotSize;        /**< Size of a pool unit, the message and its MessageHeader */
   KSema sema; 
+  MessageCoroutine* pCoroutines;              /**< Coroutines started on the thread and not done yet */
+  MessageCoroutine* pWakeBacklog;             /**< Coroutine wake ups that found the Q full */
+  KAtomicU32 hasWakeBacklog;                  /**< Lets workers skip the mutex while pWakeBacklog is empty */
 }MessageThread;
 
 typedef struct _MessageThreadPool
 {
   uint8_t threadStore[ POOL_STORE_SIZE( MESSAGE_THREADS_MAX, sizeof( MessageThread ) ) ];
   MemPool threadPool;
+  KMutex liveMutex;
+  MessageThread* pLive[ MESSAGE_THREADS_MAX ];  /**< Threads visited by MessageThreadForEach() */
 }MessageThreadPool;
 
 static MessageThreadPool s_threadPool;
 
+/**
+ * Services the delayed and periodic posts of all the message 
+ * threads. A single thread sleeps till the next expiry of the 
+ * wheel, the wheel and the timer state of every message are 
+ * protected by the mutex. 
+ */
+typedef struct _MessageTimerService
+{
+  KThread thread;
+  KMutex mutex;
+  KSema wakeSema;
+  TimerWheel wheel;
+  uint64_t wakeTick;        /**< Tick the service thread is sleeping till */
+}MessageTimerService;
+
+static MessageTimerService s_timerService;
+static uint8_t s_timerServiceStack[ MESSAGE_TIMER_THREAD_STACK_SIZE ];
+
+/**
+ * Keeps the latency budget overruns of all the message threads. 
+ * Workers record the overruns they see in the ring, the low 
+ * priority watchdog thread hands them to the callback and looks 
+ * for handlers that are stuck past their budget. 
+ */
+typedef struct _MessageWatchdog
+{
+  KThread thread;
+  KMutex mutex;             /**< Protects everything below */
+  KSema wakeSema;
+  MessageLatencyEvent ring[ MESSAGE_LATENCY_RING_SIZE ];
+  uint32_t written;         /**< Events ever recorded, the ring holds the latest ones */
+  uint32_t dispatched;      /**< Events handed to fnCallback */
+  MessageLatencyCallback fnCallback;
+  void* pCallbackContext;
+}MessageWatchdog;
+
+static MessageWatchdog s_watchdog;
+static uint8_t s_watchdogStack[ MESSAGE_WATCHDOG_THREAD_STACK_SIZE ];
+
+typedef enum
+{
+  MESSAGE_CALL_PENDING = 0,
+  MESSAGE_CALL_DONE,        /**< Processed, the caller owns the message again */
+  MESSAGE_CALL_DROPPED,     /**< Destroyed without being processed */
+  MESSAGE_CALL_ABANDONED,   /**< The caller timed out, the thread releases the message and the slot */
+}MessageCallState;
+
+/**
+ * What a MessageThreadCall() waits on. The semaphores are 
+ * created once by MessageThreadSystemInit() and reused, a call 
+ * only takes a slot from the pool. 
+ */
+typedef struct _MessageCallSlot
+{
+  KSema sema;
+  KAtomicU32 state;
+  MessageCoroutine* pCo;    /**< Set when a coroutine awaits the call, it is woken up instead of sema */
+}MessageCallSlot;
+
+typedef struct _MessageCallSlotPool
+{
+  uint8_t slotStore[ POOL_STORE_SIZE( MESSAGE_THREAD_CALL_SLOTS_MAX, sizeof( MessageCallSlot ) ) ];
+  MemPool slotPool;
+}MessageCallSlotPool;
+
+static MessageCallSlotPool s_callSlots;
+
+/**
+ * Protects the coroutine lists of all the message threads. Only 
+ * taken when a coroutine starts, finishes or finds its Q full. 
+ */
+static KMutex s_coroutineMutex;
+
+/**
+ * Queued to make a worker look at the wake up backlog. Like the 
+ * DIE message it isn't a real message. 
+ */
+#define WAKE_NUDGE( pThread )     ( ( void* )&( pThread )->hasWakeBacklog )
+
 #define MSG_POOL_LOG( str, ... )      ConsoleLogLine( str, ##__VA_ARGS__ )
 #define MT_LOG( str, ... )  ConsoleLogLine( str, ##__VA_ARGS__ )
 
 static void Thread( void *arg );
+static void Worker( void *arg );
+static void MessageThreadInternalDestroy( MessageThread* pThread );
 
-void MessageThreadSystemInit( void )
+/**
+ * Tags the header of a coroutine queued as its own wake up. 
+ * Never called, coroutine wake ups are always enqueued with 
+ * MESSAGE_QUEUE_OVERFLOW_FAIL and so never dropped. 
+ */
+static void CoroutineWakeRelease( void* hMessage )
+{
+  MT_LOG( "%s(): Coroutine wake up dropped", __FUNCTION__ );
+  assert( 0 );
+}
+
+#define IS_COROUTINE_WAKE( pHeader )    ( ( pHeader )->fnRelease == CoroutineWakeRelease )
+
+/**
+ * The thread DIE message, the wake nudge and coroutine wake ups 
+ * drive the thread itself, they are never coalesced or dropped. 
+ */
+static bool IsControlMessage( MessageThread* pThread, void* pItem )
+{
+  return ( pItem == &pThread->keepRunning ||
+           pItem == WAKE_NUDGE( pThread ) ||
+           IS_COROUTINE_WAKE( MESSAGE_HEADER( pItem ) ) );
+}
+
+static bool MessageKey( void* pContext, void* pItem, uint32_t* pKey )
+{
+  MessageThread *pThread = ( MessageThread* )pContext;
+  bool retval = false;
+  if ( !IsControlMessage( pThread, pItem ) ) {
+    retval = pThread->fnMessageKey( pItem, pKey );
+  }
+  return retval;
+}
+
+static bool MessageEvictable( void* pContext, void* pItem )
+{
+  return !IsControlMessage( ( MessageThread* )pContext, pItem );
+}
+
+static void* MessageMerge( void* pContext, void* pPending, void* pNew )
+{
+  MessageThread *pThread = ( MessageThread* )pContext;
+  return pThread->fnMessageMerge( pPending, pNew );
+}
+
+static void MessageDiscard( void* pContext, void* pItem )
+{
+  MessageThreadDestroyMessage( pContext, &pItem );
+}
+
+static uint64_t TimerNow( void )
+{
+  return KTimeGetMicroseconds() / MESSAGE_TIMER_TICK_US;
+}
+
+static uint64_t TimerUsToTicks( uint32_t timeUs )
+{
+  return ( ( uint64_t )timeUs + MESSAGE_TIMER_TICK_US - 1 ) / MESSAGE_TIMER_TICK_US;
+}
+
+static void TimerExpired( void* pContext, TimerWheelEntry* pEntry )
+{
+  MessageHeader* pHeader = ( MessageHeader* )pEntry;
+  MessageThread* pThread = ( MessageThread* )pHeader->pOwner;
+  //The timer service must never block on a full Q. Only the drop policies are honoured, coroutines are never dropped.
+  MessageQueueOverflowPolicy policy = pThread->messageQ.overflowPolicy;
+  if ( ( policy != MESSAGE_QUEUE_OVERFLOW_DROP_NEWEST && policy != MESSAGE_QUEUE_OVERFLOW_DROP_OLDEST ) ||
+       IS_COROUTINE_WAKE( pHeader ) ) {
+    policy = MESSAGE_QUEUE_OVERFLOW_FAIL;
+  }
+  if ( pHeader->period ) {
+    //The armed message is a template, each period posts a copy of it
+    MessageHeader* pCopy = ( MessageHeader* )PoolAlloc( &pThread->pool );
+    if ( pCopy ) {
+      memcpy( pCopy, pHeader, pThread->slotSize );
+      TimerWheelEntryInit( &pCopy->timer );
+      pCopy->period = 0;
+      pCopy->postedUs = ( pThread->queueBudgetUs ) ? KTimeGetMicroseconds() : 0;
+      if ( !MessageQueueEnQueueEx( &pThread->messageQ, MESSAGE_PAYLOAD( pCopy ), policy, NO_SLEEP ) ) {
+        PoolFree( &pThread->pool, pCopy );
+      }
+    }
+    else {
+      MT_LOG( "%s(): %s has no free message, skipping period", __FUNCTION__, pThread->threadName );
+    }
+    TimerWheelAdd( &s_timerService.wheel, pEntry, pHeader->period );
+  }
+  else {
+    if ( pThread->queueBudgetUs ) {
+      pHeader->postedUs = KTimeGetMicroseconds();
+    }
+    if ( !MessageQueueEnQueueEx( &pThread->messageQ, MESSAGE_PAYLOAD( pHeader ), policy, NO_SLEEP ) ) {
+      //Q is full, try again on the next tick
+      TimerWheelAdd( &s_timerService.wheel, pEntry, 1 );
+    }
+  }
+}
+
+static void TimerServiceThread( void* arg )
+{
+  for( ; ; ) {
+    uint32_t timeout = WAIT_FOREVER;
+    if ( KMutexLock( &s_timerService.mutex, WAIT_FOREVER ) ) {
+      uint64_t ticks = 0;
+      TimerWheelAdvance( &s_timerService.wheel, TimerNow(), TimerExpired, NULL );
+      ticks = TimerWheelTicksToNextExpiry( &s_timerService.wheel );
+      if ( ticks != TIMER_WHEEL_NO_EXPIRY ) {
+        uint64_t timeoutMs = ( ticks * MESSAGE_TIMER_TICK_US + 999 ) / 1000;
+        s_timerService.wakeTick = s_timerService.wheel.now + ticks;
+        timeout = ( timeoutMs < WAIT_FOREVER ) ? ( uint32_t )timeoutMs : WAIT_FOREVER - 1;
+      }
+      else {
+        s_timerService.wakeTick = TIMER_WHEEL_NO_EXPIRY;
+      }
+      KMutexUnlock( &s_timerService.mutex );
+    }
+    KSemaGet( &s_timerService.wakeSema, timeout );
+  }
+}
+
+static void TimerServiceInit( void )
+{
+  bool created = false;
+  TimerWheelInit( &s_timerService.wheel, TimerNow() );
+  s_timerService.wakeTick = TIMER_WHEEL_NO_EXPIRY;
+  if ( KMutexCreate( &s_timerService.mutex, "MessageTimerMutex" ) ) {
+    if ( KSemaCreate( &s_timerService.wakeSema, "MessageTimerSema", 0 ) ) {
+      KTHREAD_CREATE_PARAMS( timerService,
+                             "MessageTimer",
+                             TimerServiceThread,
+                             NULL,
+                             s_timerServiceStack,
+                             sizeof( s_timerServiceStack ),
+                             MESSAGE_TIMER_THREAD_PRIORITY );
+      created = KThreadCreate( &s_timerService.thread, KTHREAD_PARAMS( timerService ) );
+      if ( !created ) {
+        KSemaDelete( &s_timerService.wakeSema );
+        KMutexDelete( &s_timerService.mutex );
+      }
+    }
+    else {
+      KMutexDelete( &s_timerService.mutex );
+    }
+  }
+  if ( !created ) {
+    MT_LOG( "%s(): Couldn't start the message timer service", __FUNCTION__ );
+    assert( 0 );
+  }
+}
+
+static bool TimerArm( MessageThread* pThread, MessageHandle hMessage, uint32_t delayUs, uint32_t periodUs )
+{
+  bool retval = false;
+  bool wake = false;
+  MessageHeader* pHeader = MESSAGE_HEADER( hMessage );
+  if ( KMutexLock( &s_timerService.mutex, WAIT_FOREVER ) ) {
+    //Shared messages can't be armed, their owner is the topic
+    if ( !TimerWheelIsArmed( &pHeader->timer ) && 
+         ( !pHeader->fnRelease || IS_COROUTINE_WAKE( pHeader ) ) ) {
+      //The wheel only moves when the service thread wakes up, count from the actual time
+      uint64_t ticks = TimerUsToTicks( delayUs ) + ( TimerNow() - s_timerService.wheel.now );
+      pHeader->pOwner = pThread;
+      pHeader->period = TimerUsToTicks( periodUs );
+      TimerWheelAdd( &s_timerService.wheel, &pHeader->timer, ticks );
+      if ( pHeader->timer.expiry < s_timerService.wakeTick ) {
+        s_timerService.wakeTick = pHeader->timer.expiry;
+        wake = true;
+      }
+      retval = true;
+    }
+    KMutexUnlock( &s_timerService.mutex );
+  }
+  if ( wake ) {
+    KSemaPut( &s_timerService.wakeSema );
+  }
+  return retval;
+}
+
+static void TimerCancelAll( MessageThread* pThread )
+{
+  if ( KMutexLock( &s_timerService.mutex, WAIT_FOREVER ) ) {
+    uint32_t i = 0;
+    MessageCoroutine* pCo = NULL;
+    for( i = 0; i < pThread->pool.numOfUnits; i++ ) {
+      MessageHeader* pHeader = ( MessageHeader* )( pThread->pool.pBackingStore + ( i * pThread->slotSize ) );
+      if ( pHeader->pOwner == pThread ) {
+        TimerWheelRemove( &s_timerService.wheel, &pHeader->timer );
+      }
+    }
+    //Coroutines that never finished may still be sleeping
+    if ( KMutexLock( &s_coroutineMutex, WAIT_FOREVER ) ) {
+      for( pCo = pThread->pCoroutines; pCo; pCo = pCo->pNext ) {
+        TimerWheelRemove( &s_timerService.wheel, &pCo->header.timer );
+      }
+      pThread->pCoroutines = NULL;
+      KMutexUnlock( &s_coroutineMutex );
+    }
+    KMutexUnlock( &s_timerService.mutex );
+  }
+}
+
+static void CallSlotsInit( void )
 {
-  if ( !PoolCreate( &s_threadPool.threadPool,
-                    s_threadPool.threadStore,
-                    sizeof(s_threadPool.threadStore ),
-                    MESSAGE_THREADS_MAX ) ) {
+  uint32_t i = 0;
+  char semaName[ 32 ];
+  if ( !PoolCreate( &s_callSlots.slotPool,
+                    s_callSlots.slotStore,
+                    sizeof( s_callSlots.slotStore ),
+                    MESSAGE_THREAD_CALL_SLOTS_MAX ) ) {
     assert( 0 );
   }
+  for( i = 0; i < MESSAGE_THREAD_CALL_SLOTS_MAX; i++ ) {
+    MessageCallSlot* pSlot = ( MessageCallSlot* )s_callSlots.slotStore + i;
+    snprintf( semaName, sizeof( semaName ), "MessageCall%u", ( unsigned int )i );
+    if ( !KSemaCreate( &pSlot->sema, semaName, 0 ) ) {
+      MT_LOG( "%s(): Couldn't create %s", __FUNCTION__, semaName );
+      assert( 0 );
+    }
+  }
+}
+
+/**
+ * Hands a call message back to its waiting caller. Returns 
+ * false if the caller has given up, the slot is then released 
+ * here and the message is left to the thread. 
+ */
+static void CoroutineWake( MessageCoroutine* pCo );
+static bool CallComplete( MessageHeader* pHeader, MessageCallState state )
+{
+  MessageCallSlot* pSlot = pHeader->pCall;
+  uint32_t expected = MESSAGE_CALL_PENDING;
+  bool retval = false;
+  pHeader->pCall = NULL;
+  if ( pSlot->pCo ) {
+    //Coroutine calls can't be abandoned, the message goes straight back to the coroutine
+    MessageCoroutine* pCo = pSlot->pCo;
+    PoolFree( &s_callSlots.slotPool, pSlot );
+    retval = ( state == MESSAGE_CALL_DONE );
+    if ( !retval ) {
+      pCo->hReply = NULL;
+    }
+    CoroutineWake( pCo );
+  }
+  else if ( KAtomicCompareExchange32( &pSlot->state, &expected, state, KATOMIC_ACQ_REL ) ) {
+    KSemaPut( &pSlot->sema );
+    retval = true;
+  }
+  else {
+    PoolFree( &s_callSlots.slotPool, pSlot );
+  }
+  return retval;
+}
+
+/**
+ * Each stat has a single writer, so a relaxed load and store 
+ * keep readers from seeing torn values without a locked add. 
+ */
+static void StatsAdd64( KAtomicU64* pStat, uint64_t value )
+{
+  KAtomicStore64( pStat, KAtomicLoad64( pStat, KATOMIC_RELAXED ) + value, KATOMIC_RELAXED );
+}
+
+static void StatsAdd32( KAtomicU32* pStat, uint32_t value )
+{
+  KAtomicStore32( pStat, KAtomicLoad32( pStat, KATOMIC_RELAXED ) + value, KATOMIC_RELAXED );
+}
+
+static void WatchdogRecord( MessageLatencyKind kind, MessageThread* pThread, void* pMsg, uint64_t durationUs, uint32_t budgetUs )
+{
+  bool wake = false;
+  if ( KMutexLock( &s_watchdog.mutex, WAIT_FOREVER ) ) {
+    MessageLatencyEvent* pEvent = &s_watchdog.ring[ s_watchdog.written % MESSAGE_LATENCY_RING_SIZE ];
+    pEvent->kind = kind;
+    pEvent->threadName = pThread->threadName;
+    pEvent->hThread = pThread;
+    pEvent->hMessage = pMsg;
+    pEvent->durationUs = ( durationUs < UINT32_MAX ) ? ( uint32_t )durationUs : UINT32_MAX;
+    pEvent->budgetUs = budgetUs;
+    pEvent->timeUs = KTimeGetMicroseconds();
+    s_watchdog.written++;
+    wake = ( s_watchdog.fnCallback != NULL );
+    KMutexUnlock( &s_watchdog.mutex );
+  }
+  if ( wake ) {
+    KSemaPut( &s_watchdog.wakeSema );
+  }
+}
+
+/**
+ * Reports the handlers running past their budget. Every call is 
+ * reported once, the worker reports its full duration when it 
+ * returns. Returns true if any thread has a process budget. 
+ */
+static bool WatchdogScan( void )
+{
+  bool retval = false;
+  uint64_t now = KTimeGetMicroseconds();
+  uint32_t i = 0, j = 0;
+  if ( KMutexLock( &s_threadPool.liveMutex, WAIT_FOREVER ) ) {
+    for( i = 0; i < MESSAGE_THREADS_MAX; i++ ) {
+      MessageThread* pThread = s_threadPool.pLive[ i ];
+      if ( pThread && pThread->processBudgetUs ) {
+        retval = true;
+        for( j = 0; j < MESSAGE_THREAD_WORKERS_MAX; j++ ) {
+          MessageWorkerStats* pWorker = &pThread->workerStats[ j ];
+          uint32_t seq = KAtomicLoad32( &pWorker->messageSeq, KATOMIC_ACQUIRE );
+          uint64_t busySinceUs = KAtomicLoad64( &pWorker->busySinceUs, KATOMIC_ACQUIRE );
+          void* pMsg = KAtomicLoadPtr( &pWorker->pCurrent, KATOMIC_RELAXED );
+          //Skip it if the worker moved on while we looked
+          if ( busySinceUs && busySinceUs < now && 
+               now - busySinceUs > pThread->processBudgetUs &&
+               seq == KAtomicLoad32( &pWorker->messageSeq, KATOMIC_ACQUIRE ) && seq != pWorker->stuckSeq ) {
+            pWorker->stuckSeq = seq;
+            StatsAdd32( &pWorker->stuck, 1 );
+            WatchdogRecord( MESSAGE_LATENCY_STUCK, pThread, pMsg, now - busySinceUs, pThread->processBudgetUs );
+          }
+        }
+      }
+    }
+    KMutexUnlock( &s_threadPool.liveMutex );
+  }
+  return retval;
+}
+
+static void WatchdogDispatch( void )
+{
+  if ( KMutexLock( &s_watchdog.mutex, WAIT_FOREVER ) ) {
+    //Events that were overwritten before we got to them are skipped
+    if ( s_watchdog.written - s_watchdog.dispatched > MESSAGE_LATENCY_RING_SIZE ) {
+      s_watchdog.dispatched = s_watchdog.written - MESSAGE_LATENCY_RING_SIZE;
+    }
+    while( s_watchdog.fnCallback && s_watchdog.dispatched != s_watchdog.written ) {
+      MessageLatencyEvent event = s_watchdog.ring[ s_watchdog.dispatched % MESSAGE_LATENCY_RING_SIZE ];
+      MessageLatencyCallback fnCallback = s_watchdog.fnCallback;
+      void* pContext = s_watchdog.pCallbackContext;
+      s_watchdog.dispatched++;
+      KMutexUnlock( &s_watchdog.mutex );
+      fnCallback( pContext, &event );
+      KMutexLock( &s_watchdog.mutex, WAIT_FOREVER );
+    }
+    s_watchdog.dispatched = s_watchdog.written;
+    KMutexUnlock( &s_watchdog.mutex );
+  }
+}
+
+static void WatchdogThread( void* arg )
+{
+  for( ; ; ) {
+    //Sleeps till an event is recorded unless there are handlers to watch
+    uint32_t timeout = ( WatchdogScan() ) ? MESSAGE_WATCHDOG_PERIOD_MS : WAIT_FOREVER;
+    WatchdogDispatch();
+    KSemaGet( &s_watchdog.wakeSema, timeout );
+  }
+}
+
+static void WatchdogInit( void )
+{
+  bool created = false;
+  s_watchdog.written = s_watchdog.dispatched = 0;
+  s_watchdog.fnCallback = NULL;
+  if ( KMutexCreate( &s_watchdog.mutex, "MessageWatchdogMutex" ) ) {
+    if ( KSemaCreate( &s_watchdog.wakeSema, "MessageWatchdogSema", 0 ) ) {
+      KTHREAD_CREATE_PARAMS( watchdog,
+                             "MessageWatchdog",
+                             WatchdogThread,
+                             NULL,
+                             s_watchdogStack,
+                             sizeof( s_watchdogStack ),
+                             MESSAGE_WATCHDOG_THREAD_PRIORITY );
+      created = KThreadCreate( &s_watchdog.thread, KTHREAD_PARAMS( watchdog ) );
+      if ( !created ) {
+        KSemaDelete( &s_watchdog.wakeSema );
+        KMutexDelete( &s_watchdog.mutex );
+      }
+    }
+    else {
+      KMutexDelete( &s_watchdog.mutex );
+    }
+  }
+  if ( !created ) {
+    MT_LOG( "%s(): Couldn't start the message watchdog", __FUNCTION__ );
+    assert( 0 );
+  }
+}
+
+void MessageThreadSetLatencyCallback( MessageLatencyCallback fnCallback, void* pContext )
+{
+  if ( KMutexLock( &s_watchdog.mutex, WAIT_FOREVER ) ) {
+    //Only events recorded from now on are handed to the new callback
+    s_watchdog.dispatched = s_watchdog.written;
+    s_watchdog.fnCallback = fnCallback;
+    s_watchdog.pCallbackContext = pContext;
+    KMutexUnlock( &s_watchdog.mutex );
+  }
+}
+
+uint32_t MessageThreadGetLatencyEvents( MessageLatencyEvent* pEvents, uint32_t maxEvents, uint32_t* pTotal )
+{
+  uint32_t retval = 0;
+  if ( KMutexLock( &s_watchdog.mutex, WAIT_FOREVER ) ) {
+    uint32_t count = ( s_watchdog.written < MESSAGE_LATENCY_RING_SIZE ) ? s_watchdog.written : MESSAGE_LATENCY_RING_SIZE;
+    uint32_t first = 0;
+    count = ( count < maxEvents ) ? count : maxEvents;
+    first = s_watchdog.written - count;
+    for( retval = 0; retval < count; retval++ ) {
+      pEvents[ retval ] = s_watchdog.ring[ ( first + retval ) % MESSAGE_LATENCY_RING_SIZE ];
+    }
+    if ( pTotal ) {
+      *pTotal = s_watchdog.written;
+    }
+    KMutexUnlock( &s_watchdog.mutex );
+  }
+  return retval;
+}
+
+void MessageThreadSystemInit( void )
+{
+  static bool isInitialized = false;
+  if ( !isInitialized ) {
+    if ( !PoolCreate( &s_threadPool.threadPool,
+                      s_threadPool.threadStore,
+                      sizeof(s_threadPool.threadStore ),
+                      MESSAGE_THREADS_MAX ) ) {
+      assert( 0 );
+    }
+    if ( !KMutexCreate( &s_threadPool.liveMutex, "MessageThreadLive" ) ||
+         !KMutexCreate( &s_coroutineMutex, "MessageCoroutine" ) ) {
+      assert( 0 );
+    }
+    CallSlotsInit();
+    TimerServiceInit();
+    WatchdogInit();
+    isInitialized = true;
+  }
+}
+
+static void LiveAdd( MessageThread* pThread )
+{
+  uint32_t i = 0;
+  if ( KMutexLock( &s_threadPool.liveMutex, WAIT_FOREVER ) ) {
+    for( i = 0; i < MESSAGE_THREADS_MAX; i++ ) {
+      if ( !s_threadPool.pLive[ i ] ) {
+        s_threadPool.pLive[ i ] = pThread;
+        break;
+      }
+    }
+    KMutexUnlock( &s_threadPool.liveMutex );
+  }
+}
+
+static void LiveRemove( MessageThread* pThread )
+{
+  uint32_t i = 0;
+  if ( KMutexLock( &s_threadPool.liveMutex, WAIT_FOREVER ) ) {
+    for( i = 0; i < MESSAGE_THREADS_MAX; i++ ) {
+      if ( s_threadPool.pLive[ i ] == pThread ) {
+        s_threadPool.pLive[ i ] = NULL;
+        break;
+      }
+    }
+    KMutexUnlock( &s_threadPool.liveMutex );
+  }
+}
+
+static bool StartWorker( MessageThread* pThread, const MessageThreadDef* pThreadParams, KThreadCallback fnWorker )
+{
+  uint8_t* pStack = ( pThreadParams->pStack ) ? 
+    ( uint8_t* )pThreadParams->pStack + ( pThread->workerCount * pThreadParams->stackSize ) : NULL;
+  bool retval = false;
+  KTHREAD_CREATE_PARAMS_SCHED( messageThread, 
+                               pThreadParams->threadName, 
+                               fnWorker, 
+                               pThread,
+                               pStack,
+                               pThreadParams->stackSize, 
+                               pThreadParams->priority,
+                               pThreadParams->sched );
+  if ( KThreadCreate( &pThread->workers[ pThread->workerCount ], KTHREAD_PARAMS( messageThread ) ) ) {
+    pThread->workerCount++;
+    retval = true;
+  }
+  return retval;
 }
 
 MessageThreadHandle MessageThreadCreate( const MessageThreadDef *pThreadParams )
@@ -75,41 +673,84 @@ MessageThreadHandle MessageThreadCreate( const MessageThreadDef *pThreadParams )
   assert( pThreadParams );
   MessageThreadHandle retval = NULL;
   MessageThread *pThread = NULL;
+  uint32_t workerCount = ( pThreadParams->workerCount ) ? pThreadParams->workerCount : 1;
 
-  pThread = ( MessageThread* )PoolAlloc( &s_threadPool.threadPool );
+  if ( workerCount <= MESSAGE_THREAD_WORKERS_MAX ) {
+    pThread = ( MessageThread* )PoolAlloc( &s_threadPool.threadPool );
+  }
+  else {
+    MSG_POOL_LOG( "%s(): %u workers requested, MESSAGE_THREAD_WORKERS_MAX is %u",
+                  __FUNCTION__, workerCount, MESSAGE_THREAD_WORKERS_MAX );
+  }
   if ( pThread ) {
     if ( KSemaCreate( &pThread->sema, pThreadParams->threadName, 0 ) ) {
-      uint32_t* pPoolFlags = 0;
+      uint32_t slotSize = MESSAGE_SLOT_SIZE( pThreadParams->messageSize );
+      uint32_t poolStoreSize = POOL_STORE_SIZE( pThreadParams->messageQDepth, slotSize );
       void** pMessageQArray = 0;
+      bool queueCreated = false;
       pThread->threadName = pThreadParams->threadName;
       pThread->messageSize = pThreadParams->messageSize;
+      pThread->slotSize = slotSize;
       pThread->fnInit = pThreadParams->fnInit;
       pThread->fnProcess = pThreadParams->fnProcess;
+      pThread->fnMessageKey = pThreadParams->fnMessageKey;
+      pThread->fnMessageMerge = pThreadParams->fnMessageMerge;
       pThread->pPrivateData = pThreadParams->pPrivateData;
-      pThread->keepRunning = true;
+      KAtomicStore32( &pThread->keepRunning, true, KATOMIC_RELAXED );
+      memset( pThread->workerStats, 0, sizeof( pThread->workerStats ) );
+      KAtomicStore32( &pThread->statsClaimed, 0, KATOMIC_RELAXED );
+      pThread->createdUs = KTimeGetMicroseconds();
+      pThread->pCoroutines = NULL;
+      pThread->pWakeBacklog = NULL;
+      KAtomicStore32( &pThread->hasWakeBacklog, false, KATOMIC_RELAXED );
+      pThread->processBudgetUs = pThreadParams->processBudgetUs;
+      pThread->queueBudgetUs = pThreadParams->queueBudgetUs;
       assert( pThread->fnInit && pThread->fnProcess );
 
-      pMessageQArray = ( void** )( pThreadParams->messageBackingStore +
-                                   POOL_STORE_SIZE( pThreadParams->messageQDepth, pThread->messageSize ) );
-      if( MessageQueueInitialize( &pThread->messageQ, pMessageQArray, pThreadParams->messageQDepth ) )
+      pMessageQArray = ( void** )( pThreadParams->messageBackingStore + poolStoreSize );
+      if ( pThread->fnMessageKey ) {
+        MessageQueueIndexEntry* pIndexStore = 
+          ( MessageQueueIndexEntry* )( ( uint8_t* )pMessageQArray + MESSAGE_QUEUE_STORE_OVERHEAD( pThreadParams->messageQDepth ) );
+        queueCreated = MessageQueueInitializeCoalescing( &pThread->messageQ,
+                                                         pMessageQArray,
+                                                         pThreadParams->messageQDepth,
+                                                         pIndexStore,
+                                                         MessageKey,
+                                                         ( pThread->fnMessageMerge ) ? MessageMerge : NULL );
+      } else {
+        queueCreated = MessageQueueInitialize( &pThread->messageQ, pMessageQArray, pThreadParams->messageQDepth );
+      }
+      if( queueCreated )
       {
+        MessageQueueSetContext( &pThread->messageQ, pThread );
+        MessageQueueSetDiscardHandler( &pThread->messageQ, MessageDiscard );
+        MessageQueueSetEvictFilter( &pThread->messageQ, MessageEvictable );
+        MessageQueueSetOverflowPolicy( &pThread->messageQ, pThreadParams->overflowPolicy, pThreadParams->overflowTimeout );
+        MessageQueueSetSpin( &pThread->messageQ, pThreadParams->spinUs );
+        //Message headers must start out disarmed
+        memset( pThreadParams->messageBackingStore, 0, pThreadParams->messageQDepth * slotSize );
         if( PoolCreate( &pThread->pool, 
                         pThreadParams->messageBackingStore,
-                        pThreadParams->messageSize * pThreadParams->messageQDepth,
+                        poolStoreSize,
                         pThreadParams->messageQDepth ) ) {
-          KTHREAD_CREATE_PARAMS( messageThread, 
-                                 pThreadParams->threadName, 
-                                 Thread, 
-                                 pThread,
-                                 NULL,
-                                 pThreadParams->stackSize, 
-                                 pThreadParams->priority );
-           
-          if ( KThreadCreate( &pThread->threadHandle, KTHREAD_PARAMS( messageThread ) ) ) {
+          pThread->workerCount = 0;
+          if ( StartWorker( pThread, pThreadParams, Thread ) ) {
             //Will block till initialization of thread is complete. 
             KSemaGet( &pThread->sema, WAIT_FOREVER );
             KSemaDelete( &pThread->sema );
             retval = ( MessageThreadHandle )pThread;
+            LiveAdd( pThread );
+            if ( pThread->processBudgetUs ) {
+              //Gets the watchdog to start watching the handlers
+              KSemaPut( &s_watchdog.wakeSema );
+            }
+            while( retval && pThread->workerCount < workerCount ) {
+              if ( !StartWorker( pThread, pThreadParams, Worker ) ) {
+                MSG_POOL_LOG( "%s(): Couldn't create Worker %u", __FUNCTION__, pThread->workerCount );
+                MessageThreadDestroy( pThread );
+                retval = NULL;
+              }
+            }
           }
           else {
             MSG_POOL_LOG( "%s(): Couldn't create Thread", __FUNCTION__ );
@@ -137,7 +778,7 @@ MessageThreadHandle MessageThreadCreate( const MessageThreadDef *pThreadParams )
       PoolFree( &s_threadPool.threadPool, pThread );
     }
   }
-  else {
+  else if ( workerCount <= MESSAGE_THREAD_WORKERS_MAX ) {
     MSG_POOL_LOG( "%s(): Reached Message Thread Maximum count", __FUNCTION__ );
   }
   return retval;
@@ -146,11 +787,16 @@ MessageThreadHandle MessageThreadCreate( const MessageThreadDef *pThreadParams )
 void MessageThreadDestroy( MessageThreadHandle hThread )
 {
   MessageThread *pThread = ( MessageThread * ) hThread;
-  if ( pThread && pThread->keepRunning ) {
-    if( !MessageThreadPost( hThread, &pThread->keepRunning ) ) { //This message will instruct the thread loop to die.
-      MT_LOG( "%s(): Unable to post Thread DIE message to thread", __FUNCTION__ );
-      assert( 0 );
+  if ( pThread && KAtomicExchange32( &pThread->keepRunning, false, KATOMIC_ACQ_REL ) ) {
+    uint32_t i = 0;
+    for( i = 0; i < pThread->workerCount; i++ ) {
+      //Each of these messages will instruct one worker to die. They must not be subject to the overflow policy.
+      if( !MessageQueueEnQueueEx( &pThread->messageQ, &pThread->keepRunning, MESSAGE_QUEUE_OVERFLOW_BLOCK, WAIT_FOREVER ) ) {
+        MT_LOG( "%s(): Unable to post Thread DIE message to thread", __FUNCTION__ );
+        assert( 0 );
+      }
     }
+    MessageThreadInternalDestroy( pThread );
   }
 }
 
@@ -160,12 +806,28 @@ void* MessageThreadGetPrivateData( MessageThreadHandle hThread )
   return pThread->pPrivateData;
 }
 
-MessageHandle MessageThreadAllocateMessage( MessageThreadHandle hThread )
+MessageHandle MessageThreadTryAllocateMessage( MessageThreadHandle hThread )
 {
   MessageThread *pThread = ( MessageThread * )hThread;
   MessageHandle retval = NULL;
-  retval = ( MessageHandle )PoolAlloc( &pThread->pool );
-  if( !retval  ) {
+  MessageHeader* pHeader = ( MessageHeader* )PoolAlloc( &pThread->pool );
+  if( pHeader ) {
+    TimerWheelEntryInit( &pHeader->timer );
+    pHeader->pOwner = NULL;
+    pHeader->period = 0;
+    pHeader->fnRelease = NULL;
+    KAtomicStore32( &pHeader->refCount, 0, KATOMIC_RELAXED );
+    pHeader->pCall = NULL;
+    pHeader->postedUs = 0;
+    retval = MESSAGE_PAYLOAD( pHeader );
+  }
+  return retval;
+}
+
+MessageHandle MessageThreadAllocateMessage( MessageThreadHandle hThread )
+{
+  MessageHandle retval = MessageThreadTryAllocateMessage( hThread );
+  if( !retval ) {
     MSG_POOL_LOG( "%s: Couldn't allocate message", __FUNCTION__ );
     assert( 0 );
   }
@@ -176,7 +838,17 @@ void MessageThreadDestroyMessage( MessageThreadHandle hThread, MessageHandle* ph
 {
   MessageThread *pThread = ( MessageThread* )hThread;
   if( phMessage && *phMessage ) {
-    PoolFree( &pThread->pool, *phMessage );
+    MessageHeader* pHeader = MESSAGE_HEADER( *phMessage );
+    if ( pHeader->pCall ) {
+      //Dropped before it was processed, fails the call waiting for it
+      CallComplete( pHeader, MESSAGE_CALL_DROPPED );
+    }
+    if ( pHeader->fnRelease ) {
+      pHeader->fnRelease( *phMessage );
+    }
+    else {
+      PoolFree( &pThread->pool, pHeader );
+    }
     *phMessage = NULL;
   }
 }
@@ -185,27 +857,353 @@ bool MessageThreadPost( MessageThreadHandle hThread, MessageHandle hMessage )
 {
   bool retval = true;
   MessageThread *pThread = ( MessageThread* )hThread;
+  //Shared messages are stamped by their topic
+  if ( pThread->queueBudgetUs && !MESSAGE_HEADER( hMessage )->fnRelease ) {
+    MESSAGE_HEADER( hMessage )->postedUs = KTimeGetMicroseconds();
+  }
   if ( !MessageQueueEnQueue( &pThread->messageQ, hMessage ) ) {
     MSG_POOL_LOG( "Couldn't post message onto Q." );
-    //For now these calls shouldn't fail
-    assert( 0 );
+    //A blocking Q should never fail
+    assert( pThread->messageQ.overflowPolicy != MESSAGE_QUEUE_OVERFLOW_BLOCK );
+    MessageThreadDestroyMessage( hThread, &hMessage );
     retval = false;
   }
   return retval;
 }
 
+typedef struct _MessageFillArgs
+{
+  MessageThread* pThread;
+  MessageThreadMessageFill fnFill;
+  void* pArg;
+}MessageFillArgs;
+
+typedef struct _MessageCopyArgs
+{
+  const void* pPayload;
+  uint32_t size;
+}MessageCopyArgs;
+
+/**
+ * Runs with the Q locked, once the Q has room for the message.
+ */
+static void* ProduceMessage( void* pArg )
+{
+  MessageFillArgs* pFill = ( MessageFillArgs* )pArg;
+  MessageHandle hMessage = MessageThreadTryAllocateMessage( pFill->pThread );
+  if ( hMessage ) {
+    pFill->fnFill( hMessage, pFill->pArg );
+    if ( pFill->pThread->queueBudgetUs ) {
+      MESSAGE_HEADER( hMessage )->postedUs = KTimeGetMicroseconds();
+    }
+  }
+  else {
+    MSG_POOL_LOG( "%s(): %s has no free message", __FUNCTION__, pFill->pThread->threadName );
+  }
+  return hMessage;
+}
+
+static void CopyPayload( MessageHandle hMessage, void* pArg )
+{
+  MessageCopyArgs* pCopy = ( MessageCopyArgs* )pArg;
+  memcpy( hMessage, pCopy->pPayload, pCopy->size );
+}
+
+bool MessageThreadPostFill( MessageThreadHandle hThread, MessageThreadMessageFill fnFill, void* pArg )
+{
+  MessageFillArgs fill = { ( MessageThread* )hThread, fnFill, pArg };
+  assert( hThread && fnFill );
+  return MessageQueueEnQueueFrom( &fill.pThread->messageQ, ProduceMessage, &fill );
+}
+
+bool MessageThreadPostCopy( MessageThreadHandle hThread, const void* pPayload, uint32_t size )
+{
+  MessageCopyArgs copy = { pPayload, size };
+  assert( size <= ( ( MessageThread* )hThread )->messageSize );
+  return MessageThreadPostFill( hThread, CopyPayload, &copy );
+}
+
+bool MessageThreadCall( MessageThreadHandle hThread, MessageHandle hMessage, void* pReply, uint32_t timeout )
+{
+  MessageThread *pThread = ( MessageThread* )hThread;
+  MessageHeader* pHeader = MESSAGE_HEADER( hMessage );
+  MessageCallSlot* pSlot = ( MessageCallSlot* )PoolAlloc( &s_callSlots.slotPool );
+  bool retval = false;
+  //Shared messages can't be handed back to a single caller
+  assert( !pHeader->fnRelease );
+  if ( pSlot ) {
+    KAtomicStore32( &pSlot->state, MESSAGE_CALL_PENDING, KATOMIC_RELAXED );
+    pSlot->pCo = NULL;
+    pHeader->pCall = pSlot;
+    //A message that can't be posted is destroyed, which completes the call as well
+    MessageThreadPost( hThread, hMessage );
+    if ( !KSemaGet( &pSlot->sema, timeout ) ) {
+      uint32_t expected = MESSAGE_CALL_PENDING;
+      if ( KAtomicCompareExchange32( &pSlot->state, &expected, MESSAGE_CALL_ABANDONED, KATOMIC_ACQ_REL ) ) {
+        MT_LOG( "%s(): %s didn't complete the call in %u ms", __FUNCTION__, pThread->threadName, timeout );
+        pSlot = NULL;
+      }
+      else {
+        //Completed just as the wait timed out
+        KSemaGet( &pSlot->sema, WAIT_FOREVER );
+      }
+    }
+    if ( pSlot ) {
+      if ( KAtomicLoad32( &pSlot->state, KATOMIC_ACQUIRE ) == MESSAGE_CALL_DONE ) {
+        if ( pReply ) {
+          memcpy( pReply, hMessage, pThread->messageSize );
+        }
+        MessageThreadDestroyMessage( hThread, &hMessage );
+        retval = true;
+      }
+      PoolFree( &s_callSlots.slotPool, pSlot );
+    }
+  }
+  else {
+    MT_LOG( "%s(): All %u call slots are in use", __FUNCTION__, MESSAGE_THREAD_CALL_SLOTS_MAX );
+    MessageThreadDestroyMessage( hThread, &hMessage );
+  }
+  return retval;
+}
+
+bool MessageThreadPostDelayed( MessageThreadHandle hThread, MessageHandle hMessage, uint32_t delayUs )
+{
+  bool retval = false;
+  if ( delayUs ) {
+    retval = TimerArm( ( MessageThread* )hThread, hMessage, delayUs, 0 );
+  }
+  else {
+    retval = MessageThreadPost( hThread, hMessage );
+  }
+  return retval;
+}
+
+bool MessageThreadPostPeriodic( MessageThreadHandle hThread, MessageHandle hMessage, uint32_t periodUs )
+{
+  bool retval = false;
+  if ( periodUs ) {
+    retval = TimerArm( ( MessageThread* )hThread, hMessage, periodUs, periodUs );
+  }
+  return retval;
+}
+
+bool MessageThreadCancelTimer( MessageThreadHandle hThread, MessageHandle hMessage )
+{
+  bool retval = false;
+  MessageHeader* pHeader = MESSAGE_HEADER( hMessage );
+  if ( KMutexLock( &s_timerService.mutex, WAIT_FOREVER ) ) {
+    if ( pHeader->pOwner == hThread ) {
+      retval = TimerWheelRemove( &s_timerService.wheel, &pHeader->timer );
+    }
+    KMutexUnlock( &s_timerService.mutex );
+  }
+  if ( retval ) {
+    MessageThreadDestroyMessage( hThread, &hMessage );
+  }
+  return retval;
+}
+
+void MessageThreadGetQueueStats( MessageThreadHandle hThread, MessageQueueStats* pStats )
+{
+  MessageThread *pThread = ( MessageThread* )hThread;
+  MessageQueueGetStats( &pThread->messageQ, pStats );
+}
+
+void MessageThreadGetStats( MessageThreadHandle hThread, MessageThreadStats* pStats )
+{
+  MessageThread *pThread = ( MessageThread* )hThread;
+  uint64_t now = KTimeGetMicroseconds();
+  uint32_t i = 0, j = 0;
+  uint32_t maxProcessUs = 0;
+  memset( pStats, 0, sizeof( *pStats ) );
+  pStats->threadName = pThread->threadName;
+  pStats->workerCount = pThread->workerCount;
+  pStats->elapsedUs = now - pThread->createdUs;
+  for( i = 0; i < MESSAGE_THREAD_WORKERS_MAX; i++ ) {
+    MessageWorkerStats* pWorker = &pThread->workerStats[ i ];
+    uint64_t idleSinceUs = KAtomicLoad64( &pWorker->idleSinceUs, KATOMIC_RELAXED );
+    pStats->processed += KAtomicLoad64( &pWorker->processed, KATOMIC_RELAXED );
+    pStats->busyUs += KAtomicLoad64( &pWorker->busyUs, KATOMIC_RELAXED );
+    pStats->idleUs += KAtomicLoad64( &pWorker->idleUs, KATOMIC_RELAXED );
+    //Count the wait the worker is in right now
+    if ( idleSinceUs && idleSinceUs < now ) {
+      pStats->idleUs += now - idleSinceUs;
+    }
+    pStats->queueOverruns += KAtomicLoad32( &pWorker->queueOverruns, KATOMIC_RELAXED );
+    pStats->processOverruns += KAtomicLoad32( &pWorker->processOverruns, KATOMIC_RELAXED );
+    pStats->stuck += KAtomicLoad32( &pWorker->stuck, KATOMIC_RELAXED );
+    maxProcessUs = KAtomicLoad32( &pWorker->maxProcessUs, KATOMIC_RELAXED );
+    if ( maxProcessUs > pStats->maxProcessUs ) {
+      pStats->maxProcessUs = maxProcessUs;
+    }
+    for( j = 0; j < MESSAGE_THREAD_STATS_BUCKETS; j++ ) {
+      pStats->histogram[ j ] += KAtomicLoad32( &pWorker->histogram[ j ], KATOMIC_RELAXED );
+    }
+  }
+  if ( pStats->elapsedUs ) {
+    pStats->messagesPerSec = ( uint32_t )( ( pStats->processed * 1000000 ) / pStats->elapsedUs );
+  }
+}
+
+uint32_t MessageThreadForEach( MessageThreadVisit fnVisit, void* pContext )
+{
+  uint32_t retval = 0;
+  uint32_t i = 0;
+  MessageThreadStats stats;
+  if ( fnVisit && KMutexLock( &s_threadPool.liveMutex, WAIT_FOREVER ) ) {
+    for( i = 0; i < MESSAGE_THREADS_MAX; i++ ) {
+      if ( s_threadPool.pLive[ i ] ) {
+        MessageThreadGetStats( s_threadPool.pLive[ i ], &stats );
+        fnVisit( pContext, s_threadPool.pLive[ i ], &stats );
+        retval++;
+      }
+    }
+    KMutexUnlock( &s_threadPool.liveMutex );
+  }
+  return retval;
+}
+
+/**
+ * Queues the coroutine on its thread. If the Q is full it goes 
+ * on the backlog instead, which a worker looks at after every 
+ * message. The nudge makes sure a worker does, in case it 
+ * drained the Q before the coroutine made it to the backlog. 
+ */
+static void CoroutineWake( MessageCoroutine* pCo )
+{
+  MessageThread* pThread = ( MessageThread* )pCo->pThread;
+  if ( pThread->queueBudgetUs ) {
+    pCo->header.postedUs = KTimeGetMicroseconds();
+  }
+  if ( !MessageQueueEnQueueEx( &pThread->messageQ, MESSAGE_PAYLOAD( &pCo->header ), MESSAGE_QUEUE_OVERFLOW_FAIL, NO_SLEEP ) ) {
+    if ( KMutexLock( &s_coroutineMutex, WAIT_FOREVER ) ) {
+      pCo->pNextWake = pThread->pWakeBacklog;
+      pThread->pWakeBacklog = pCo;
+      KAtomicStore32( &pThread->hasWakeBacklog, true, KATOMIC_RELAXED );
+      KMutexUnlock( &s_coroutineMutex );
+    }
+    MessageQueueEnQueueEx( &pThread->messageQ, WAKE_NUDGE( pThread ), MESSAGE_QUEUE_OVERFLOW_FAIL, NO_SLEEP );
+  }
+}
+
+static void CoroutineResume( MessageCoroutine* pCo )
+{
+  MessageThread* pThread = ( MessageThread* )pCo->pThread;
+  if ( pCo->fn( pCo, pCo->pArg ) == MESSAGE_CO_DONE ) {
+    if ( KMutexLock( &s_coroutineMutex, WAIT_FOREVER ) ) {
+      if ( pCo->pNext ) {
+        pCo->pNext->pPrev = pCo->pPrev;
+      }
+      if ( pCo->pPrev ) {
+        pCo->pPrev->pNext = pCo->pNext;
+      }
+      else if ( pThread->pCoroutines == pCo ) {
+        pThread->pCoroutines = pCo->pNext;
+      }
+      pCo->pNext = pCo->pPrev = NULL;
+      KMutexUnlock( &s_coroutineMutex );
+    }
+  }
+}
+
+static void CoroutineResumeBacklog( MessageThread* pThread )
+{
+  MessageCoroutine* pCo = NULL;
+  if ( KMutexLock( &s_coroutineMutex, WAIT_FOREVER ) ) {
+    pCo = pThread->pWakeBacklog;
+    pThread->pWakeBacklog = NULL;
+    KAtomicStore32( &pThread->hasWakeBacklog, false, KATOMIC_RELAXED );
+    KMutexUnlock( &s_coroutineMutex );
+  }
+  while( pCo ) {
+    //The coroutine may go right back on the backlog
+    MessageCoroutine* pNext = pCo->pNextWake;
+    CoroutineResume( pCo );
+    pCo = pNext;
+  }
+}
+
+bool MessageCoroutineStart( MessageThreadHandle hThread, MessageCoroutine* pCo, MessageCoroutineFn fn, void* pArg )
+{
+  MessageThread *pThread = ( MessageThread* )hThread;
+  bool retval = false;
+  if ( pThread && pCo && fn ) {
+    memset( pCo, 0, sizeof( *pCo ) );
+    TimerWheelEntryInit( &pCo->header.timer );
+    pCo->header.pOwner = pThread;
+    pCo->header.fnRelease = CoroutineWakeRelease;
+    pCo->fn = fn;
+    pCo->pArg = pArg;
+    pCo->pThread = pThread;
+    if ( KMutexLock( &s_coroutineMutex, WAIT_FOREVER ) ) {
+      pCo->pNext = pThread->pCoroutines;
+      if ( pCo->pNext ) {
+        pCo->pNext->pPrev = pCo;
+      }
+      pThread->pCoroutines = pCo;
+      KMutexUnlock( &s_coroutineMutex );
+    }
+    CoroutineWake( pCo );
+    retval = true;
+  }
+  return retval;
+}
+
+MessageThreadHandle MessageCoroutineGetThread( MessageCoroutine* pCo )
+{
+  return pCo->pThread;
+}
+
+MessageHandle MessageCoroutineGetReply( MessageCoroutine* pCo )
+{
+  return pCo->hReply;
+}
+
+void MessageCoroutineCall( MessageCoroutine* pCo, MessageThreadHandle hThread, MessageHandle hMessage )
+{
+  MessageHeader* pHeader = MESSAGE_HEADER( hMessage );
+  MessageCallSlot* pSlot = ( MessageCallSlot* )PoolAlloc( &s_callSlots.slotPool );
+  //Shared messages can't be handed back to a single caller
+  assert( !pHeader->fnRelease );
+  pCo->hReply = hMessage;
+  if ( pSlot ) {
+    KAtomicStore32( &pSlot->state, MESSAGE_CALL_PENDING, KATOMIC_RELAXED );
+    pSlot->pCo = pCo;
+    pHeader->pCall = pSlot;
+    //A message that can't be posted is destroyed, which wakes the coroutine up as well
+    MessageThreadPost( hThread, hMessage );
+  }
+  else {
+    MT_LOG( "%s(): All %u call slots are in use", __FUNCTION__, MESSAGE_THREAD_CALL_SLOTS_MAX );
+    MessageThreadDestroyMessage( hThread, &hMessage );
+    pCo->hReply = NULL;
+    CoroutineWake( pCo );
+  }
+}
+
+void MessageCoroutineSleep( MessageCoroutine* pCo, uint32_t delayUs )
+{
+  if ( !delayUs || !TimerArm( ( MessageThread* )pCo->pThread, MESSAGE_PAYLOAD( &pCo->header ), delayUs, 0 ) ) {
+    CoroutineWake( pCo );
+  }
+}
+
 static void MessageThreadInternalDestroy( MessageThread* pThread )
 {
   if ( pThread ) {
-    if( KThreadDelete( &pThread->threadHandle ) ) {
-      PoolRelease( &pThread->pool );
-      MessageQueueDeInitialize( &pThread->messageQ );
-      PoolFree( &s_threadPool.threadPool, pThread );
-    } 
-    else {
-      MT_LOG( "%s(): Couldn't Delete Thread", __FUNCTION__ );
-      assert( 0 );
+    uint32_t i = 0;
+    LiveRemove( pThread );
+    //Waits for every worker to pick up its DIE message
+    for( i = 0; i < pThread->workerCount; i++ ) {
+      if( !KThreadDelete( &pThread->workers[ i ] ) ) {
+        MT_LOG( "%s(): Couldn't Delete Thread", __FUNCTION__ );
+        assert( 0 );
+      }
     }
+    TimerCancelAll( pThread );
+    PoolRelease( &pThread->pool );
+    MessageQueueDeInitialize( &pThread->messageQ );
+    PoolFree( &s_threadPool.threadPool, pThread );
   }
 }
 
@@ -213,28 +1211,100 @@ static void Thread( void *arg )
 {
   MessageThread *pThread = ( MessageThread* )arg;
   assert( pThread );
-  //Call private Init
+  //Call private Init, only the first worker does this
   pThread->fnInit( arg );
   KSemaPut( &pThread->sema );
-  while( pThread->keepRunning ) {
+  Worker( arg );
+}
+
+static MessageWorkerStats* ClaimWorkerStats( MessageThread* pThread )
+{
+  uint32_t index = KAtomicFetchAdd32( &pThread->statsClaimed, 1, KATOMIC_RELAXED );
+  assert( index < MESSAGE_THREAD_WORKERS_MAX );
+  return &pThread->workerStats[ index ];
+}
+
+static uint32_t StatsBucket( uint64_t durationUs )
+{
+  uint32_t retval = 0;
+  while( durationUs && retval < MESSAGE_THREAD_STATS_BUCKETS - 1 ) {
+    durationUs >>= 1;
+    retval++;
+  }
+  return retval;
+}
+
+static void StatsRecord( MessageWorkerStats* pStats, uint64_t startUs, uint64_t endUs )
+{
+  uint64_t durationUs = endUs - startUs;
+  StatsAdd64( &pStats->processed, 1 );
+  StatsAdd64( &pStats->busyUs, durationUs );
+  StatsAdd32( &pStats->histogram[ StatsBucket( durationUs ) ], 1 );
+  if ( durationUs > KAtomicLoad32( &pStats->maxProcessUs, KATOMIC_RELAXED ) ) {
+    KAtomicStore32( &pStats->maxProcessUs, ( durationUs < UINT32_MAX ) ? ( uint32_t )durationUs : UINT32_MAX, KATOMIC_RELAXED );
+  }
+}
+
+static void Worker( void *arg )
+{
+  MessageThread *pThread = ( MessageThread* )arg;
+  MessageWorkerStats* pStats = NULL;
+  uint64_t idleSinceUs = 0;
+  bool running = true;
+  assert( pThread );
+  pStats = ClaimWorkerStats( pThread );
+  idleSinceUs = KTimeGetMicroseconds();
+  KAtomicStore64( &pStats->idleSinceUs, idleSinceUs, KATOMIC_RELAXED );
+  while( running ) {
     void* pMsg = MessageQueueDeQueue( &pThread->messageQ );
-    if( pMsg && pMsg != &pThread->keepRunning ){
-      pThread->fnProcess( arg, pMsg );
-      //Delete the message
-      MessageThreadDestroyMessage( arg, &pMsg );
+    if( pMsg && pMsg != &pThread->keepRunning && pMsg != WAKE_NUDGE( pThread ) ){
+      MessageHeader* pHeader = MESSAGE_HEADER( pMsg );
+      //A resumed coroutine may be done and gone by the time it returns
+      bool isCoroutine = IS_COROUTINE_WAKE( pHeader );
+      uint64_t startUs = KTimeGetMicroseconds();
+      StatsAdd64( &pStats->idleUs, startUs - idleSinceUs );
+      KAtomicStore64( &pStats->idleSinceUs, 0, KATOMIC_RELAXED );
+      if ( pThread->queueBudgetUs && startUs > pHeader->postedUs + pThread->queueBudgetUs ) {
+        StatsAdd32( &pStats->queueOverruns, 1 );
+        WatchdogRecord( MESSAGE_LATENCY_QUEUE, pThread, pMsg, startUs - pHeader->postedUs, pThread->queueBudgetUs );
+      }
+      KAtomicStorePtr( &pStats->pCurrent, pMsg, KATOMIC_RELAXED );
+      KAtomicFetchAdd32( &pStats->messageSeq, 1, KATOMIC_RELEASE );
+      KAtomicStore64( &pStats->busySinceUs, startUs, KATOMIC_RELEASE );
+      if ( isCoroutine ) {
+        CoroutineResume( ( MessageCoroutine* )pHeader );
+      }
+      else {
+        pThread->fnProcess( arg, pMsg );
+      }
+      KAtomicStore64( &pStats->busySinceUs, 0, KATOMIC_RELEASE );
+      idleSinceUs = KTimeGetMicroseconds();
+      KAtomicStore64( &pStats->idleSinceUs, idleSinceUs, KATOMIC_RELAXED );
+      StatsRecord( pStats, startUs, idleSinceUs );
+      if ( pThread->processBudgetUs && idleSinceUs - startUs > pThread->processBudgetUs ) {
+        StatsAdd32( &pStats->processOverruns, 1 );
+        WatchdogRecord( MESSAGE_LATENCY_PROCESS, pThread, pMsg, idleSinceUs - startUs, pThread->processBudgetUs );
+      }
+      //Delete the message, unless a caller is waiting to take it back. Coroutines aren't messages.
+      if ( !isCoroutine && 
+           ( !pHeader->pCall || !CallComplete( pHeader, MESSAGE_CALL_DONE ) ) ) {
+        MessageThreadDestroyMessage( arg, &pMsg );
+      }
     }
     else if ( pMsg == &pThread->keepRunning ) {
-      //This message will allow us to kill this thread
-      pThread->keepRunning = false;
-      continue;
+      //This message will allow us to kill this worker
+      running = false;
     }
-    else{
+    else if ( !pMsg ) {
       MSG_POOL_LOG( "Couldn't pull message of Q" );
       assert( 0 );
     }
+    //Wake ups that didn't fit in the Q, a nudge only gets us here
+    if ( KAtomicLoad32( &pThread->hasWakeBacklog, KATOMIC_RELAXED ) ) {
+      CoroutineResumeBacklog( pThread );
+    }
   }
   MT_LOG( "Exiting" );
-  MessageThreadInternalDestroy( pThread );
 }
 
 #ifdef __cplusplus
@@ -25,6 +25,39 @@
 #define __MESSAGE_THREAD_IMPL_H__
 
 #include "MessageQueue.h"
+#include "TimerWheel.h"
+#include <AtomicInterface.h>
+
+/**
+ * Releases a message that was not allocated from the pool of 
+ * the message thread processing it. 
+ */
+typedef void (*MessageRelease)( void* hMessage );
+
+struct _MessageCallSlot;
+
+/**
+ * @struct MessageHeader - Bookkeeping kept in front of every 
+ *         message allocated from a message thread or a topic. 
+ *         Clients only see the message that follows it. 
+ */
+typedef struct _MessageHeader
+{
+  TimerWheelEntry timer;    /**< Must be first. Arms the message for a delayed / periodic post */
+  const void* pOwner;       /**< Message thread the timer posts to, or topic of a shared payload */
+  uint64_t period;          /**< Period in timer ticks, 0 for a one shot post */
+  MessageRelease fnRelease; /**< Set for shared messages, called instead of freeing to the thread pool */
+  KAtomicU32 refCount;      /**< References held on a shared message */
+  struct _MessageCallSlot* pCall; /**< Set while a MessageThreadCall() waits for the message */
+  uint64_t postedUs;        /**< When the message was queued, only stamped for threads with a queue budget */
+}MessageHeader;
+
+#define MESSAGE_HEADER( hMessage )    ( ( MessageHeader* )( ( uint8_t* )( hMessage ) - sizeof( MessageHeader ) ) )
+#define MESSAGE_PAYLOAD( pHeader )    ( ( void* )( ( uint8_t* )( pHeader ) + sizeof( MessageHeader ) ) )
+
+#define MESSAGE_ALIGNMENT                     ( sizeof( uint64_t ) )
+#define MESSAGE_SLOT_SIZE( msgSize )\
+  ( sizeof( MessageHeader ) + ( ( ( msgSize ) + MESSAGE_ALIGNMENT - 1 ) & ~( MESSAGE_ALIGNMENT - 1 ) ) )
 
 /**
  * Clients using the message thread should provide additional 
@@ -33,13 +66,22 @@
  * This macro provides a compile time method of determining the 
  * amount of overhead and can be used to create the necessary 
  * static storage. The storage requirements are as follows, the 
- * actual events that will be allocated and posted, the list of 
+ * actual events that will be allocated and posted ( each with 
+ * a MessageHeader in front of it ), the list of 
  * pointers to the posted events and a Pool Allocation Flag 
  * which is used by the message pool to keep track of free 
  * messages. 
  */
 #define MESSAGE_THREAD_BACKING_STORE_SIZE( msgCount, msgType )\
-  ( ( ( msgCount ) * sizeof( ( msgType ) ) ) +\
+  ( ( ( msgCount ) * MESSAGE_SLOT_SIZE( sizeof( msgType ) ) ) +\
   ADDITIONAL_POOL_OVERHEAD( ( msgCount ) ) + MESSAGE_QUEUE_STORE_OVERHEAD( ( msgCount ) ) )
 
+/**
+ * Backing store needed by a coalescing message thread ( one 
+ * with a fnMessageKey ). In addition to the above it holds the 
+ * key index of the message queue. 
+ */
+#define MESSAGE_THREAD_COALESCING_BACKING_STORE_SIZE( msgCount, msgType )\
+  ( MESSAGE_THREAD_BACKING_STORE_SIZE( msgCount, msgType ) + MESSAGE_QUEUE_INDEX_STORE_OVERHEAD( ( msgCount ) ) )
+
 #endif // __MESSAGE_THREAD_IMPL_H__
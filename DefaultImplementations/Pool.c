@@ -60,12 +60,9 @@ bool PoolCreate( MemPool* pPool,
         *(pPool->pFreeBits + i) = ( uint32_t ) -1;
       }
 
-      if( KMutexCreate( &pPool->mutex, "PoolMutex" )) {
-        retval = true;
-      }
-      else {
-        POOL_LOG( "Couldn't Initialize Mutex" );
-      }
+      //Only ever held for a bitmap scan
+      KSpinLockInit( &pPool->lock );
+      retval = true;
     } else {
       memset( pPool, 0, sizeof( MemPool ) );
       POOL_LOG( "PoolSize Error. Cannot Allocate %u units from buffer of size %u bytes, overhead needed: %u bytes",
@@ -78,16 +75,17 @@ bool PoolCreate( MemPool* pPool,
 void PoolRelease( MemPool* pPool )
 {
   if ( pPool ) {
-    bool result = KMutexLock( &pPool->mutex, WAIT_FOREVER );
-    if ( result ) {
-      KMutexDelete( &pPool->mutex );
-      memset( pPool->pBackingStore, 0, pPool->backingBufferSize );
-      pPool->pBackingStore = 0;
-      pPool->pFreeBits = 0;
-    }
-    else{
-      POOL_LOG( "%s(): Unable to lock mutex for release", __FUNCTION__ );
-      assert( 0 );
+    uint8_t* pBackingStore = 0;
+    uint32_t backingBufferSize = 0;
+    KSpinLockLock( &pPool->lock );
+    pBackingStore = pPool->pBackingStore;
+    backingBufferSize = pPool->backingBufferSize;
+    pPool->pBackingStore = 0;
+    pPool->pFreeBits = 0;
+    KSpinLockUnlock( &pPool->lock );
+    //Nothing reaches the store once it is unhooked, so clear it unlocked
+    if ( pBackingStore ) {
+      memset( pBackingStore, 0, backingBufferSize );
     }
   }
 }
@@ -113,20 +111,18 @@ static void MarkIndex( MemPool* pPool, bool shouldFree, uint32_t index, uint32_t
   if ( index < pPool->numOfUnits ) {
     if ( index < SINGLE_BITMASK_CAPACITY ) {
       uint32_t* pBits = pPool->pFreeBits + levelDeep;
-      POOL_LOG( "%s(): Old: %p",__FUNCTION__, *pBits );
       if( shouldFree ) {
         *pBits |= (1 << index);
       } else {
         *pBits &= ~( 1 << index );
       }
-      POOL_LOG( "%s(): New: %p", __FUNCTION__, *pBits );
     }
     else {
       MarkIndex( pPool, shouldFree, index - SINGLE_BITMASK_CAPACITY, levelDeep + 1 );
     }
   }
   else {
-    POOL_LOG( "%s(): Invalid Index to free: %d, Total: %d", __FUNCTION__, index, pPool->numOfUnits );
+    //Callers check the index before they take the lock
     assert( 0 );
   }
 }
@@ -135,21 +131,16 @@ void* PoolAlloc( MemPool* pPool )
 {
   void* retval = 0;
   if ( pPool ) {
-    if ( KMutexLock( &pPool->mutex, WAIT_FOREVER ) ) {
-      uint32_t freeIndex = GetFreeIndex( pPool, 0 );
-      if ( freeIndex < pPool->numOfUnits ) {
-        uint32_t sizeofUnit = pPool->backingBufferSize / pPool->numOfUnits;
-        retval = ( ( uint8_t* )pPool->pBackingStore + ( sizeofUnit * freeIndex ) );
-        MarkIndex( pPool, false, freeIndex, 0 );
-        POOL_LOG( "%s(): Retval: %p ( index: %d )", __FUNCTION__, retval, freeIndex );
-      }
-      KMutexUnlock( &pPool->mutex );
-    }
-    else
-    {
-      POOL_LOG( "%s(): Couldn't lock mutex", __FUNCTION__ );
-      assert( 0 );
+    uint32_t freeIndex = 0;
+    KSpinLockLock( &pPool->lock );
+    freeIndex = GetFreeIndex( pPool, 0 );
+    if ( freeIndex < pPool->numOfUnits ) {
+      uint32_t sizeofUnit = ( pPool->backingBufferSize - ADDITIONAL_POOL_OVERHEAD( pPool->numOfUnits ) ) / pPool->numOfUnits;
+      retval = ( ( uint8_t* )pPool->pBackingStore + ( sizeofUnit * freeIndex ) );
+      MarkIndex( pPool, false, freeIndex, 0 );
     }
+    KSpinLockUnlock( &pPool->lock );
+    POOL_LOG( "%s(): Retval: %p ( index: %d )", __FUNCTION__, retval, freeIndex );
   }
   return retval;
 }
@@ -165,15 +156,10 @@ void PoolFree( MemPool* pPool, void* buf )
            __FUNCTION__, indexToFree, buf, pPool->pBackingStore );
       assert( 0 );
     }
-    if ( KMutexLock( &pPool->mutex, WAIT_FOREVER ) ) {
-      MarkIndex( pPool, true, indexToFree, 0 );
-      KMutexUnlock( &pPool->mutex );
-    }
-    else
-    {
-      POOL_LOG( "%s(): Couldn't lock mutex", __FUNCTION__ );
-      assert( 0 );
-    }
+    KSpinLockLock( &pPool->lock );
+    MarkIndex( pPool, true, indexToFree, 0 );
+    KSpinLockUnlock( &pPool->lock );
+    POOL_LOG( "%s(): Freed: %p ( index: %d )", __FUNCTION__, buf, indexToFree );
   }
 }
 
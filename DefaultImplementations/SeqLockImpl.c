@@ -0,0 +1,94 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <SeqLock.h>
+#include <ThreadInterface.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void KSeqLockInit( KSeqLock* pLock )
+{
+  KAtomicStore32( &pLock->seq, 0, KATOMIC_RELAXED );
+}
+
+uint32_t KSeqLockReadBegin( KSeqLock* pLock )
+{
+  uint32_t spins = 0;
+  uint32_t seq = KAtomicLoad32( &pLock->seq, KATOMIC_ACQUIRE );
+  while( seq & 1 ) {
+    if ( ++spins < KSEQLOCK_SPINS ) {
+      KCPU_RELAX();
+    }
+    else {
+      //The writer may have been preempted by this thread
+      KThreadSleep( 1 );
+      spins = 0;
+    }
+    seq = KAtomicLoad32( &pLock->seq, KATOMIC_ACQUIRE );
+  }
+  return seq;
+}
+
+bool KSeqLockReadRetry( KSeqLock* pLock, uint32_t seq )
+{
+  //Keeps the reads of the data from moving past the check
+  KAtomicFence( KATOMIC_ACQUIRE );
+  return KAtomicLoad32( &pLock->seq, KATOMIC_RELAXED ) != seq;
+}
+
+void KSeqLockWriteBegin( KSeqLock* pLock )
+{
+  uint32_t seq = KAtomicLoad32( &pLock->seq, KATOMIC_RELAXED );
+  KAtomicStore32( &pLock->seq, seq + 1, KATOMIC_RELAXED );
+  //Keeps the writes of the data from moving ahead of the odd sequence
+  KAtomicFence( KATOMIC_RELEASE );
+}
+
+void KSeqLockWriteEnd( KSeqLock* pLock )
+{
+  uint32_t seq = KAtomicLoad32( &pLock->seq, KATOMIC_RELAXED );
+  KAtomicStore32( &pLock->seq, seq + 1, KATOMIC_RELEASE );
+}
+
+void KSeqLockRead( KSeqLock* pLock, void* pCopy, const void* pShared, size_t size )
+{
+  uint32_t seq = 0;
+  do {
+    seq = KSeqLockReadBegin( pLock );
+    memcpy( pCopy, pShared, size );
+  } while( KSeqLockReadRetry( pLock, seq ) );
+}
+
+void KSeqLockWrite( KSeqLock* pLock, void* pShared, const void* pData, size_t size )
+{
+  KSeqLockWriteBegin( pLock );
+  memcpy( pShared, pData, size );
+  KSeqLockWriteEnd( pLock );
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,50 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __SEQ_LOCK_IMPL_H__
+#define __SEQ_LOCK_IMPL_H__
+
+#include <AtomicInterface.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Busy waits a reader does on a write in progress before it 
+ * sleeps, so that a writer it preempted gets to finish. 
+ */
+#define KSEQLOCK_SPINS                ( 64 )
+
+typedef struct _KSeqLock
+{
+  KAtomicU32 seq;                   /**< Odd while a write is in progress */
+}KSeqLock;
+
+#define KSEQLOCK_INIT                 { KATOMIC_INIT( 0 ) }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SEQ_LOCK_IMPL_H__
@@ -0,0 +1,176 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <ThreadPool.h>
+#include <ConsoleLog.h>
+#include <assert.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define THREAD_POOL_LOG( str, ... )      ConsoleLogLine( str, ##__VA_ARGS__ )
+
+static void PooledThread( void* arg );
+
+static void Park( KPooledThread* pThread )
+{
+  KThreadPool* pPool = pThread->pPool;
+  KMutexLock( &pPool->idleMutex, WAIT_FOREVER );
+  pPool->pIdle[ pPool->idleCount++ ] = pThread;
+  KMutexUnlock( &pPool->idleMutex );
+  KSemaPut( &pPool->idleSema );
+}
+
+static bool StartThread( KThreadPool* pPool, const KThreadPoolDef* pDef )
+{
+  KPooledThread* pThread = &pPool->threads[ pPool->threadCount ];
+  uint8_t* pStack = ( pDef->pStack ) ? 
+    ( uint8_t* )pDef->pStack + ( pPool->threadCount * pDef->stackSize ) : NULL;
+  bool retval = false;
+  KTHREAD_CREATE_PARAMS( pooledThread, 
+                         pDef->pName, 
+                         PooledThread, 
+                         pThread,
+                         pStack,
+                         pDef->stackSize, 
+                         pDef->priority );
+  pThread->pPool = pPool;
+  if ( !KSemaCreate( &pThread->startSema, pDef->pName, 0 ) ) {
+    THREAD_POOL_LOG( "%s(): %s: Couldn't create semaphore", __FUNCTION__, pDef->pName );
+  }
+  else if ( !KSemaCreate( &pThread->doneSema, pDef->pName, 0 ) ) {
+    THREAD_POOL_LOG( "%s(): %s: Couldn't create semaphore", __FUNCTION__, pDef->pName );
+    KSemaDelete( &pThread->startSema );
+  }
+  else if ( !KThreadCreate( &pThread->thread, KTHREAD_PARAMS( pooledThread ) ) ) {
+    KSemaDelete( &pThread->doneSema );
+    KSemaDelete( &pThread->startSema );
+  }
+  else {
+    pPool->threadCount++;
+    Park( pThread );
+    retval = true;
+  }
+  return retval;
+}
+
+bool KThreadPoolCreate( KThreadPool* pPool, const KThreadPoolDef* pDef )
+{
+  assert( pPool && pDef );
+  uint32_t threadCount = ( pDef->threadCount < KTHREAD_POOL_THREADS_MAX ) ? pDef->threadCount : KTHREAD_POOL_THREADS_MAX;
+  bool retval = false;
+
+  memset( pPool, 0, sizeof( KThreadPool ) );
+  if ( !KMutexCreate( &pPool->idleMutex, pDef->pName ) ) {
+    THREAD_POOL_LOG( "%s(): %s: Couldn't create mutex", __FUNCTION__, pDef->pName );
+  }
+  else if ( !KSemaCreate( &pPool->idleSema, pDef->pName, 0 ) ) {
+    THREAD_POOL_LOG( "%s(): %s: Couldn't create semaphore", __FUNCTION__, pDef->pName );
+    KMutexDelete( &pPool->idleMutex );
+  }
+  else {
+    KAtomicStore32( &pPool->keepRunning, true, KATOMIC_RELAXED );
+    pPool->isInitialized = true;
+    retval = true;
+    while( retval && pPool->threadCount < threadCount ) {
+      if ( !StartThread( pPool, pDef ) ) {
+        THREAD_POOL_LOG( "%s(): %s: Couldn't create Thread %u", __FUNCTION__, pDef->pName, pPool->threadCount );
+        KThreadPoolDestroy( pPool );
+        retval = false;
+      }
+    }
+  }
+  return retval;
+}
+
+void KThreadPoolDestroy( KThreadPool* pPool )
+{
+  uint32_t i = 0;
+  if ( pPool && pPool->isInitialized ) {
+    //Threads still handed out would be woken up without a function
+    assert( pPool->idleCount == pPool->threadCount );
+    KAtomicStore32( &pPool->keepRunning, false, KATOMIC_RELEASE );
+    for( i = 0; i < pPool->threadCount; i++ ) {
+      KSemaPut( &pPool->threads[ i ].startSema );
+    }
+    for( i = 0; i < pPool->threadCount; i++ ) {
+      KPooledThread* pThread = &pPool->threads[ i ];
+      if ( !KThreadDelete( &pThread->thread ) ) {
+        THREAD_POOL_LOG( "%s(): Couldn't Delete Thread %u", __FUNCTION__, i );
+        assert( 0 );
+      }
+      KSemaDelete( &pThread->doneSema );
+      KSemaDelete( &pThread->startSema );
+    }
+    pPool->threadCount = pPool->idleCount = 0;
+    KSemaDelete( &pPool->idleSema );
+    KMutexDelete( &pPool->idleMutex );
+    pPool->isInitialized = false;
+  }
+}
+
+KPooledThread* KThreadPoolStart( KThreadPool* pPool, KThreadCallback fn, void* arg, uint32_t timeout )
+{
+  assert( pPool && pPool->isInitialized && fn );
+  KPooledThread* retval = NULL;
+  if ( KSemaGet( &pPool->idleSema, timeout ) ) {
+    KMutexLock( &pPool->idleMutex, WAIT_FOREVER );
+    retval = pPool->pIdle[ --pPool->idleCount ];
+    KMutexUnlock( &pPool->idleMutex );
+    retval->fn = fn;
+    retval->arg = arg;
+    KSemaPut( &retval->startSema );
+  }
+  return retval;
+}
+
+void KThreadPoolJoin( KPooledThread* pThread )
+{
+  assert( pThread );
+  KSemaGet( &pThread->doneSema, WAIT_FOREVER );
+  pThread->fn = NULL;
+  Park( pThread );
+}
+
+static void PooledThread( void* arg )
+{
+  KPooledThread* pThread = ( KPooledThread* )arg;
+  KThreadPool* pPool = pThread->pPool;
+  bool running = true;
+
+  while( running ) {
+    KSemaGet( &pThread->startSema, WAIT_FOREVER );
+    //Destroy puts the semaphore without a function
+    running = KAtomicLoad32( &pPool->keepRunning, KATOMIC_ACQUIRE );
+    if ( running ) {
+      pThread->fn( pThread->arg );
+      KSemaPut( &pThread->doneSema );
+    }
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
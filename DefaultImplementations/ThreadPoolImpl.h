@@ -0,0 +1,68 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __THREAD_POOL_IMPL_H__
+#define __THREAD_POOL_IMPL_H__
+
+#include <ThreadInterface.h>
+#include <MutexInterface.h>
+#include <SemaphoreInterface.h>
+#include <AtomicInterface.h>
+#include <AbstractUtilsConfig.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct KPooledThread - A parked worker of a KThreadPool. It
+ *         is handed out by KThreadPoolStart() and goes back to
+ *         the pool in KThreadPoolJoin().
+ */
+typedef struct _KPooledThread
+{
+  KThread thread;
+  struct _KThreadPool* pPool;
+  KThreadCallback fn;
+  void* arg;
+  KSema startSema;                  /**< Put to run fn */
+  KSema doneSema;                   /**< Put when fn has returned */
+}KPooledThread;
+
+typedef struct _KThreadPool
+{
+  KPooledThread threads[ KTHREAD_POOL_THREADS_MAX ];
+  uint32_t threadCount;             /**< Workers whose thread has been started */
+  KMutex idleMutex;
+  KPooledThread* pIdle[ KTHREAD_POOL_THREADS_MAX ];  /**< Parked workers, the last one parked is handed out first */
+  uint32_t idleCount;
+  KSema idleSema;                   /**< Counts the parked workers */
+  KAtomicU32 keepRunning;
+  bool isInitialized;
+}KThreadPool;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __THREAD_POOL_IMPL_H__
@@ -0,0 +1,254 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <Topic.h>
+#include <ThreadInterface.h>
+#include <TimeInterface.h>
+#include <ConsoleLog.h>
+#include <assert.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TOPIC_LOG( str, ... )     ConsoleLogLine( str, ##__VA_ARGS__ )
+
+
+static void PayloadRelease( void* hPayload )
+{
+  MessageHeader* pHeader = MESSAGE_HEADER( hPayload );
+  if ( KAtomicFetchSub32( &pHeader->refCount, 1, KATOMIC_ACQ_REL ) == 1 ) {
+    KTopic* pTopic = ( KTopic* )pHeader->pOwner;
+    PoolFree( &pTopic->payloadPool, pHeader );
+  }
+}
+
+static uint32_t ReadBegin( KTopic* pTopic )
+{
+  uint32_t index = 0;
+  for( ; ; ) {
+    index = KAtomicLoad32( &pTopic->current, KATOMIC_ACQUIRE );
+    KAtomicFetchAdd32( &pTopic->sets[ index ].readers, 1, KATOMIC_SEQ_CST );
+    //The set may have been swapped out before it was marked as being read
+    if ( KAtomicLoad32( &pTopic->current, KATOMIC_SEQ_CST ) == index ) {
+      break;
+    }
+    KAtomicFetchSub32( &pTopic->sets[ index ].readers, 1, KATOMIC_RELEASE );
+  }
+  return index;
+}
+
+static void ReadEnd( KTopic* pTopic, uint32_t index )
+{
+  KAtomicFetchSub32( &pTopic->sets[ index ].readers, 1, KATOMIC_RELEASE );
+}
+
+static void WaitForReaders( KTopicSubscriberSet* pSet )
+{
+  while( KAtomicLoad32( &pSet->readers, KATOMIC_SEQ_CST ) ) {
+    KThreadSleep( 1 );
+  }
+}
+
+//Must hold the topic mutex. Returns a copy of the current set that can be modified.
+static KTopicSubscriberSet* UpdateBegin( KTopic* pTopic )
+{
+  uint32_t current = KAtomicLoad32( &pTopic->current, KATOMIC_RELAXED );
+  KTopicSubscriberSet* pCurrent = &pTopic->sets[ current ];
+  KTopicSubscriberSet* pNext = &pTopic->sets[ current ^ 1 ];
+  //Publishers that picked it up before the last swap may still be reading it
+  WaitForReaders( pNext );
+  memcpy( pNext->subscribers, pCurrent->subscribers, sizeof( pNext->subscribers ) );
+  pNext->count = pCurrent->count;
+  return pNext;
+}
+
+//Must hold the topic mutex. Makes the modified set visible to publishers.
+static KTopicSubscriberSet* UpdateEnd( KTopic* pTopic )
+{
+  uint32_t current = KAtomicLoad32( &pTopic->current, KATOMIC_RELAXED );
+  KTopicSubscriberSet* pOld = &pTopic->sets[ current ];
+  KAtomicStore32( &pTopic->current, current ^ 1, KATOMIC_SEQ_CST );
+  return pOld;
+}
+
+static int32_t FindSubscriber( KTopicSubscriberSet* pSet, MessageThreadHandle hThread )
+{
+  int32_t retval = -1;
+  uint32_t i = 0;
+  for( i = 0; i < pSet->count && retval < 0; i++ ) {
+    if ( pSet->subscribers[ i ].hThread == hThread ) {
+      retval = ( int32_t )i;
+    }
+  }
+  return retval;
+}
+
+bool KTopicCreate( KTopic* pTopic,
+                   const char* pName,
+                   uint8_t* pBackingStore,
+                   uint32_t payloadCount,
+                   uint32_t payloadSize )
+{
+  bool retval = false;
+  if ( pTopic && pBackingStore && payloadCount ) {
+    memset( pTopic, 0, sizeof( KTopic ) );
+    pTopic->pName = pName;
+    pTopic->payloadSize = payloadSize;
+    if ( KMutexCreate( &pTopic->mutex, pName ) ) {
+      if ( PoolCreate( &pTopic->payloadPool,
+                       pBackingStore,
+                       POOL_STORE_SIZE( payloadCount, MESSAGE_SLOT_SIZE( payloadSize ) ),
+                       payloadCount ) ) {
+        pTopic->isInitialized = true;
+        retval = true;
+      }
+      else {
+        TOPIC_LOG( "%s(): Cannot Create Payload Pool", __FUNCTION__ );
+        KMutexDelete( &pTopic->mutex );
+      }
+    }
+    else {
+      TOPIC_LOG( "%s(): Couldn't Create Topic Mutex", __FUNCTION__ );
+    }
+  }
+  return retval;
+}
+
+void KTopicDestroy( KTopic* pTopic )
+{
+  if ( pTopic && pTopic->isInitialized ) {
+    pTopic->isInitialized = false;
+    PoolRelease( &pTopic->payloadPool );
+    KMutexDelete( &pTopic->mutex );
+  }
+}
+
+bool KTopicSubscribe( KTopic* pTopic, MessageThreadHandle hThread, KTopicFilter fnFilter, void* pContext )
+{
+  bool retval = false;
+  if ( pTopic && pTopic->isInitialized && hThread ) {
+    if ( KMutexLock( &pTopic->mutex, WAIT_FOREVER ) ) {
+      KTopicSubscriberSet* pSet = UpdateBegin( pTopic );
+      int32_t index = FindSubscriber( pSet, hThread );
+      //Subscribing again replaces the filter
+      if ( index < 0 && pSet->count < KTOPIC_SUBSCRIBERS_MAX ) {
+        index = ( int32_t )pSet->count++;
+      }
+      if ( index >= 0 ) {
+        pSet->subscribers[ index ].hThread = hThread;
+        pSet->subscribers[ index ].fnFilter = fnFilter;
+        pSet->subscribers[ index ].pContext = pContext;
+        UpdateEnd( pTopic );
+        retval = true;
+      }
+      else {
+        TOPIC_LOG( "%s(): %s has reached the subscriber maximum", __FUNCTION__, pTopic->pName );
+      }
+      KMutexUnlock( &pTopic->mutex );
+    }
+  }
+  return retval;
+}
+
+bool KTopicUnsubscribe( KTopic* pTopic, MessageThreadHandle hThread )
+{
+  bool retval = false;
+  if ( pTopic && pTopic->isInitialized ) {
+    if ( KMutexLock( &pTopic->mutex, WAIT_FOREVER ) ) {
+      KTopicSubscriberSet* pSet = UpdateBegin( pTopic );
+      int32_t index = FindSubscriber( pSet, hThread );
+      if ( index >= 0 ) {
+        pSet->count--;
+        memmove( &pSet->subscribers[ index ],
+                 &pSet->subscribers[ index + 1 ],
+                 ( pSet->count - index ) * sizeof( KTopicSubscriber ) );
+        //Publishes that still see the old set could post to the thread
+        WaitForReaders( UpdateEnd( pTopic ) );
+        retval = true;
+      }
+      KMutexUnlock( &pTopic->mutex );
+    }
+  }
+  return retval;
+}
+
+MessageHandle KTopicAllocatePayload( KTopic* pTopic )
+{
+  MessageHandle retval = NULL;
+  if ( pTopic && pTopic->isInitialized ) {
+    MessageHeader* pHeader = ( MessageHeader* )PoolAlloc( &pTopic->payloadPool );
+    if ( pHeader ) {
+      TimerWheelEntryInit( &pHeader->timer );
+      pHeader->pOwner = pTopic;
+      pHeader->period = 0;
+      pHeader->fnRelease = PayloadRelease;
+      KAtomicStore32( &pHeader->refCount, 0, KATOMIC_RELAXED );
+      pHeader->pCall = NULL;
+      pHeader->postedUs = 0;
+      retval = MESSAGE_PAYLOAD( pHeader );
+    }
+  }
+  return retval;
+}
+
+void KTopicDestroyPayload( KTopic* pTopic, MessageHandle* phPayload )
+{
+  if ( pTopic && phPayload && *phPayload ) {
+    PoolFree( &pTopic->payloadPool, MESSAGE_HEADER( *phPayload ) );
+    *phPayload = NULL;
+  }
+}
+
+uint32_t KTopicPublish( KTopic* pTopic, MessageHandle hPayload )
+{
+  uint32_t retval = 0;
+  if ( pTopic && pTopic->isInitialized && hPayload ) {
+    MessageHeader* pHeader = MESSAGE_HEADER( hPayload );
+    uint32_t index = ReadBegin( pTopic );
+    KTopicSubscriberSet* pSet = &pTopic->sets[ index ];
+    uint32_t i = 0;
+    //The publisher holds a reference till it has posted to every subscriber
+    KAtomicStore32( &pHeader->refCount, 1, KATOMIC_RELAXED );
+    //Stamped once, the subscribers share the header
+    pHeader->postedUs = KTimeGetMicroseconds();
+    for( i = 0; i < pSet->count; i++ ) {
+      KTopicSubscriber* pSubscriber = &pSet->subscribers[ i ];
+      if ( !pSubscriber->fnFilter || pSubscriber->fnFilter( pSubscriber->pContext, hPayload ) ) {
+        KAtomicFetchAdd32( &pHeader->refCount, 1, KATOMIC_RELAXED );
+        //A payload that can't be posted is released by the message thread
+        if ( MessageThreadPost( pSubscriber->hThread, hPayload ) ) {
+          retval++;
+        }
+      }
+    }
+    ReadEnd( pTopic, index );
+    PayloadRelease( hPayload );
+  }
+  return retval;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,91 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __TOPIC_IMPL_H__
+#define __TOPIC_IMPL_H__
+
+#include "MessageThread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KTOPIC_SUBSCRIBERS_MAX        ( MESSAGE_THREADS_MAX )
+
+/**
+ * Optional per subscriber filter. Called on the publishing 
+ * thread, return false to skip delivery of the payload to the 
+ * subscriber. 
+ */
+typedef bool (*KTopicFilter)( void* pContext, MessageHandle hPayload );
+
+typedef struct _KTopicSubscriber
+{
+  MessageThreadHandle hThread;
+  KTopicFilter fnFilter;
+  void* pContext;           /**< Passed to fnFilter */
+}KTopicSubscriber;
+
+/**
+ * @struct KTopicSubscriberSet - A snapshot of the subscribers. 
+ *         Publishers only read a set, it is modified while no 
+ *         publisher can see it. 
+ */
+typedef struct _KTopicSubscriberSet
+{
+  KTopicSubscriber subscribers[ KTOPIC_SUBSCRIBERS_MAX ];
+  uint32_t count;
+  KAtomicU32 readers;         /**< Publishers currently reading the set */
+}KTopicSubscriberSet;
+
+typedef struct _KTopic
+{
+  const char* pName;
+  KMutex mutex;                   /**< Serializes subscriber updates. Never taken by a publish. */
+  KTopicSubscriberSet sets[ 2 ];  /**< Publishers read sets[ current ], updates are made to the other one and swapped in */
+  KAtomicU32 current;
+  MemPool payloadPool;
+  uint32_t payloadSize;
+  bool isInitialized;
+}KTopic;
+
+/**
+ * Backing store needed for payloadCount payloads of a topic. 
+ * Like messages each payload has a MessageHeader in front of 
+ * it. 
+ */
+#define KTOPIC_BACKING_STORE_SIZE( payloadCount, payloadType )\
+  ( ( ( payloadCount ) * MESSAGE_SLOT_SIZE( sizeof( payloadType ) ) ) + ADDITIONAL_POOL_OVERHEAD( ( payloadCount ) ) )
+
+#define KTOPIC_DEF( name, payloadCount, payloadType )\
+  uint8_t kTopicStore_##name[ KTOPIC_BACKING_STORE_SIZE( payloadCount, payloadType ) ];\
+  KTopic kTopic_##name
+
+#define KTOPIC( name ) kTopic_##name
+#define KTOPIC_STORE( name ) kTopicStore_##name
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TOPIC_IMPL_H__
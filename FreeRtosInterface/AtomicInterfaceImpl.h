@@ -0,0 +1,241 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __ATOMIC_INTERFACE_IMPL_H__
+#define __ATOMIC_INTERFACE_IMPL_H__
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The FreeRTOS targets are single core, every read-modify-write
+ * is made atomic by a critical section, which is also a full
+ * barrier. Only relaxed 32 bit and pointer loads and stores,
+ * which the targets do in one access, skip it. 
+ */
+typedef enum
+{
+  KATOMIC_RELAXED = 0,
+  KATOMIC_ACQUIRE,
+  KATOMIC_RELEASE,
+  KATOMIC_ACQ_REL,
+  KATOMIC_SEQ_CST,
+}KAtomicOrder;
+
+typedef struct _KAtomicU32
+{
+  volatile uint32_t value;
+}KAtomicU32;
+
+typedef struct _KAtomicU64
+{
+  volatile uint64_t value;
+}KAtomicU64;
+
+typedef struct _KAtomicPtr
+{
+  void* volatile value;
+}KAtomicPtr;
+
+#define KATOMIC_INIT( v )         { ( v ) }
+
+static inline uint32_t KAtomicLoad32( KAtomicU32* pAtomic, KAtomicOrder order )
+{
+  uint32_t retval = 0;
+  if ( order == KATOMIC_RELAXED ) {
+    retval = pAtomic->value;
+  }
+  else {
+    taskENTER_CRITICAL();
+    retval = pAtomic->value;
+    taskEXIT_CRITICAL();
+  }
+  return retval;
+}
+
+static inline void KAtomicStore32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order )
+{
+  if ( order == KATOMIC_RELAXED ) {
+    pAtomic->value = value;
+  }
+  else {
+    taskENTER_CRITICAL();
+    pAtomic->value = value;
+    taskEXIT_CRITICAL();
+  }
+}
+
+static inline uint32_t KAtomicExchange32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order )
+{
+  uint32_t retval = 0;
+  taskENTER_CRITICAL();
+  retval = pAtomic->value;
+  pAtomic->value = value;
+  taskEXIT_CRITICAL();
+  return retval;
+}
+
+static inline bool KAtomicCompareExchange32( KAtomicU32* pAtomic, uint32_t* pExpected, uint32_t desired, KAtomicOrder order )
+{
+  bool retval = false;
+  taskENTER_CRITICAL();
+  if ( pAtomic->value == *pExpected ) {
+    pAtomic->value = desired;
+    retval = true;
+  }
+  else {
+    *pExpected = pAtomic->value;
+  }
+  taskEXIT_CRITICAL();
+  return retval;
+}
+
+static inline uint32_t KAtomicFetchAdd32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order )
+{
+  uint32_t retval = 0;
+  taskENTER_CRITICAL();
+  retval = pAtomic->value;
+  pAtomic->value = retval + value;
+  taskEXIT_CRITICAL();
+  return retval;
+}
+
+static inline uint32_t KAtomicFetchSub32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order )
+{
+  return KAtomicFetchAdd32( pAtomic, ( uint32_t )0 - value, order );
+}
+
+static inline uint32_t KAtomicFetchOr32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order )
+{
+  uint32_t retval = 0;
+  taskENTER_CRITICAL();
+  retval = pAtomic->value;
+  pAtomic->value = retval | value;
+  taskEXIT_CRITICAL();
+  return retval;
+}
+
+static inline uint32_t KAtomicFetchAnd32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order )
+{
+  uint32_t retval = 0;
+  taskENTER_CRITICAL();
+  retval = pAtomic->value;
+  pAtomic->value = retval & value;
+  taskEXIT_CRITICAL();
+  return retval;
+}
+
+static inline uint64_t KAtomicLoad64( KAtomicU64* pAtomic, KAtomicOrder order )
+{
+  uint64_t retval = 0;
+  taskENTER_CRITICAL();
+  retval = pAtomic->value;
+  taskEXIT_CRITICAL();
+  return retval;
+}
+
+static inline void KAtomicStore64( KAtomicU64* pAtomic, uint64_t value, KAtomicOrder order )
+{
+  taskENTER_CRITICAL();
+  pAtomic->value = value;
+  taskEXIT_CRITICAL();
+}
+
+static inline uint64_t KAtomicFetchAdd64( KAtomicU64* pAtomic, uint64_t value, KAtomicOrder order )
+{
+  uint64_t retval = 0;
+  taskENTER_CRITICAL();
+  retval = pAtomic->value;
+  pAtomic->value = retval + value;
+  taskEXIT_CRITICAL();
+  return retval;
+}
+
+static inline void* KAtomicLoadPtr( KAtomicPtr* pAtomic, KAtomicOrder order )
+{
+  void* retval = NULL;
+  if ( order == KATOMIC_RELAXED ) {
+    retval = pAtomic->value;
+  }
+  else {
+    taskENTER_CRITICAL();
+    retval = pAtomic->value;
+    taskEXIT_CRITICAL();
+  }
+  return retval;
+}
+
+static inline void KAtomicStorePtr( KAtomicPtr* pAtomic, void* value, KAtomicOrder order )
+{
+  if ( order == KATOMIC_RELAXED ) {
+    pAtomic->value = value;
+  }
+  else {
+    taskENTER_CRITICAL();
+    pAtomic->value = value;
+    taskEXIT_CRITICAL();
+  }
+}
+
+static inline void* KAtomicExchangePtr( KAtomicPtr* pAtomic, void* value, KAtomicOrder order )
+{
+  void* retval = NULL;
+  taskENTER_CRITICAL();
+  retval = pAtomic->value;
+  pAtomic->value = value;
+  taskEXIT_CRITICAL();
+  return retval;
+}
+
+static inline bool KAtomicCompareExchangePtr( KAtomicPtr* pAtomic, void** pExpected, void* desired, KAtomicOrder order )
+{
+  bool retval = false;
+  taskENTER_CRITICAL();
+  if ( pAtomic->value == *pExpected ) {
+    pAtomic->value = desired;
+    retval = true;
+  }
+  else {
+    *pExpected = pAtomic->value;
+  }
+  taskEXIT_CRITICAL();
+  return retval;
+}
+
+static inline void KAtomicFence( KAtomicOrder order )
+{
+  taskENTER_CRITICAL();
+  taskEXIT_CRITICAL();
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __ATOMIC_INTERFACE_IMPL_H__
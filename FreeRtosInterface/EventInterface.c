@@ -0,0 +1,86 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <EventInterface.h>
+
+bool KEventCreate( KEvent* pEvent, const char* pEventName )
+{
+  bool retval = false;
+  if( pEvent ) {
+    pEvent->hGroup = xEventGroupCreateStatic( &pEvent->group );
+    retval = ( pEvent->hGroup ) ? true : false;
+  }
+  return retval;
+}
+
+void KEventDelete( KEvent* pEvent )
+{
+  if( pEvent ) {
+    vEventGroupDelete( pEvent->hGroup );
+  }
+}
+
+uint32_t KEventSet( KEvent* pEvent, uint32_t flags )
+{
+  uint32_t retval = 0;
+  if( pEvent ) {
+    retval = ( uint32_t )xEventGroupSetBits( pEvent->hGroup, ( EventBits_t )( flags & KEVENT_FLAGS_MASK ) );
+  }
+  return retval;
+}
+
+uint32_t KEventClear( KEvent* pEvent, uint32_t flags )
+{
+  uint32_t retval = 0;
+  if( pEvent ) {
+    retval = ( uint32_t )xEventGroupClearBits( pEvent->hGroup, ( EventBits_t )( flags & KEVENT_FLAGS_MASK ) );
+  }
+  return retval;
+}
+
+uint32_t KEventGet( KEvent* pEvent )
+{
+  uint32_t retval = 0;
+  if( pEvent ) {
+    retval = ( uint32_t )xEventGroupGetBits( pEvent->hGroup );
+  }
+  return retval;
+}
+
+uint32_t KEventWait( KEvent* pEvent, uint32_t flags, uint32_t options, uint32_t timeout )
+{
+  uint32_t retval = 0;
+  if( pEvent && flags ) {
+    EventBits_t bits = ( EventBits_t )( flags & KEVENT_FLAGS_MASK );
+    uint32_t current = ( uint32_t )xEventGroupWaitBits( pEvent->hGroup,
+                                                        bits,
+                                                        ( options & KEVENT_CLEAR_ON_EXIT ) ? pdTRUE : pdFALSE,
+                                                        ( options & KEVENT_WAIT_ALL ) ? pdTRUE : pdFALSE,
+                                                        TimeoutInMsToTickConverter( timeout ) );
+    //The flags are returned on a timeout as well
+    if( ( options & KEVENT_WAIT_ALL ) ? ( ( current & bits ) == bits ) : ( ( current & bits ) != 0 ) ) {
+      retval = current;
+    }
+  }
+  return retval;
+}
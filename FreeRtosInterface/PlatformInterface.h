@@ -36,6 +36,8 @@ extern "C" {
 #include <stdbool.h>
 #include <stdint.h>
 #include <semphr.h>
+#include <event_groups.h>
+#include <AtomicInterfaceImpl.h>
 #include <InterfacePrivateCommon.h>
 #include <AbstractUtilsConfig.h>
 
@@ -56,12 +58,25 @@ typedef struct {
   char mutexName[ THREAD_NAME_MAX_SIZE ];
 }KMutex;
 
+typedef struct {
+  volatile uint32_t state;          /* Readers in the low 16 bits, writers holding or waiting above */
+  StaticSemaphore_t writerMutex;
+  SemaphoreHandle_t hWriterMutex;
+  StaticSemaphore_t drainSema;
+  SemaphoreHandle_t hDrainSema;     /* Given when the last reader leaves while a writer waits */
+}KRwLock;
+
+typedef struct {
+  StaticEventGroup_t group;
+  EventGroupHandle_t hGroup;
+}KEvent;
+
 typedef struct {
   StaticTask_t task;
   TaskHandle_t hTask;
   KThreadCallback fn;
   void* arg;
-  bool isComplete;
+  KAtomicU32 isComplete;
   char threadName[ THREAD_NAME_MAX_SIZE ];
   uint32_t sanity;
   KMutex joinMutex;
@@ -88,6 +103,13 @@ inline uint32_t TimeoutInMsToTickConverter( uint32_t timeoutInMs )
 #define SEMANTIC_THREAD_PRIORITY_LOW       ( ( SEMANTIC_THREAD_PRIORITY_MID + SEMANTIC_THREAD_PRIORITY_LOWEST ) / 2 )
 #define SEMANTIC_THREAD_PRIORITY_HIGH      ( ( SEMANTIC_THREAD_PRIORITY_HIGHEST + SEMANTIC_THREAD_PRIORITY_MID ) / 2 ) 
 
+/**
+ * Called on every iteration of a busy wait. There is no portable
+ * pause hint across the FreeRTOS ports, so let other ready tasks
+ * of the same priority run instead.
+ */
+#define KCPU_RELAX()                       taskYIELD()
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,143 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <RwLockInterface.h>
+
+#define RWLOCK_WRITER           ( 1u << 16 )
+#define RWLOCK_READERS_MASK     ( RWLOCK_WRITER - 1 )
+
+/**
+ * The state is updated in a critical section, the cheapest way
+ * to make a read-modify-write atomic across the ports. Writers
+ * take the writer mutex before they announce themselves in the
+ * state, readers that find a writer wait on that same mutex for
+ * it to finish, and the writer waits on the drain semaphore for
+ * the readers already in.
+ */
+static bool TryEnterReader( KRwLock* pLock )
+{
+  bool retval = false;
+  taskENTER_CRITICAL();
+  if ( !( pLock->state & ~RWLOCK_READERS_MASK ) ) {
+    pLock->state++;
+    retval = true;
+  }
+  taskEXIT_CRITICAL();
+  return retval;
+}
+
+static uint32_t AddState( KRwLock* pLock, uint32_t value )
+{
+  uint32_t retval = 0;
+  taskENTER_CRITICAL();
+  pLock->state += value;
+  retval = pLock->state;
+  taskEXIT_CRITICAL();
+  return retval;
+}
+
+bool KRwLockCreate( KRwLock* pLock, const char* pLockName )
+{
+  bool retval = false;
+  if( pLock ) {
+    pLock->state = 0;
+    pLock->hWriterMutex = xSemaphoreCreateMutexStatic( &pLock->writerMutex );
+    pLock->hDrainSema = xSemaphoreCreateBinaryStatic( &pLock->drainSema );
+    retval = ( pLock->hWriterMutex && pLock->hDrainSema ) ? true : false;
+  }
+  return retval;
+}
+
+void KRwLockDelete( KRwLock* pLock )
+{
+  if( pLock ) {
+    vSemaphoreDelete( pLock->hWriterMutex );
+    vSemaphoreDelete( pLock->hDrainSema );
+  }
+}
+
+bool KRwLockReadLock( KRwLock* pLock, uint32_t timeout )
+{
+  bool retval = false;
+  bool inTime = true;
+  TickType_t ticks = TimeoutInMsToTickConverter( timeout );
+  TimeOut_t timeOut;
+  if( pLock ) {
+    vTaskSetTimeOutState( &timeOut );
+    while( !retval && inTime ) {
+      retval = TryEnterReader( pLock );
+      if( !retval ) {
+        //Wait for the writer to let go
+        inTime = ( xTaskCheckForTimeOut( &timeOut, &ticks ) == pdFALSE ) &&
+                 ( xSemaphoreTake( pLock->hWriterMutex, ticks ) == pdTRUE );
+        if( inTime ) {
+          xSemaphoreGive( pLock->hWriterMutex );
+        }
+      }
+    }
+  }
+  return retval;
+}
+
+void KRwLockReadUnlock( KRwLock* pLock )
+{
+  if( pLock ) {
+    uint32_t state = AddState( pLock, ( uint32_t )-1 );
+    if( state && !( state & RWLOCK_READERS_MASK ) ) {
+      //Last reader out while a writer waits
+      xSemaphoreGive( pLock->hDrainSema );
+    }
+  }
+}
+
+bool KRwLockWriteLock( KRwLock* pLock, uint32_t timeout )
+{
+  bool retval = false;
+  TickType_t ticks = TimeoutInMsToTickConverter( timeout );
+  TimeOut_t timeOut;
+  if( pLock ) {
+    vTaskSetTimeOutState( &timeOut );
+    if( xSemaphoreTake( pLock->hWriterMutex, ticks ) == pdTRUE ) {
+      //Only announced once the mutex is held, so that readers that see a writer always have a mutex to block on
+      AddState( pLock, RWLOCK_WRITER );
+      retval = true;
+      while( retval && ( AddState( pLock, 0 ) & RWLOCK_READERS_MASK ) ) {
+        retval = ( xTaskCheckForTimeOut( &timeOut, &ticks ) == pdFALSE ) &&
+                 ( xSemaphoreTake( pLock->hDrainSema, ticks ) == pdTRUE );
+      }
+      if( !retval ) {
+        AddState( pLock, -RWLOCK_WRITER );
+        xSemaphoreGive( pLock->hWriterMutex );
+      }
+    }
+  }
+  return retval;
+}
+
+void KRwLockWriteUnlock( KRwLock* pLock )
+{
+  if( pLock ) {
+    AddState( pLock, -RWLOCK_WRITER );
+    xSemaphoreGive( pLock->hWriterMutex );
+  }
+}
@@ -0,0 +1,115 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __SPINLOCK_INTERFACE_IMPL_H__
+#define __SPINLOCK_INTERFACE_IMPL_H__
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The FreeRTOS targets are single core, nothing can run while a
+ * critical section is held so there is never a waiter to spin.
+ * Both locks are a critical section, which also keeps interrupts
+ * out, so they are only meant for sections a few instructions
+ * long. 
+ */
+typedef struct _KSpinLock
+{
+  volatile uint32_t isLocked;
+}KSpinLock;
+
+typedef struct _KMcsNode
+{
+  uint32_t unused;
+}KMcsNode;
+
+typedef struct _KMcsLock
+{
+  volatile uint32_t isLocked;
+}KMcsLock;
+
+#define KSPINLOCK_INIT                { 0 }
+#define KMCSLOCK_INIT                 { 0 }
+
+static inline void KSpinLockInit( KSpinLock* pLock )
+{
+  pLock->isLocked = 0;
+}
+
+static inline void KSpinLockLock( KSpinLock* pLock )
+{
+  taskENTER_CRITICAL();
+  configASSERT( !pLock->isLocked );
+  pLock->isLocked = 1;
+}
+
+static inline bool KSpinLockTryLock( KSpinLock* pLock )
+{
+  KSpinLockLock( pLock );
+  return true;
+}
+
+static inline void KSpinLockUnlock( KSpinLock* pLock )
+{
+  pLock->isLocked = 0;
+  taskEXIT_CRITICAL();
+}
+
+static inline void KMcsLockInit( KMcsLock* pLock )
+{
+  pLock->isLocked = 0;
+}
+
+static inline void KMcsLockLock( KMcsLock* pLock, KMcsNode* pNode )
+{
+  ( void )pNode;
+  taskENTER_CRITICAL();
+  configASSERT( !pLock->isLocked );
+  pLock->isLocked = 1;
+}
+
+static inline bool KMcsLockTryLock( KMcsLock* pLock, KMcsNode* pNode )
+{
+  KMcsLockLock( pLock, pNode );
+  return true;
+}
+
+static inline void KMcsLockUnlock( KMcsLock* pLock, KMcsNode* pNode )
+{
+  ( void )pNode;
+  pLock->isLocked = 0;
+  taskEXIT_CRITICAL();
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SPINLOCK_INTERFACE_IMPL_H__
@@ -0,0 +1,44 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <TimeInterface.h>
+
+static TickType_t s_lastTick;
+static uint64_t s_tickWraps;
+
+uint64_t KTimeGetMicroseconds( void )
+{
+  uint64_t ticks = 0;
+  taskENTER_CRITICAL();
+  {
+    TickType_t now = xTaskGetTickCount();
+    //The tick count is only 16 / 32 bits wide, extend it. Needs a call at least once per wrap.
+    if ( now < s_lastTick ) {
+      s_tickWraps++;
+    }
+    s_lastTick = now;
+    ticks = ( s_tickWraps * ( ( uint64_t )portMAX_DELAY + 1 ) ) + now;
+  }
+  taskEXIT_CRITICAL();
+  return ticks * portTICK_PERIOD_MS * 1000;
+}
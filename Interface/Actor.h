@@ -0,0 +1,116 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __ACTOR_H__
+#define __ACTOR_H__
+
+#include "ActorImpl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup KActor - actors multiplexed on a few threads
+ *  An actor is a mailbox and a handler. Unlike a MessageThread
+ *  it has no thread of its own: when mail arrives in an empty
+ *  mailbox the actor is queued on its system, and the first
+ *  idle worker of the system runs the handler over the mailbox.
+ *  Every handler runs to completion, and an actor is only ever
+ *  run by one worker at a time, so its state needs no locking.
+ *  A worker hands an actor back to the ready queue after
+ *  KActorSystemDef.batch messages, which keeps a busy actor from
+ *  starving the others.
+ *
+ *  Actors and messages belong to the client, an actor costs a
+ *  few pointers and sending a message allocates nothing, so a
+ *  system can run thousands of actors on as many workers as
+ *  there are cores.
+ **/
+
+/**
+ * @struct KActorSystemDef - Parameters of KActorSystemCreate().
+ */
+typedef struct _KActorSystemDef
+{
+  const char* pName;
+  uint32_t workerCount;       /**< 0 for one worker per core, capped at KACTOR_WORKERS_MAX */
+  uint32_t stackSize;         /**< Stack size of each worker */
+  uint32_t priority;
+  void* pStack;               /**< Optional, stackSize bytes for each worker, one after the other */
+  uint32_t batch;             /**< Messages per turn of an actor, 0 for KACTOR_DEFAULT_BATCH */
+}KActorSystemDef;
+
+/**
+ * KActorSystemCreate - Initializes an actor system and starts
+ * its workers.
+ * 
+ * 
+ * @param pSystem - System to initialize.
+ * @param pDef - Parameters of the system.
+ * 
+ * @return bool - true if created.
+ */
+bool KActorSystemCreate( KActorSystem* pSystem, const KActorSystemDef* pDef );
+
+/**
+ * KActorSystemDestroy - Stops the workers and waits for them to
+ * exit. Messages still in the mailboxes are left there, for the
+ * client to reclaim. Must not be called from a handler.
+ * 
+ * 
+ * @param pSystem - System to destroy.
+ */
+void KActorSystemDestroy( KActorSystem* pSystem );
+
+/**
+ * KActorInit - Initializes an actor with an empty mailbox.
+ * 
+ * 
+ * @param pActor - Actor to initialize.
+ * @param pSystem - System whose workers run the actor.
+ * @param fnHandler - Handles the messages of the actor.
+ * @param pContext - Client context, see KActorGetContext().
+ */
+void KActorInit( KActor* pActor, KActorSystem* pSystem, KActorHandler fnHandler, void* pContext );
+
+/**
+ * KActorSend - Appends a message to the mailbox of an actor and
+ * makes the actor ready if it was idle. Can be called from any
+ * thread, including from handlers. Messages sent by one thread 
+ * are handled in the order they were sent. 
+ * 
+ * 
+ * @param pActor - Destination.
+ * @param pMessage - Message, owned by the actor from then on.
+ */
+void KActorSend( KActor* pActor, KActorMessage* pMessage );
+
+/**
+ * KActorGetContext - Context given to KActorInit().
+ */
+void* KActorGetContext( KActor* pActor );
+
+#ifdef __cplusplus
+}
+#endif
+#endif // __ACTOR_H__
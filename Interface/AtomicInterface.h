@@ -0,0 +1,118 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __ATOMIC_INTERFACE_H__
+#define __ATOMIC_INTERFACE_H__
+
+#include <AtomicInterfaceImpl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup KAtomic - atomic variables
+ *  Word sized variables shared between threads without a lock.
+ *  Every operation takes the memory order it needs:
+ *  KATOMIC_RELAXED, KATOMIC_ACQUIRE, KATOMIC_RELEASE,
+ *  KATOMIC_ACQ_REL or KATOMIC_SEQ_CST, with the meaning they have
+ *  in C11. An acquire load that reads the value of a release
+ *  store sees everything written before that store. 
+ *
+ *  The variables are wrapped in a struct so that they can only
+ *  be accessed through these functions. Initialize them with
+ *  KATOMIC_INIT(), a relaxed store, or by zeroing their owner.
+ *  The functions are inline, the port decides how they are
+ *  implemented.
+ **/
+
+/**
+ * KAtomicLoad32 - Reads the variable.
+ */
+static inline uint32_t KAtomicLoad32( KAtomicU32* pAtomic, KAtomicOrder order );
+
+/**
+ * KAtomicStore32 - Writes the variable.
+ */
+static inline void KAtomicStore32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order );
+
+/**
+ * KAtomicExchange32 - Writes the variable.
+ *
+ * @return uint32_t - The value it replaced.
+ */
+static inline uint32_t KAtomicExchange32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order );
+
+/**
+ * KAtomicCompareExchange32 - Writes desired if the variable
+ * holds *pExpected. 
+ *
+ *
+ * @param pAtomic - Variable to update.
+ * @param pExpected - Value the variable must hold. Updated with 
+ *                  the value it did hold if it was different.
+ * @param desired - New value.
+ * @param order - Order of the exchange. A failed exchange only
+ *              loads and is never stronger than acquire.
+ *
+ * @return bool - true if the variable was updated.
+ */
+static inline bool KAtomicCompareExchange32( KAtomicU32* pAtomic, uint32_t* pExpected, uint32_t desired, KAtomicOrder order );
+
+/**
+ * KAtomicFetchAdd32 / KAtomicFetchSub32 / KAtomicFetchOr32 / 
+ * KAtomicFetchAnd32 - Read-modify-write of the variable. 
+ *
+ * @return uint32_t - The value before the operation.
+ */
+static inline uint32_t KAtomicFetchAdd32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order );
+static inline uint32_t KAtomicFetchSub32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order );
+static inline uint32_t KAtomicFetchOr32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order );
+static inline uint32_t KAtomicFetchAnd32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order );
+
+/**
+ * 64 bit variants, for time stamps and counters that would wrap. 
+ * They can take a lock on 32 bit targets. 
+ */
+static inline uint64_t KAtomicLoad64( KAtomicU64* pAtomic, KAtomicOrder order );
+static inline void KAtomicStore64( KAtomicU64* pAtomic, uint64_t value, KAtomicOrder order );
+static inline uint64_t KAtomicFetchAdd64( KAtomicU64* pAtomic, uint64_t value, KAtomicOrder order );
+
+/**
+ * Pointer variants, same semantics as the 32 bit ones.
+ */
+static inline void* KAtomicLoadPtr( KAtomicPtr* pAtomic, KAtomicOrder order );
+static inline void KAtomicStorePtr( KAtomicPtr* pAtomic, void* value, KAtomicOrder order );
+static inline void* KAtomicExchangePtr( KAtomicPtr* pAtomic, void* value, KAtomicOrder order );
+static inline bool KAtomicCompareExchangePtr( KAtomicPtr* pAtomic, void** pExpected, void* desired, KAtomicOrder order );
+
+/**
+ * KAtomicFence - Orders the memory accesses around it, for
+ * accesses that are not atomic themselves.
+ */
+static inline void KAtomicFence( KAtomicOrder order );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __ATOMIC_INTERFACE_H__
@@ -0,0 +1,93 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __BARRIER_H__
+#define __BARRIER_H__
+
+#include "BarrierImpl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup KBarrier - reusable thread barrier
+ *  Holds each of a fixed set of threads in KBarrierWait() till
+ *  all of them have called it, then lets them all go on to the
+ *  next phase. The barrier is reset by the last thread to
+ *  arrive, so the same threads can use it again right away.
+ *
+ *  It is sense reversing: a phase is released by flipping the
+ *  sense, which waiters can spin on, and only threads that gave
+ *  up spinning block on an event. The last thread releases
+ *  everyone with a single set of the event, and skips it if no
+ *  one blocked, instead of a semaphore put per thread. 
+ *
+ *  The last thread to arrive can run a callback, for instance to
+ *  merge the results of the phase, before anyone is let go.
+ **/
+
+/**
+ * @struct KBarrierDef - Parameters of KBarrierCreate().
+ */
+typedef struct _KBarrierDef
+{
+  const char* pName;
+  uint32_t threadCount;       /**< Threads taking part in every phase */
+  uint32_t spinCount;         /**< Times a waiter polls the barrier before blocking, 0 blocks right away */
+  KBarrierCallback fnLast;    /**< Optional, run by the last thread to arrive */
+  void* pContext;             /**< Passed to fnLast */
+}KBarrierDef;
+
+/**
+ * KBarrierCreate - Initializes a barrier.
+ * 
+ * 
+ * @param pBarrier - Barrier to initialize.
+ * @param pDef - Parameters of the barrier.
+ * 
+ * @return bool - true if created.
+ */
+bool KBarrierCreate( KBarrier* pBarrier, const KBarrierDef* pDef );
+
+/**
+ * KBarrierDestroy - Releases a barrier. No thread may be waiting
+ * on it. 
+ */
+void KBarrierDestroy( KBarrier* pBarrier );
+
+/**
+ * KBarrierWait - Waits for all the threads of the barrier to 
+ * arrive. 
+ * 
+ * 
+ * @param pBarrier - Barrier to wait on.
+ * 
+ * @return bool - true in the last thread to arrive, which ran 
+ *         the callback, false in the others.
+ */
+bool KBarrierWait( KBarrier* pBarrier );
+
+#ifdef __cplusplus
+}
+#endif
+#endif // __BARRIER_H__
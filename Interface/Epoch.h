@@ -0,0 +1,114 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __EPOCH_H__
+#define __EPOCH_H__
+
+#include "EpochImpl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup KEpoch - epoch based reclamation
+ *  Lets lock free structures free the nodes they unlink while
+ *  readers may still be looking at them. Readers bracket every
+ *  access with KEpochEnter() / KEpochExit(). A writer unlinks a
+ *  node and hands it to KEpochRetire(), which keeps it on the
+ *  limbo list of the calling thread till every thread that was
+ *  in a critical section at the time has left it. The node then
+ *  goes back to its MemPool.
+ *
+ *  A domain tracks a global epoch. It moves on once every thread
+ *  in a critical section has seen the current one, and a node
+ *  retired in epoch e is freed once the epoch reaches e + 2.
+ *  Every thread using a domain registers with it first and uses
+ *  the record it gets back, keeping it in a KThreadLocal is the
+ *  easy way to find it again.
+ *
+ *  A thread stuck in a critical section holds up every free in
+ *  the domain, so critical sections must be short and must not
+ *  block.
+ **/
+
+/**
+ * KEpochDomainCreate - Initializes a domain.
+ */
+void KEpochDomainCreate( KEpochDomain* pDomain );
+
+/**
+ * KEpochDomainDestroy - Frees every retired object. No thread 
+ * may use the domain anymore. 
+ */
+void KEpochDomainDestroy( KEpochDomain* pDomain );
+
+/**
+ * KEpochRegister - Registers the calling thread with a domain.
+ *
+ * @return KEpochThread* - Record of the thread, NULL if 
+ *         KEPOCH_THREADS_MAX threads are registered already.
+ */
+KEpochThread* KEpochRegister( KEpochDomain* pDomain );
+
+/**
+ * KEpochUnregister - Takes a thread out of its domain. Must be 
+ * called outside a critical section. Objects it retired that 
+ * can't be freed yet are left to the next thread that gets the 
+ * record, or to KEpochDomainDestroy(). 
+ */
+void KEpochUnregister( KEpochThread* pThread );
+
+/**
+ * KEpochEnter / KEpochExit - Bracket a read side critical 
+ * section. Nodes reached from within it stay valid till it is 
+ * left. They nest. 
+ */
+void KEpochEnter( KEpochThread* pThread );
+void KEpochExit( KEpochThread* pThread );
+
+/**
+ * KEpochRetire - Frees an object that has been unlinked, once no
+ * reader can still be looking at it. Every 
+ * KEPOCH_RECLAIM_BATCH retired objects the thread frees the 
+ * ones that are safe to. 
+ *
+ *
+ * @param pThread - Record of the calling thread.
+ * @param pNode - Embedded in the object.
+ * @param pPool - Pool the object goes back to.
+ * @param pObject - Object, as allocated from pPool.
+ */
+void KEpochRetire( KEpochThread* pThread, KEpochNode* pNode, MemPool* pPool, void* pObject );
+
+/**
+ * KEpochReclaim - Tries to move the epoch on and frees the 
+ * objects retired by the calling thread that are safe to. 
+ *
+ * @return uint32_t - Objects still waiting.
+ */
+uint32_t KEpochReclaim( KEpochThread* pThread );
+
+#ifdef __cplusplus
+}
+#endif
+#endif // __EPOCH_H__
@@ -0,0 +1,101 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __EVENT_INTERFACE_H__
+#define __EVENT_INTERFACE_H__
+
+#include <InterfacePrivateCommon.h>
+#include <PlatformInterface.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup KEvent - event flags
+ *  A set of flags that threads can set, clear and block on. A
+ *  thread that has to wait for one of several conditions
+ *  ( shutdown, data ready, a timer ) gives each its own flag and
+ *  waits for any of them in one call, instead of polling a
+ *  semaphore per condition. Only the flags in KEVENT_FLAGS_MASK
+ *  are portable, FreeRTOS event groups keep the top byte for
+ *  themselves.
+ **/
+
+#define KEVENT_FLAGS_MASK         ( 0x00FFFFFF )
+
+/**
+ * Options of KEventWait().
+ */
+#define KEVENT_WAIT_ANY           ( 0 )       /**< Wake up once any of the flags is set */
+#define KEVENT_WAIT_ALL           ( 1 << 0 )  /**< Wake up once all the flags are set */
+#define KEVENT_CLEAR_ON_EXIT      ( 1 << 1 )  /**< Clear the flags waited for before returning */
+
+bool KEventCreate( KEvent* pEvent, const char* pEventName );
+void KEventDelete( KEvent* pEvent );
+
+/**
+ * KEventSet - Sets flags and wakes up the threads whose wait is 
+ * satisfied by them. 
+ * 
+ * 
+ * @param pEvent - Event to set.
+ * @param flags - Flags to set.
+ * 
+ * @return uint32_t - The flags of the event once set. Waiters 
+ *         that clear on exit may already have cleared some.
+ */
+uint32_t KEventSet( KEvent* pEvent, uint32_t flags );
+
+/**
+ * KEventClear - Clears flags. 
+ * 
+ * @return uint32_t - The flags of the event before they were 
+ *         cleared.
+ */
+uint32_t KEventClear( KEvent* pEvent, uint32_t flags );
+
+/**
+ * KEventGet - Current flags of the event.
+ */
+uint32_t KEventGet( KEvent* pEvent );
+
+/**
+ * KEventWait - Waits for any, or all, of the flags to be set. 
+ * 
+ * 
+ * @param pEvent - Event to wait on.
+ * @param flags - Flags to wait for.
+ * @param options - KEVENT_WAIT_ANY or KEVENT_WAIT_ALL, optionally 
+ *                with KEVENT_CLEAR_ON_EXIT.
+ * @param timeout - Time in ms to wait, NO_SLEEP or WAIT_FOREVER.
+ * 
+ * @return uint32_t - The flags of the event when the wait was 
+ *         satisfied, before any clearing. 0 if it timed out.
+ */
+uint32_t KEventWait( KEvent* pEvent, uint32_t flags, uint32_t options, uint32_t timeout );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EVENT_INTERFACE_H__
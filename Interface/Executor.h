@@ -0,0 +1,162 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __EXECUTOR_H__
+#define __EXECUTOR_H__
+
+#include "ExecutorImpl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup KExecutor - work stealing task executor
+ *  An executor runs small tasks ( a function and an argument )
+ *  on a fixed set of worker threads, by default one per core.
+ *  Every worker has its own deque of tasks. Tasks spawned from
+ *  within a task are pushed onto the deque of the worker running
+ *  it and are normally run by that same worker, last in first
+ *  out. Workers that run out of work steal the oldest tasks from
+ *  the other workers, so that skewed load still spreads over all
+ *  the cores. Tasks submitted from outside the executor go to a
+ *  shared injection queue.
+ *
+ *  All storage, tasks and deques, comes from a backing store
+ *  provided by the client, see KEXECUTOR_DEF().
+ **/
+
+/**
+ * @struct KExecutorDef - Parameters of KExecutorCreate().
+ */
+typedef struct _KExecutorDef
+{
+  const char* pName;
+  uint32_t workerCount;       /**< 0 for one worker per core, capped at KEXECUTOR_WORKERS_MAX */
+  uint32_t stackSize;         /**< Stack size of each worker */
+  uint32_t priority;
+  void* pStack;               /**< Optional, stackSize bytes for each worker, one after the other */
+  uint8_t* pBackingStore;     /**< KEXECUTOR_BACKING_STORE_SIZE( dequeDepth, taskCount ) bytes */
+  uint32_t dequeDepth;        /**< Tasks each worker can hold, power of 2 */
+  uint32_t taskCount;         /**< Max tasks in flight */
+}KExecutorDef;
+
+/**
+ * KExecutorCreate - Initializes an executor and starts its
+ * workers.
+ * 
+ * 
+ * @param pExecutor - Executor to initialize, see KEXECUTOR_DEF().
+ * @param pDef - Parameters of the executor.
+ * 
+ * @return bool - true if created.
+ */
+bool KExecutorCreate( KExecutor* pExecutor, const KExecutorDef* pDef );
+
+/**
+ * KExecutorDestroy - Stops the workers and waits for them to
+ * exit. Tasks that have not started by then are dropped. Must
+ * not be called from a task.
+ * 
+ * 
+ * @param pExecutor - Executor to destroy.
+ */
+void KExecutorDestroy( KExecutor* pExecutor );
+
+/**
+ * KExecutorGetWorkerCount - Number of workers of the executor.
+ */
+uint32_t KExecutorGetWorkerCount( KExecutor* pExecutor );
+
+/**
+ * KExecutorSubmit - Submits a task from any thread. The task is
+ * queued on the injection queue of the executor and picked up by
+ * the first idle worker.
+ * 
+ * 
+ * @param pExecutor - Executor to run the task.
+ * @param pGroup - Optional, group the task is counted against.
+ * @param fn - Task function.
+ * @param arg - Argument of fn.
+ * 
+ * @return bool - false if all the tasks of the executor are in 
+ *         use.
+ */
+bool KExecutorSubmit( KExecutor* pExecutor, KTaskGroup* pGroup, KExecutorTaskFn fn, void* arg );
+
+/**
+ * KExecutorSpawn - Spawns a task from within a task. The task is
+ * pushed onto the deque of the calling worker where idle workers
+ * can steal it. If the deque is full, or no task is available,
+ * the task is run right away on the calling worker instead.
+ * 
+ * 
+ * @param pWorker - Worker passed to the calling task.
+ * @param pGroup - Optional, group the task is counted against.
+ * @param fn - Task function.
+ * @param arg - Argument of fn.
+ */
+void KExecutorSpawn( KExecutorWorker* pWorker, KTaskGroup* pGroup, KExecutorTaskFn fn, void* arg );
+
+/**
+ * KExecutorJoin - Waits from within a task for all the tasks of
+ * a group to complete. The calling worker keeps running other
+ * tasks while it waits.
+ * 
+ * 
+ * @param pWorker - Worker passed to the calling task.
+ * @param pGroup - Group to wait for.
+ */
+void KExecutorJoin( KExecutorWorker* pWorker, KTaskGroup* pGroup );
+
+/**
+ * KTaskGroupInit - Initializes an empty task group.
+ * 
+ * 
+ * @param pGroup - Group to initialize.
+ * 
+ * @return bool - true if initialized.
+ */
+bool KTaskGroupInit( KTaskGroup* pGroup );
+
+/**
+ * KTaskGroupDestroy - Releases a task group. The group must not 
+ * have pending tasks.
+ */
+void KTaskGroupDestroy( KTaskGroup* pGroup );
+
+/**
+ * KTaskGroupWait - Blocks a thread outside the executor till all
+ * the tasks of a group have completed. From within a task use
+ * KExecutorJoin() instead. Only one thread may wait on a group
+ * at a time.
+ * 
+ * 
+ * @param pGroup - Group to wait for.
+ */
+void KTaskGroupWait( KTaskGroup* pGroup );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EXECUTOR_H__
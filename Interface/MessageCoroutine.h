@@ -0,0 +1,170 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __MESSAGE_COROUTINE_H__
+#define __MESSAGE_COROUTINE_H__
+
+#include "MessageThread.h"
+#include "MessageCoroutineImpl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup MessageCoroutine - Stackless coroutines run by a 
+ *  message thread. 
+ *  A coroutine handler can wait for the reply to a message,
+ *  for a delay or for a free message without blocking its
+ *  message thread, the thread keeps processing other messages
+ *  and resumes the coroutine once the awaited event happens.
+ *  Multi step protocols can then be written as straight line
+ *  code instead of a hand written state machine.
+ *
+ *  Coroutines are built on a switch statement ( protothreads ),
+ *  so they have no stack of their own:
+ *  - Local variables don't survive an await, keep state in
+ *    pArg.
+ *  - Awaits can only be used in the body of the coroutine
+ *    itself, not in functions it calls.
+ *  - The body can't have a switch statement of its own spanning
+ *    an await.
+ *
+ *  Example:
+ *  @code
+ *  static MessageCoStatus Exchange( MessageCoroutine* pCo, void* pArg )
+ *  {
+ *    ExchangeState* pState = ( ExchangeState* )pArg;
+ *    MESSAGE_CO_BEGIN( pCo );
+ *    MESSAGE_CO_AWAIT_ALLOC( pCo, pState->hPeer, pState->hRequest );
+ *    MESSAGE_CO_AWAIT_CALL( pCo, pState->hPeer, pState->hRequest );
+ *    pState->hReply = MessageCoroutineGetReply( pCo );
+ *    MESSAGE_CO_AWAIT_DELAY( pCo, 1000 );
+ *    MESSAGE_CO_END( pCo );
+ *  }
+ *  @endcode
+ */
+
+#define MESSAGE_CO_BEGIN( pCo )       switch( ( pCo )->resumeLine ) { case 0:
+#define MESSAGE_CO_END( pCo )         } ( pCo )->resumeLine = 0; return MESSAGE_CO_DONE
+
+/**
+ * Returns to the message thread, the coroutine continues from 
+ * here once it is woken up. Only used by the awaits below. The 
+ * resume point must be saved before the wake up is armed, the 
+ * coroutine may be resumed by another worker right away. 
+ */
+#define MESSAGE_CO_SUSPEND( pCo, fnArmWakeUp )\
+  do { ( pCo )->resumeLine = __LINE__; fnArmWakeUp; return MESSAGE_CO_WAITING; case __LINE__: ; } while( 0 )
+
+/**
+ * Lets the thread process the messages already in its Q before 
+ * the coroutine continues. 
+ */
+#define MESSAGE_CO_YIELD( pCo )\
+  MESSAGE_CO_SUSPEND( pCo, MessageCoroutineSleep( ( pCo ), 0 ) )
+
+/**
+ * Continues after delayUs, rounded up to MESSAGE_TIMER_TICK_US. 
+ */
+#define MESSAGE_CO_AWAIT_DELAY( pCo, delayUs )\
+  MESSAGE_CO_SUSPEND( pCo, MessageCoroutineSleep( ( pCo ), ( delayUs ) ) )
+
+/**
+ * Posts hMessage to hThread and continues once it has been 
+ * processed. MessageCoroutineGetReply() then returns the 
+ * message. 
+ */
+#define MESSAGE_CO_AWAIT_CALL( pCo, hThread, hMessage )\
+  MESSAGE_CO_SUSPEND( pCo, MessageCoroutineCall( ( pCo ), ( hThread ), ( hMessage ) ) )
+
+/**
+ * Allocates a message of hThread into hMessage, which must be 
+ * kept outside the coroutine. While hThread has no free message 
+ * the allocation is tried again every MESSAGE_TIMER_TICK_US. 
+ */
+#define MESSAGE_CO_AWAIT_ALLOC( pCo, hThread, hMessage )\
+  do {\
+    while( !( ( hMessage ) = MessageThreadTryAllocateMessage( ( hThread ) ) ) ) {\
+      MESSAGE_CO_SUSPEND( pCo, MessageCoroutineSleep( ( pCo ), MESSAGE_TIMER_TICK_US ) );\
+    }\
+  } while( 0 )
+
+/**
+ * MessageCoroutineStart - Starts a coroutine on a message 
+ * thread. The coroutine first runs on the thread, not in this 
+ * call, so it can be started from anywhere. 
+ *
+ * The coroutine must stay allocated, and must not be started 
+ * again, till it runs to MESSAGE_CO_END() or the thread is 
+ * destroyed. Wake ups are never dropped, whatever the overflow 
+ * policy of the thread. 
+ *
+ *
+ * @param hThread - Thread that runs the coroutine 
+ * @param pCo - Coroutine 
+ * @param fn - Body of the coroutine 
+ * @param pArg - Passed to fn, holds the state of the coroutine 
+ *
+ * @return bool - true if started.
+ */
+bool MessageCoroutineStart( MessageThreadHandle hThread, MessageCoroutine* pCo, MessageCoroutineFn fn, void* pArg );
+
+/**
+ * MessageCoroutineGetThread - Gets the thread running the 
+ * coroutine. 
+ */
+MessageThreadHandle MessageCoroutineGetThread( MessageCoroutine* pCo );
+
+/**
+ * MessageCoroutineGetReply - Gets the message handed back by 
+ * the last MESSAGE_CO_AWAIT_CALL(). The coroutine owns it and 
+ * must destroy it on the thread it was called on. 
+ *
+ *
+ * @param pCo - Coroutine 
+ *
+ * @return MessageHandle - The processed message, NULL if it was 
+ *         dropped instead of processed.
+ */
+MessageHandle MessageCoroutineGetReply( MessageCoroutine* pCo );
+
+/**
+ * Used by MESSAGE_CO_AWAIT_CALL(). Works like 
+ * MessageThreadCall(), except that the coroutine is woken up 
+ * instead of the caller being blocked. The called thread must 
+ * not be destroyed while the call is pending. 
+ */
+void MessageCoroutineCall( MessageCoroutine* pCo, MessageThreadHandle hThread, MessageHandle hMessage );
+
+/**
+ * Used by the awaits above. Wakes the coroutine up after delayUs, 
+ * or once the messages queued before it are processed if 
+ * delayUs is 0. 
+ */
+void MessageCoroutineSleep( MessageCoroutine* pCo, uint32_t delayUs );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MESSAGE_COROUTINE_H__
@@ -30,8 +30,155 @@
 extern "C" {
 #endif
 bool MessageQueueInitialize( MessageQueue* pQueue, void** pQueueStore, uint32_t queueSize );
+
+/**
+ * MessageQueueInitializeCoalescing - Initializes a keyed, latest
+ * wins queue. If an item is enqueued while an item with the same
+ * key is still pending, it replaces ( or is merged into ) the
+ * pending item, which keeps its position in the queue, instead
+ * of being appended. The depth of the queue is thus bounded by
+ * the number of distinct keys.
+ *
+ * Items that are displaced this way are handed to the discard
+ * handler ( see MessageQueueSetDiscardHandler() ).
+ *
+ *
+ * @param pQueue - Queue to initialize
+ * @param pQueueStore - Storage for queueSize item pointers
+ * @param queueSize - Max items in the queue
+ * @param pIndexStore - Storage for the key index. Must hold
+ *                    MESSAGE_QUEUE_INDEX_SIZE( queueSize )
+ *                    entries.
+ * @param fnKey - Returns the key of an item
+ * @param fnMerge - Optional, merges a new item into a pending
+ *                one.
+ *
+ * @return bool - true if initialized.
+ */
+bool MessageQueueInitializeCoalescing( MessageQueue* pQueue,
+                                       void** pQueueStore,
+                                       uint32_t queueSize,
+                                       MessageQueueIndexEntry* pIndexStore,
+                                       MessageQueueKey fnKey,
+                                       MessageQueueMerge fnMerge );
+
+/**
+ * MessageQueueSetDiscardHandler - Sets the function called for
+ * items that the queue drops instead of delivering.
+ *
+ *
+ * @param pQueue - Initialized queue
+ * @param fnDiscard - Discard handler
+ */
+void MessageQueueSetDiscardHandler( MessageQueue* pQueue, MessageQueueDiscard fnDiscard );
+
+/**
+ * MessageQueueSetEvictFilter - Sets the function that tells
+ * MESSAGE_QUEUE_OVERFLOW_DROP_OLDEST which pending items it may
+ * drop. Without one any item may be dropped. If none of the
+ * pending items may be dropped the item being enqueued is
+ * discarded instead.
+ *
+ *
+ * @param pQueue - Initialized queue
+ * @param fnEvictable - Evict filter
+ */
+void MessageQueueSetEvictFilter( MessageQueue* pQueue, MessageQueueEvictable fnEvictable );
+
+/**
+ * MessageQueueSetContext - Sets the context pointer passed to
+ * all the queue callbacks.
+ *
+ *
+ * @param pQueue - Initialized queue
+ * @param pContext - Client context
+ */
+void MessageQueueSetContext( MessageQueue* pQueue, void* pContext );
+
+/**
+ * MessageQueueSetOverflowPolicy - Sets what the queue does when
+ * an item is enqueued while it is full. The default is to block.
+ * Items dropped by the DROP policies are handed to the discard
+ * handler.
+ *
+ *
+ * @param pQueue - Initialized queue
+ * @param policy - Overflow policy
+ * @param timeout - Time in ms to wait for
+ *                MESSAGE_QUEUE_OVERFLOW_BLOCK_DEADLINE, ignored
+ *                otherwise.
+ */
+void MessageQueueSetOverflowPolicy( MessageQueue* pQueue, MessageQueueOverflowPolicy policy, uint32_t timeout );
+
+/**
+ * MessageQueueSetSpin - Makes MessageQueueDeQueue() poll an empty
+ * queue for up to spinUs microseconds before it blocks. An item
+ * that shows up in that window is picked up without the consumer
+ * ever sleeping, and since no consumer is waiting on the
+ * semaphore the producer's post doesn't have to wake anyone up.
+ * This trades a busy core for wake-up latency, it only pays off
+ * when the producer runs on another core. 0 ( the default )
+ * blocks right away.
+ *
+ *
+ * @param pQueue - Initialized queue
+ * @param spinUs - Time in us to poll before blocking
+ */
+void MessageQueueSetSpin( MessageQueue* pQueue, uint32_t spinUs );
+
+/**
+ * MessageQueueGetStats - Gets a copy of the overflow, coalescing
+ * and wait counters of the queue.
+ *
+ *
+ * @param pQueue - Initialized queue
+ * @param pStats - Filled in with the counters
+ */
+void MessageQueueGetStats( MessageQueue* pQueue, MessageQueueStats* pStats );
 void MessageQueueDeInitialize( MessageQueue* pQueue );
+
+/**
+ * MessageQueueEnQueue - Enqueues an item, applying the overflow
+ * policy of the queue if it is full.
+ *
+ *
+ * @param pQueue - Initialized queue
+ * @param pItem - Item to enqueue
+ *
+ * @return bool - true if the queue took ownership of the item.
+ *         That includes items that were coalesced or dropped.
+ */
 bool MessageQueueEnQueue( MessageQueue* pQueue, void *pItem );
+
+/**
+ * MessageQueueEnQueueEx - Same as MessageQueueEnQueue() with the
+ * overflow policy given for this call only.
+ */
+bool MessageQueueEnQueueEx( MessageQueue* pQueue,
+                            void *pItem,
+                            MessageQueueOverflowPolicy policy,
+                            uint32_t timeout );
+
+/**
+ * MessageQueueEnQueueFrom - Enqueues an item that is only
+ * produced once the queue has a slot for it. fnProduce is called
+ * with the queue lock held, in the same critical section that
+ * publishes the item, so it must be short and must not touch
+ * the queue. While the queue is full fnProduce is only called
+ * when the item may go in without a slot, that is on coalescing
+ * queues and with MESSAGE_QUEUE_OVERFLOW_DROP_OLDEST. Produced
+ * items that are then rejected are handed to the discard
+ * handler.
+ *
+ *
+ * @param pQueue - Initialized queue
+ * @param fnProduce - Returns the item to enqueue
+ * @param pArg - Argument of fnProduce
+ *
+ * @return bool - true if an item was produced and the queue
+ *         took ownership of it.
+ */
+bool MessageQueueEnQueueFrom( MessageQueue* pQueue, MessageQueueProduce fnProduce, void* pArg );
 void* MessageQueueDeQueue( MessageQueue* pQueue );
 
 #ifdef __cplusplus
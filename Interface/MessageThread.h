@@ -28,14 +28,14 @@
 #include <stdbool.h>
 #include "klist.h"
 #include "Pool.h"
+#include "ThreadInterface.h"
 #include "MessageThreadImpl.h"
+#include <AbstractUtilsConfig.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define MESSAGE_THREADS_MAX            ( 5 )
-
 typedef void* MessageHandle;
 typedef const void* MessageThreadHandle;
 
@@ -57,6 +57,113 @@ typedef void (*MessageThreadInit)( MessageThreadHandle hThread );
  */
 typedef void (*MessageThreadProcess)( MessageThreadHandle hThread, MessageHandle hMessage );
 
+/**
+ * Used by coalescing message threads to get the key of a 
+ * message. A message posted while another message with the 
+ * same key is still pending replaces it instead of being 
+ * queued. 
+ *  
+ * @param hMessage - Handle to the message. 
+ * @param pKey - Filled in with the key of the message. 
+ *  
+ * @return bool - false if the message must never be coalesced.
+ */
+typedef bool (*MessageThreadMessageKey)( MessageHandle hMessage, uint32_t* pKey );
+
+/**
+ * Optional merge function of a coalescing message thread. 
+ * Called when hNew is posted while hPending, with the same key, 
+ * is still in the queue. 
+ *  
+ * @param hPending - Handle to the message already in the queue.
+ * @param hNew - Handle to the message being posted. 
+ *  
+ * @return MessageHandle - the message that stays in the queue. 
+ *         The other one is destroyed.
+ */
+typedef MessageHandle (*MessageThreadMessageMerge)( MessageHandle hPending, MessageHandle hNew );
+
+/**
+ * Fills in a message for MessageThreadPostFill(). Called with 
+ * the queue of the thread locked, it must be short and must not 
+ * call into the thread. 
+ *  
+ * @param hMessage - Handle to the freshly allocated message. 
+ * @param pArg - Argument given to MessageThreadPostFill(). 
+ */
+typedef void (*MessageThreadMessageFill)( MessageHandle hMessage, void* pArg );
+
+/**
+ * Number of buckets of the process time histogram. Bucket 0 
+ * counts calls under 1us, bucket i calls of [ 2^(i-1), 2^i ) 
+ * us. The last bucket also counts all the longer calls. 
+ */
+#define MESSAGE_THREAD_STATS_BUCKETS    ( 20 )
+
+/**
+ * @struct MessageThreadStats 
+ * @brief - Handler profile of a message thread, summed over its 
+ *        workers. The busy / idle ratio is busyUs / ( busyUs +
+ *        idleUs ). 
+ */
+typedef struct _MessageThreadStats
+{
+  const char* threadName;
+  uint32_t workerCount;
+  uint64_t elapsedUs;         /**< Since the thread was created */
+  uint64_t processed;         /**< Messages handed to fnProcess */
+  uint32_t messagesPerSec;    /**< processed over elapsedUs */
+  uint64_t busyUs;            /**< Time spent in fnProcess */
+  uint64_t idleUs;            /**< Time spent waiting on the message Q */
+  uint32_t maxProcessUs;      /**< Longest fnProcess call */
+  uint32_t histogram[ MESSAGE_THREAD_STATS_BUCKETS ];   /**< fnProcess call durations, log2 scale */
+  uint32_t queueOverruns;     /**< Messages that waited in the Q longer than queueBudgetUs */
+  uint32_t processOverruns;   /**< fnProcess calls that took longer than processBudgetUs */
+  uint32_t stuck;             /**< fnProcess calls the watchdog caught still running past processBudgetUs */
+}MessageThreadStats;
+
+/**
+ * Called by MessageThreadForEach() for every live message 
+ * thread. 
+ *  
+ * @param pContext - Context given to MessageThreadForEach() 
+ * @param hThread - Handle to the message thread 
+ * @param pStats - Profile of the thread 
+ */
+typedef void (*MessageThreadVisit)( void* pContext, MessageThreadHandle hThread, const MessageThreadStats* pStats );
+
+typedef enum
+{
+  MESSAGE_LATENCY_QUEUE = 0,  /**< A message waited in the Q longer than queueBudgetUs */
+  MESSAGE_LATENCY_PROCESS,    /**< fnProcess returned after more than processBudgetUs */
+  MESSAGE_LATENCY_STUCK,      /**< fnProcess is still running past processBudgetUs */
+}MessageLatencyKind;
+
+/**
+ * @struct MessageLatencyEvent 
+ * @brief - A latency budget overrun recorded by the message 
+ *        watchdog. 
+ */
+typedef struct _MessageLatencyEvent
+{
+  MessageLatencyKind kind;
+  const char* threadName;
+  MessageThreadHandle hThread;
+  MessageHandle hMessage;     /**< Identifies the message only, it may be gone by now */
+  uint32_t durationUs;        /**< Time in the Q, in fnProcess, or so far for MESSAGE_LATENCY_STUCK */
+  uint32_t budgetUs;
+  uint64_t timeUs;            /**< KTimeGetMicroseconds() when recorded */
+}MessageLatencyEvent;
+
+/**
+ * Called by the watchdog thread for every latency budget 
+ * overrun. See MessageThreadSetLatencyCallback(). 
+ *  
+ * @param pContext - Context given with the callback 
+ * @param pEvent - The overrun 
+ */
+typedef void (*MessageLatencyCallback)( void* pContext, const MessageLatencyEvent* pEvent );
+
 /**
  * @struct MessageThreadDef 
  * @brief - Message thread initialization structure 
@@ -77,6 +184,17 @@ typedef struct _MessageThreadDef
   void *pPrivateData;       /**< Private data that is passed to the thread functions. Holds thread state. */
   MessageThreadInit fnInit; /**< Thread Initialization function */
   MessageThreadProcess fnProcess; /**< Function to process each incoming message */
+  MessageThreadMessageKey fnMessageKey;     /**< Optional. Makes the message Q coalescing ( latest wins ). Needs 
+                                                 MESSAGE_THREAD_COALESCING_BACKING_STORE_SIZE() of backing store */
+  MessageThreadMessageMerge fnMessageMerge; /**< Optional. Merges a message into the pending one with the same key */
+  MessageQueueOverflowPolicy overflowPolicy; /**< What MessageThreadPost() does when the Q is full. Blocks by default */
+  uint32_t overflowTimeout;                  /**< Time in ms for MESSAGE_QUEUE_OVERFLOW_BLOCK_DEADLINE */
+  uint32_t workerCount;     /**< Threads draining the message Q, 0 is the same as 1. See MESSAGE_THREAD_GROUP_DEF() */
+  void* pStack;             /**< Optional. workerCount * stackSize bytes, for ports that can't allocate stacks */
+  KThreadSchedParams sched; /**< Optional. Policy, CPU affinity and nice value of the workers */
+  uint32_t spinUs;          /**< Optional. Time in us an idle worker polls the Q before it blocks. See MessageQueueSetSpin() */
+  uint32_t processBudgetUs; /**< Optional. Longest fnProcess call in us before the watchdog reports it */
+  uint32_t queueBudgetUs;   /**< Optional. Longest wait of a message in the Q in us before the watchdog reports it */
 }MessageThreadDef;
 
 /**
@@ -97,8 +215,62 @@ const MessageThreadDef messageThreadDef_##name =\
   .fnProcess = process\
 }
 
+/**
+ * Same as MESSAGE_THREAD_DEF() but for a thread whose messages 
+ * carry a key. Only the latest message for each key is kept in 
+ * the queue. 
+ */
+#define MESSAGE_THREAD_COALESCING_DEF( name, stkSz, pri, msgBackStore, qDepth, msgType, priv, init, process, key, merge )\
+const MessageThreadDef messageThreadDef_##name =\
+{\
+  .threadName = #name,\
+  .stackSize = stkSz,\
+  .priority = pri,\
+  .messageBackingStore = msgBackStore,\
+  .messageQDepth = qDepth,\
+  .messageSize = sizeof(msgType),\
+  .pPrivateData = priv,\
+  .fnInit = init,\
+  .fnProcess = process,\
+  .fnMessageKey = key,\
+  .fnMessageMerge = merge\
+}
+
+/**
+ * Defines a MessageThreadGroup, a message thread with several 
+ * workers that drain its message Q, so that messages can be 
+ * processed in parallel. The group is used like any other 
+ * message thread. fnInit is called once, by the first worker. 
+ * Messages are processed concurrently and may complete out of 
+ * order, the process function must be thread safe. 
+ */
+#define MESSAGE_THREAD_GROUP_DEF( name, stkStore, stkSz, pri, msgBackStore, qDepth, msgType, priv, init, process, workers )\
+const MessageThreadDef messageThreadDef_##name =\
+{\
+  .threadName = #name,\
+  .stackSize = stkSz,\
+  .priority = pri,\
+  .messageBackingStore = msgBackStore,\
+  .messageQDepth = qDepth,\
+  .messageSize = sizeof(msgType),\
+  .pPrivateData = priv,\
+  .fnInit = init,\
+  .fnProcess = process,\
+  .workerCount = workers,\
+  .pStack = stkStore\
+}
+
 #define MESSAGE_THREAD( name ) &messageThreadDef_##name
 
+/**
+ * Initializes the message thread system. Must be called before 
+ * any message thread is created, later calls do nothing. Starts the timer 
+ * service used by MessageThreadPostDelayed() and 
+ * MessageThreadPostPeriodic() and creates the wait slots of 
+ * MessageThreadCall(). 
+ */
+void MessageThreadSystemInit( void );
+
 /**
  * Used to create a message thread. It is not safe to post 
  * events to the message thread till this function returns. The 
@@ -113,6 +285,16 @@ const MessageThreadDef messageThreadDef_##name =\
  */
 MessageThreadHandle MessageThreadCreate( const MessageThreadDef *pThreadDef );
 
+/**
+ * Destroys a message thread. Messages already in the Q are 
+ * processed first. Blocks till all the workers of the thread 
+ * have exited, so it must not be called from the thread 
+ * itself. 
+ * 
+ * 
+ * @param hThread: MessageThreadHandle - Handle to message 
+ *               thread.
+ */
 void MessageThreadDestroy( MessageThreadHandle hThread );
 /**
  * Used to get a pointer to the private data that was supplied 
@@ -140,6 +322,19 @@ void* MessageThreadGetPrivateData( MessageThreadHandle hThread );
  */
 MessageHandle MessageThreadAllocateMessage( MessageThreadHandle hThread );
 
+/**
+ * Same as MessageThreadAllocateMessage(), but returns NULL 
+ * instead of asserting when the thread has no free message. 
+ * 
+ * 
+ * @param hThread: MessageThreadHandle - Handle to message 
+ *               thread.
+ * 
+ * @return MessageHandle - Handle to message, NULL if none is 
+ *         free.
+ */
+MessageHandle MessageThreadTryAllocateMessage( MessageThreadHandle hThread );
+
 /**
  * Used to destroy a message. External clients don't have to 
  * call this function if the messsage is posted to the thread. 
@@ -156,17 +351,203 @@ void MessageThreadDestroyMessage( MessageThreadHandle hThread, MessageHandle* ph
 /**
  * Used to post messages to the message thread. Clients should 
  * combine this with MessageThreadAllocate to make a convenience 
- * routine to post events to their threads. 
+ * routine to post events to their threads. If the message Q is 
+ * full the overflow policy of the thread is applied. The thread 
+ * owns the message once this is called, if it can't be posted 
+ * it is destroyed. 
  * 
  * 
  * @param hThread: MessageThreadHandle - Handle to message 
  *               thread
  * @param hMessage: MessageHandle - Handle to message
  * 
- * @return bool - True if the event has been posted.
+ * @return bool - True if the event has been posted ( this 
+ *         includes messages coalesced or dropped by the
+ *         overflow policy ).
  */
 bool MessageThreadPost( MessageThreadHandle hThread, MessageHandle hMessage );
 
+/**
+ * Allocates, fills in and posts a message in one step. The 
+ * message is only allocated once the Q has room for it, and is 
+ * allocated, filled in and queued in the same critical section 
+ * of the Q, so that a post costs one lock of the Q instead of 
+ * the separate allocate, slot wait and queue steps of 
+ * MessageThreadAllocateMessage() and MessageThreadPost(). A 
+ * failed post leaves nothing to clean up. 
+ * 
+ * 
+ * @param hThread: MessageThreadHandle - Handle to message 
+ *               thread
+ * @param fnFill - Fills in the message.
+ * @param pArg - Argument of fnFill.
+ * 
+ * @return bool - False if the thread had no free message, or if 
+ *         the overflow policy failed the post.
+ */
+bool MessageThreadPostFill( MessageThreadHandle hThread, MessageThreadMessageFill fnFill, void* pArg );
+
+/**
+ * MessageThreadPostFill() that copies size bytes of pPayload 
+ * into the message. size must not exceed the message size of 
+ * the thread, the rest of the message is left as allocated. 
+ */
+bool MessageThreadPostCopy( MessageThreadHandle hThread, const void* pPayload, uint32_t size );
+
+/**
+ * Posts a message to the message thread and blocks till the 
+ * thread has processed it, for request / response exchanges 
+ * between threads. The process callback writes its response 
+ * into the message itself, which is then copied to pReply. The 
+ * caller waits on one of MESSAGE_THREAD_CALL_SLOTS_MAX wait 
+ * slots created by MessageThreadSystemInit(), so no semaphore 
+ * is created per call. Must not be called from the thread 
+ * itself. As with MessageThreadPost() the thread owns the 
+ * message once this is called. 
+ * 
+ * 
+ * @param hThread: MessageThreadHandle - Handle to message 
+ *               thread
+ * @param hMessage: MessageHandle - Handle to the request
+ * @param pReply: void* - Optional. Receives the processed 
+ *              message, messageSize bytes.
+ * @param timeout: uint32_t - Time in ms to wait for the message 
+ *               to be processed, once it has been posted. On a 
+ *               timeout the message is still processed, but the 
+ *               response is discarded.
+ * 
+ * @return bool - True if the message was processed and pReply 
+ *         filled in. False on a timeout, if the message was
+ *         dropped by the Q or if no wait slot is free.
+ */
+bool MessageThreadCall( MessageThreadHandle hThread, MessageHandle hMessage, void* pReply, uint32_t timeout );
+
+/**
+ * Posts a message to the message thread after a delay. No 
+ * thread or allocation is needed per timer, the message itself 
+ * is armed in the timer service. When the delay expires the 
+ * message is posted without blocking the timer service; if the 
+ * Q is full it is retried on every timer tick, unless the 
+ * overflow policy of the thread drops it. The thread owns the 
+ * message once this is called. 
+ * 
+ * 
+ * @param hThread: MessageThreadHandle - Handle to message 
+ *               thread
+ * @param hMessage: MessageHandle - Handle to message
+ * @param delayUs: uint32_t - Delay in microseconds, rounded up 
+ *               to MESSAGE_TIMER_TICK_US. 0 posts right away.
+ * 
+ * @return bool - True if the message was armed ( false if it 
+ *         already is ).
+ */
+bool MessageThreadPostDelayed( MessageThreadHandle hThread, MessageHandle hMessage, uint32_t delayUs );
+
+/**
+ * Posts a copy of a message to the message thread every 
+ * period. The message is kept by the timer service as a 
+ * template, the copies are allocated from the message pool of 
+ * the thread. A period is skipped if the pool or the Q is full. 
+ * Use MessageThreadCancelTimer() to stop it. 
+ * 
+ * 
+ * @param hThread: MessageThreadHandle - Handle to message 
+ *               thread
+ * @param hMessage: MessageHandle - Handle to the template 
+ *                message
+ * @param periodUs: uint32_t - Period in microseconds, rounded 
+ *                up to MESSAGE_TIMER_TICK_US.
+ * 
+ * @return bool - True if the message was armed.
+ */
+bool MessageThreadPostPeriodic( MessageThreadHandle hThread, MessageHandle hMessage, uint32_t periodUs );
+
+/**
+ * Cancels a message armed with MessageThreadPostDelayed() or 
+ * MessageThreadPostPeriodic() and destroys it. The handle is 
+ * only valid till a delayed message has been processed by the 
+ * thread. 
+ * 
+ * 
+ * @param hThread: MessageThreadHandle - Handle to message 
+ *               thread
+ * @param hMessage: MessageHandle - Handle to the armed message
+ * 
+ * @return bool - True if the message was still armed. False if 
+ *         it was already posted.
+ */
+bool MessageThreadCancelTimer( MessageThreadHandle hThread, MessageHandle hMessage );
+
+/**
+ * Gets the overflow / coalescing counters of the message Q of 
+ * the thread. 
+ * 
+ * 
+ * @param hThread: MessageThreadHandle - Handle to message 
+ *               thread
+ * @param pStats: MessageQueueStats* - Filled in with the 
+ *              counters.
+ */
+void MessageThreadGetQueueStats( MessageThreadHandle hThread, MessageQueueStats* pStats );
+
+/**
+ * Gets the handler profile of the thread. Every worker keeps its 
+ * own counters, updated with two clock reads per message, so 
+ * profiling is always on. The counters are read while the 
+ * workers run, the snapshot is consistent to within the message 
+ * being processed. 
+ * 
+ * 
+ * @param hThread: MessageThreadHandle - Handle to message 
+ *               thread
+ * @param pStats: MessageThreadStats* - Filled in with the 
+ *              profile.
+ */
+void MessageThreadGetStats( MessageThreadHandle hThread, MessageThreadStats* pStats );
+
+/**
+ * Calls fnVisit with the profile of every live message thread. 
+ * Threads can't be created or destroyed while this runs, 
+ * fnVisit must not create or destroy message threads. 
+ * 
+ * 
+ * @param fnVisit: MessageThreadVisit - Called for every thread 
+ * @param pContext: void* - Passed to fnVisit 
+ * 
+ * @return uint32_t - Number of threads visited.
+ */
+uint32_t MessageThreadForEach( MessageThreadVisit fnVisit, void* pContext );
+
+/**
+ * Sets the function the message watchdog calls for every 
+ * latency budget overrun ( see processBudgetUs and 
+ * queueBudgetUs in MessageThreadDef ). The callback runs on the 
+ * low priority watchdog thread, never on the message thread 
+ * that overran. Events recorded faster than it keeps up with 
+ * are skipped, they can still be counted in the thread stats. 
+ * 
+ * 
+ * @param fnCallback: MessageLatencyCallback - NULL to stop 
+ *                  the callbacks.
+ * @param pContext: void* - Passed to fnCallback
+ */
+void MessageThreadSetLatencyCallback( MessageLatencyCallback fnCallback, void* pContext );
+
+/**
+ * Copies the latest latency budget overruns, the watchdog keeps 
+ * the last MESSAGE_LATENCY_RING_SIZE of them. 
+ * 
+ * 
+ * @param pEvents: MessageLatencyEvent* - Filled in with the 
+ *               events, oldest first.
+ * @param maxEvents: uint32_t - Size of pEvents
+ * @param pTotal: uint32_t* - Optional. Filled in with the 
+ *              number of events ever recorded.
+ * 
+ * @return uint32_t - Number of events copied.
+ */
+uint32_t MessageThreadGetLatencyEvents( MessageLatencyEvent* pEvents, uint32_t maxEvents, uint32_t* pTotal );
+
 #ifdef __cplusplus
 }
 #endif
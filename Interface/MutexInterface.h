@@ -32,8 +32,58 @@
 extern "C" {
 #endif
 
+/**
+ * What a KMutex is built for. Ports map the kinds they can't 
+ * provide onto the nearest one they have. 
+ */
+typedef enum
+{
+  KMUTEX_KIND_DEFAULT = 0,      /**< Checks its owner and inherits priority, what KMutexCreate() builds */
+  KMUTEX_KIND_FAST,             /**< No checks, no priority protocol, cheapest to lock */
+  KMUTEX_KIND_ADAPTIVE,         /**< Fast, spins for a while on contention before sleeping */
+  KMUTEX_KIND_PRIO_INHERIT,     /**< Owner runs at the priority of the highest waiter */
+  KMUTEX_KIND_PRIO_CEILING,     /**< Owner runs at the ceiling priority while it holds the lock.
+                                     On POSIX a time shared thread is switched to SCHED_FIFO at the
+                                     ceiling until it drops its last ceiling mutex, which needs the
+                                     right to use real time priorities ( CAP_SYS_NICE or RLIMIT_RTPRIO ).
+                                     Creating one fails without that right. */
+}KMutexKind;
+
 bool  KMutexCreate( KMutex* pMutex, const char* pMutexName );
+
+/**
+ * KMutexCreateEx - Creates a mutex of the given kind. Short, 
+ * uncontended critical sections such as pools and log buffers 
+ * are best served by KMUTEX_KIND_FAST or KMUTEX_KIND_ADAPTIVE, 
+ * which skip the owner checks and the priority protocol of the 
+ * default kind. Locking such a mutex twice from the same thread 
+ * deadlocks instead of failing. 
+ * 
+ * 
+ * @param pMutex - Mutex to create.
+ * @param pMutexName - Name of the mutex.
+ * @param kind - Kind of mutex.
+ * @param ceiling - Priority ceiling for KMUTEX_KIND_PRIO_CEILING, 
+ *                ignored otherwise.
+ * 
+ * @return bool - true if created. false for 
+ *         KMUTEX_KIND_PRIO_CEILING when the caller can't run at 
+ *         the ceiling. 
+ */
+bool  KMutexCreateEx( KMutex* pMutex, const char* pMutexName, KMutexKind kind, uint32_t ceiling );
 void KMutexDelete( KMutex* pMutex );
+
+/**
+ * KMutexLock - Locks the mutex. 
+ * 
+ * @param pMutex - Mutex to lock.
+ * @param timeout - NO_SLEEP tries the lock first. 
+ * 
+ * @return bool - true once locked. Only a 
+ *         KMUTEX_KIND_PRIO_CEILING mutex returns false, when the 
+ *         calling thread can't be raised to its ceiling or runs 
+ *         above it. 
+ */
 bool KMutexLock( KMutex* pMutex, uint32_t timeout );
 void KMutexUnlock( KMutex* pMutex ); 
 
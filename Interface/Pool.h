@@ -26,7 +26,7 @@
 
 
 #include <limits.h>
-#include "MutexInterface.h"
+#include "SpinLockInterface.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -57,7 +57,7 @@ typedef struct _MemPool
   uint32_t* pFreeBits;
   uint32_t backingBufferSize;
   uint32_t numOfUnits;
-  KMutex mutex;
+  KSpinLock lock;
 }MemPool;
 
 #define CEIL_DIV( a, b )    ( ( (a) % (b) ) ? ( ( (a) / (b) ) + 1 ) : ( (a) / (b) ) )
@@ -0,0 +1,78 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __RWLOCK_INTERFACE_H__
+#define __RWLOCK_INTERFACE_H__
+
+#include <InterfacePrivateCommon.h>
+#include <PlatformInterface.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup KRwLock - reader / writer lock
+ *  Any number of readers can hold the lock at once, writers hold
+ *  it alone. While no writer holds or waits for the lock, taking
+ *  and releasing it for reading is a single atomic operation
+ *  each. Writers are preferred: once a writer waits for the
+ *  readers to leave, new readers wait behind it, so that a
+ *  steady stream of readers can't starve the writers. The lock is not recursive,
+ *  and a reader can't upgrade to a writer.
+ **/
+
+bool KRwLockCreate( KRwLock* pLock, const char* pLockName );
+void KRwLockDelete( KRwLock* pLock );
+
+/**
+ * KRwLockReadLock - Takes the lock for reading.
+ * 
+ * 
+ * @param pLock - Lock to take.
+ * @param timeout - Time in ms to wait for writers, NO_SLEEP or 
+ *                WAIT_FOREVER.
+ * 
+ * @return bool - true if taken.
+ */
+bool KRwLockReadLock( KRwLock* pLock, uint32_t timeout );
+void KRwLockReadUnlock( KRwLock* pLock );
+
+/**
+ * KRwLockWriteLock - Takes the lock for writing. New readers are
+ * held off from the moment this is called.
+ * 
+ * 
+ * @param pLock - Lock to take.
+ * @param timeout - Time in ms to wait for the readers and the 
+ *                other writers, NO_SLEEP or WAIT_FOREVER.
+ * 
+ * @return bool - true if taken.
+ */
+bool KRwLockWriteLock( KRwLock* pLock, uint32_t timeout );
+void KRwLockWriteUnlock( KRwLock* pLock );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RWLOCK_INTERFACE_H__
@@ -0,0 +1,96 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __SEQ_LOCK_H__
+#define __SEQ_LOCK_H__
+
+#include <stddef.h>
+#include "SeqLockImpl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup KSeqLock - sequence lock
+ *  Protects data that is read far more often than it is written,
+ *  by a single writer at a time. The writer bumps a sequence
+ *  number before and after it writes. A reader notes the
+ *  sequence before it reads and reads again if it changed, so
+ *  readers never write to the lock and don't take turns
+ *  bouncing its cache line between cores.
+ *
+ *  A read goes like this, the data may be torn till
+ *  KSeqLockReadRetry() says it wasn't:
+ *
+ *    do {
+ *      seq = KSeqLockReadBegin( &lock );
+ *      copy = shared;
+ *    } while( KSeqLockReadRetry( &lock, seq ) );
+ *
+ *  Writers must be serialized by the client. Readers must only
+ *  copy the data, never follow pointers read from it, and have
+ *  to be ready to read it again, so a copy should be short.
+ **/
+
+/**
+ * KSeqLockInit - Initializes a lock, see also KSEQLOCK_INIT.
+ */
+void KSeqLockInit( KSeqLock* pLock );
+
+/**
+ * KSeqLockReadBegin - Starts a read. Waits for a write in 
+ * progress to end. 
+ *
+ * @return uint32_t - Sequence to pass to KSeqLockReadRetry().
+ */
+uint32_t KSeqLockReadBegin( KSeqLock* pLock );
+
+/**
+ * KSeqLockReadRetry - Ends a read.
+ *
+ * @return bool - true if a write overlapped the read, the data 
+ *         must then be read again.
+ */
+bool KSeqLockReadRetry( KSeqLock* pLock, uint32_t seq );
+
+/**
+ * KSeqLockWriteBegin / KSeqLockWriteEnd - Bracket a write. 
+ */
+void KSeqLockWriteBegin( KSeqLock* pLock );
+void KSeqLockWriteEnd( KSeqLock* pLock );
+
+/**
+ * KSeqLockRead - Copies a consistent snapshot of size bytes from
+ * pShared to pCopy. 
+ */
+void KSeqLockRead( KSeqLock* pLock, void* pCopy, const void* pShared, size_t size );
+
+/**
+ * KSeqLockWrite - Publishes size bytes from pData to pShared.
+ */
+void KSeqLockWrite( KSeqLock* pLock, void* pShared, const void* pData, size_t size );
+
+#ifdef __cplusplus
+}
+#endif
+#endif // __SEQ_LOCK_H__
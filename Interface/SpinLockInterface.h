@@ -0,0 +1,101 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __SPINLOCK_INTERFACE_H__
+#define __SPINLOCK_INTERFACE_H__
+
+#include <SpinLockInterfaceImpl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup KSpinLock - spin locks
+ *  Locks for critical sections that are only a few instructions
+ *  long, where putting a waiter to sleep costs more than the
+ *  section itself. A waiter never blocks, it spins with
+ *  KCPU_RELAX() and backs off in proportion to how far back it
+ *  is in line. Nothing slow may be done while holding one: no
+ *  blocking calls, no logging and no other lock that could be
+ *  held for long. 
+ *
+ *  KSpinLock is a ticket lock, threads get it in the order they
+ *  asked for it. KMcsLock is a queue lock, every waiter spins on
+ *  a node of its own instead of the shared lock word, so the
+ *  cache line of the lock only moves once per hand off however
+ *  many threads wait. It scales better under heavy contention,
+ *  at the cost of a KMcsNode that the caller provides and keeps
+ *  till it unlocks. 
+ *
+ *  The port decides how they are implemented, on single core
+ *  targets both are a critical section. The functions are
+ *  inline. Initialize the locks with KSPINLOCK_INIT /
+ *  KMCSLOCK_INIT, the Init functions or by zeroing their owner.
+ **/
+
+/**
+ * KSpinLockInit - Initializes an unlocked ticket lock.
+ */
+static inline void KSpinLockInit( KSpinLock* pLock );
+
+/**
+ * KSpinLockLock / KSpinLockUnlock - Takes / releases the lock. 
+ * Not recursive. 
+ */
+static inline void KSpinLockLock( KSpinLock* pLock );
+static inline void KSpinLockUnlock( KSpinLock* pLock );
+
+/**
+ * KSpinLockTryLock - Takes the lock if it is free. 
+ *
+ * @return bool - true if the lock was taken.
+ */
+static inline bool KSpinLockTryLock( KSpinLock* pLock );
+
+/**
+ * KMcsLockInit - Initializes an unlocked queue lock.
+ */
+static inline void KMcsLockInit( KMcsLock* pLock );
+
+/**
+ * KMcsLockLock / KMcsLockUnlock - Takes / releases the lock. 
+ * Not recursive. pNode is owned by the lock from the lock to 
+ * the unlock, which must be given the same node. A stack 
+ * variable in the calling function will do. 
+ */
+static inline void KMcsLockLock( KMcsLock* pLock, KMcsNode* pNode );
+static inline void KMcsLockUnlock( KMcsLock* pLock, KMcsNode* pNode );
+
+/**
+ * KMcsLockTryLock - Takes the lock if it is free. 
+ *
+ * @return bool - true if the lock was taken, pNode must then be
+ *         passed to KMcsLockUnlock().
+ */
+static inline bool KMcsLockTryLock( KMcsLock* pLock, KMcsNode* pNode );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SPINLOCK_INTERFACE_H__
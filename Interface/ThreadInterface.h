@@ -33,14 +33,59 @@ extern "C" {
 
 extern const uint32_t KThreadHandleSize;
 
+/**
+ * Key of a thread local value, see KThreadLocalCreate(). 
+ */
+typedef uint32_t KThreadLocal;
+
+/**
+ * Scheduling policy of a thread. Ports fail KThreadCreate() for 
+ * a policy they can't provide. 
+ */
+typedef enum
+{
+  KTHREAD_SCHED_DEFAULT = 0,  /**< Port default. On POSIX a real time creator passes its policy on at threadPriority,
+                                   a time shared one passes on its own scheduling and threadPriority is ignored */
+  KTHREAD_SCHED_OTHER,        /**< Time shared, threadPriority is ignored, see niceValue */
+  KTHREAD_SCHED_FIFO,         /**< Real time, runs till it blocks or a higher priority thread is ready */
+  KTHREAD_SCHED_RR,           /**< Real time, round robin between threads of the same priority */
+  KTHREAD_SCHED_DEADLINE,     /**< Earliest deadline first, see KThreadDeadline */
+}KThreadSchedPolicy;
+
+/**
+ * @struct KThreadDeadline - Reservation of a 
+ *         KTHREAD_SCHED_DEADLINE thread: it gets runtimeNs of 
+ *         CPU time, within deadlineNs of the start of each 
+ *         period. 
+ */
+typedef struct _KThreadDeadline
+{
+  uint64_t runtimeNs;
+  uint64_t deadlineNs;
+  uint64_t periodNs;
+}KThreadDeadline;
+
+/**
+ * @struct KThreadSchedParams - Scheduling of a thread besides 
+ *         its priority. All zeroes keeps the port defaults. 
+ */
+typedef struct _KThreadSchedParams
+{
+  KThreadSchedPolicy policy;
+  uint64_t cpuAffinityMask;   /**< Bit n allows the thread to run on CPU n, 0 for any CPU */
+  int32_t niceValue;          /**< KTHREAD_SCHED_DEFAULT / KTHREAD_SCHED_OTHER only, -20 ( favoured ) to 19 */
+  KThreadDeadline deadline;   /**< KTHREAD_SCHED_DEADLINE only */
+}KThreadSchedParams;
+
 typedef struct _KThreadCreateParams
 {
   KThreadCallback fn;
   const char* pThreadName;
   void* threadArg;
-  void* pStack;
+  void* pStack;               /**< Stack of the thread, it must not be touched till the thread has been joined. Optional on POSIX */
   uint32_t stackSizeInBytes;
   uint32_t threadPriority; 
+  KThreadSchedParams sched;
 }KThreadCreateParams;
 
 #define KTHREAD_CREATE_PARAMS( varName, pName, f, arg, pStk, stkSize, priority )\
@@ -54,6 +99,22 @@ const KThreadCreateParams kthreadParams_##varName = \
   .threadPriority = priority\
 }
 
+/**
+ * Same as KTHREAD_CREATE_PARAMS() with the scheduling policy, 
+ * CPU affinity and nice value given by a KThreadSchedParams.
+ */
+#define KTHREAD_CREATE_PARAMS_SCHED( varName, pName, f, arg, pStk, stkSize, priority, schedParams )\
+const KThreadCreateParams kthreadParams_##varName = \
+{\
+  .pThreadName = pName,\
+  .fn = f,\
+  .threadArg = arg,\
+  .pStack = pStk,\
+  .stackSizeInBytes = stkSize,\
+  .threadPriority = priority,\
+  .sched = schedParams\
+}
+
 #define KTHREAD_PARAMS( varName ) &kthreadParams_##varName
 
 void KThreadInit();
@@ -62,6 +123,50 @@ bool KThreadDelete( KThread* pThread );
 bool KThreadJoin( KThread* pThread );
 const char* KThreadGetName( KThread* pThread );
 int32_t KThreadGetPriority( KThread* pThread );
+void KThreadSleep( uint32_t timeInMs );
+void KThreadYield( void );
+uint32_t KThreadGetCpuCount( void );
+
+/** @defgroup KThreadLocal - thread local storage
+ *  A key names one pointer sized value per thread, so that a
+ *  thread finds its own instance of a cache, buffer or counter
+ *  without a lock or a lookup. Keys come from a static table of
+ *  KTHREAD_LOCALS_MAX entries and are never given back. On
+ *  FreeRTOS there are no more keys than 
+ *  configNUM_THREAD_LOCAL_STORAGE_POINTERS. 
+ *
+ *  The value of a key starts out NULL in every thread. When a 
+ *  thread exits, the destructor of a key is called with the 
+ *  value the thread left in it, if that isn't NULL. On FreeRTOS
+ *  that is only done for threads started by KThreadCreate(). 
+ **/
+
+/**
+ * Called with the value a thread left in a key when the thread 
+ * exits. 
+ */
+typedef void (*KThreadLocalDestructor)( void* pValue );
+
+/**
+ * KThreadLocalCreate - Allocates a key.
+ *
+ *
+ * @param pKey - Filled in with the key.
+ * @param fnDestroy - Optional, see KThreadLocalDestructor.
+ *
+ * @return bool - false if the table is full.
+ */
+bool KThreadLocalCreate( KThreadLocal* pKey, KThreadLocalDestructor fnDestroy );
+
+/**
+ * KThreadLocalGet - Gets the value of the calling thread.
+ */
+void* KThreadLocalGet( KThreadLocal key );
+
+/**
+ * KThreadLocalSet - Sets the value of the calling thread.
+ */
+void KThreadLocalSet( KThreadLocal key, void* pValue );
 
 #ifdef __cplusplus
 }
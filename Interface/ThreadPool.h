@@ -0,0 +1,106 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include "ThreadPoolImpl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup KThreadPool - pre-started threads
+ *  A thread pool starts its threads up front and parks them.
+ *  KThreadPoolStart() hands a function to a parked thread and
+ *  wakes it up, KThreadPoolJoin() waits for the function to
+ *  return and parks the thread again. Short lived threads so
+ *  cost two semaphore operations instead of creating, naming
+ *  and joining an OS thread.
+ *
+ *  Unlike a KExecutor the function owns its thread till it
+ *  returns, so it may block for as long as it likes.
+ **/
+
+/**
+ * @struct KThreadPoolDef - Parameters of KThreadPoolCreate().
+ */
+typedef struct _KThreadPoolDef
+{
+  const char* pName;
+  uint32_t threadCount;       /**< Capped at KTHREAD_POOL_THREADS_MAX */
+  uint32_t stackSize;         /**< Stack size of each thread */
+  uint32_t priority;
+  void* pStack;               /**< Optional on POSIX, stackSize bytes for each thread, one after the other */
+}KThreadPoolDef;
+
+/**
+ * KThreadPoolCreate - Initializes a pool and starts its threads.
+ * 
+ * 
+ * @param pPool - Pool to initialize.
+ * @param pDef - Parameters of the pool.
+ * 
+ * @return bool - true if created.
+ */
+bool KThreadPoolCreate( KThreadPool* pPool, const KThreadPoolDef* pDef );
+
+/**
+ * KThreadPoolDestroy - Stops the threads of the pool and waits 
+ * for them to exit. Every thread handed out must have been 
+ * joined. 
+ * 
+ * 
+ * @param pPool - Pool to destroy.
+ */
+void KThreadPoolDestroy( KThreadPool* pPool );
+
+/**
+ * KThreadPoolStart - Runs fn( arg ) on a parked thread of the 
+ * pool. 
+ * 
+ * 
+ * @param pPool - Pool to take the thread from.
+ * @param fn - Thread function.
+ * @param arg - Argument of fn.
+ * @param timeout - Time in ms to wait for a thread to be parked
+ *                if they are all in use.
+ * 
+ * @return KPooledThread* - The thread running fn, to be passed 
+ *         to KThreadPoolJoin(). NULL if none was parked in time.
+ */
+KPooledThread* KThreadPoolStart( KThreadPool* pPool, KThreadCallback fn, void* arg, uint32_t timeout );
+
+/**
+ * KThreadPoolJoin - Waits for the function of a thread to return
+ * and parks the thread again. 
+ * 
+ * 
+ * @param pThread - Thread returned by KThreadPoolStart().
+ */
+void KThreadPoolJoin( KPooledThread* pThread );
+
+#ifdef __cplusplus
+}
+#endif
+#endif // __THREAD_POOL_H__
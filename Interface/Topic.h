@@ -0,0 +1,135 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __TOPIC_H__
+#define __TOPIC_H__
+
+#include "TopicImpl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup KTopic - publish / subscribe over message threads
+ *  A topic delivers each published payload to every subscribed
+ *  message thread. The payload is allocated once from the pool
+ *  of the topic and shared by all the subscribers, it is
+ *  reference counted and returned to the pool once the last
+ *  subscriber has processed it. Subscribers must treat it as
+ *  read only.
+ **/
+
+/**
+ * KTopicCreate - Initializes a topic.
+ * 
+ * 
+ * @param pTopic - Topic to initialize, see KTOPIC_DEF().
+ * @param pName - Name of the topic.
+ * @param pBackingStore - Storage for the payloads, 
+ *                      KTOPIC_BACKING_STORE_SIZE() bytes.
+ * @param payloadCount - Max payloads in flight.
+ * @param payloadSize - Size of a payload.
+ * 
+ * @return bool - true if created.
+ */
+bool KTopicCreate( KTopic* pTopic,
+                   const char* pName,
+                   uint8_t* pBackingStore,
+                   uint32_t payloadCount,
+                   uint32_t payloadSize );
+
+/**
+ * KTopicDestroy - Releases a topic. All payloads must have been 
+ * processed. 
+ * 
+ * 
+ * @param pTopic - Topic to release.
+ */
+void KTopicDestroy( KTopic* pTopic );
+
+/**
+ * KTopicSubscribe - Subscribes a message thread to the topic. 
+ * The thread receives the payloads in its fnProcess like any 
+ * other message. 
+ * 
+ * 
+ * @param pTopic - Initialized topic.
+ * @param hThread - Subscribing message thread.
+ * @param fnFilter - Optional filter.
+ * @param pContext - Passed to fnFilter.
+ * 
+ * @return bool - false if the topic has 
+ *         KTOPIC_SUBSCRIBERS_MAX subscribers.
+ */
+bool KTopicSubscribe( KTopic* pTopic, MessageThreadHandle hThread, KTopicFilter fnFilter, void* pContext );
+
+/**
+ * KTopicUnsubscribe - Removes a message thread from the topic. 
+ * Waits for publishes that may still deliver to it, once this 
+ * returns the thread receives no new payloads. 
+ * 
+ * 
+ * @param pTopic - Initialized topic.
+ * @param hThread - Subscribed message thread.
+ * 
+ * @return bool - true if the thread was subscribed.
+ */
+bool KTopicUnsubscribe( KTopic* pTopic, MessageThreadHandle hThread );
+
+/**
+ * KTopicAllocatePayload - Allocates a payload to publish.
+ * 
+ * 
+ * @param pTopic - Initialized topic.
+ * 
+ * @return MessageHandle - NULL if all payloads are in flight.
+ */
+MessageHandle KTopicAllocatePayload( KTopic* pTopic );
+
+/**
+ * KTopicDestroyPayload - Returns a payload that was not 
+ * published. 
+ * 
+ * 
+ * @param pTopic - Initialized topic.
+ * @param phPayload - Payload to destroy, set to NULL.
+ */
+void KTopicDestroyPayload( KTopic* pTopic, MessageHandle* phPayload );
+
+/**
+ * KTopicPublish - Posts the payload to every subscriber whose 
+ * filter accepts it. Does not take a lock. The topic owns the 
+ * payload once this is called. 
+ * 
+ * 
+ * @param pTopic - Initialized topic.
+ * @param hPayload - Payload from KTopicAllocatePayload().
+ * 
+ * @return uint32_t - Number of subscribers it was posted to.
+ */
+uint32_t KTopicPublish( KTopic* pTopic, MessageHandle hPayload );
+
+#ifdef __cplusplus
+}
+#endif
+#endif // __TOPIC_H__
@@ -0,0 +1,160 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __ATOMIC_INTERFACE_IMPL_H__
+#define __ATOMIC_INTERFACE_IMPL_H__
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef memory_order KAtomicOrder;
+
+#define KATOMIC_RELAXED           memory_order_relaxed
+#define KATOMIC_ACQUIRE           memory_order_acquire
+#define KATOMIC_RELEASE           memory_order_release
+#define KATOMIC_ACQ_REL           memory_order_acq_rel
+#define KATOMIC_SEQ_CST           memory_order_seq_cst
+
+typedef struct _KAtomicU32
+{
+  _Atomic uint32_t value;
+}KAtomicU32;
+
+typedef struct _KAtomicU64
+{
+  _Atomic uint64_t value;
+}KAtomicU64;
+
+typedef struct _KAtomicPtr
+{
+  _Atomic( void* ) value;
+}KAtomicPtr;
+
+#define KATOMIC_INIT( v )         { ( v ) }
+
+/**
+ * A failed compare exchange only loads, it can't have release
+ * semantics.
+ */
+static inline KAtomicOrder KAtomicFailureOrder( KAtomicOrder order )
+{
+  KAtomicOrder retval = order;
+  if ( order == memory_order_release ) {
+    retval = memory_order_relaxed;
+  }
+  else if ( order == memory_order_acq_rel ) {
+    retval = memory_order_acquire;
+  }
+  return retval;
+}
+
+static inline uint32_t KAtomicLoad32( KAtomicU32* pAtomic, KAtomicOrder order )
+{
+  return atomic_load_explicit( &pAtomic->value, order );
+}
+
+static inline void KAtomicStore32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order )
+{
+  atomic_store_explicit( &pAtomic->value, value, order );
+}
+
+static inline uint32_t KAtomicExchange32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order )
+{
+  return atomic_exchange_explicit( &pAtomic->value, value, order );
+}
+
+static inline bool KAtomicCompareExchange32( KAtomicU32* pAtomic, uint32_t* pExpected, uint32_t desired, KAtomicOrder order )
+{
+  return atomic_compare_exchange_strong_explicit( &pAtomic->value, pExpected, desired, order, KAtomicFailureOrder( order ) );
+}
+
+static inline uint32_t KAtomicFetchAdd32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order )
+{
+  return atomic_fetch_add_explicit( &pAtomic->value, value, order );
+}
+
+static inline uint32_t KAtomicFetchSub32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order )
+{
+  return atomic_fetch_sub_explicit( &pAtomic->value, value, order );
+}
+
+static inline uint32_t KAtomicFetchOr32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order )
+{
+  return atomic_fetch_or_explicit( &pAtomic->value, value, order );
+}
+
+static inline uint32_t KAtomicFetchAnd32( KAtomicU32* pAtomic, uint32_t value, KAtomicOrder order )
+{
+  return atomic_fetch_and_explicit( &pAtomic->value, value, order );
+}
+
+static inline uint64_t KAtomicLoad64( KAtomicU64* pAtomic, KAtomicOrder order )
+{
+  return atomic_load_explicit( &pAtomic->value, order );
+}
+
+static inline void KAtomicStore64( KAtomicU64* pAtomic, uint64_t value, KAtomicOrder order )
+{
+  atomic_store_explicit( &pAtomic->value, value, order );
+}
+
+static inline uint64_t KAtomicFetchAdd64( KAtomicU64* pAtomic, uint64_t value, KAtomicOrder order )
+{
+  return atomic_fetch_add_explicit( &pAtomic->value, value, order );
+}
+
+static inline void* KAtomicLoadPtr( KAtomicPtr* pAtomic, KAtomicOrder order )
+{
+  return atomic_load_explicit( &pAtomic->value, order );
+}
+
+static inline void KAtomicStorePtr( KAtomicPtr* pAtomic, void* value, KAtomicOrder order )
+{
+  atomic_store_explicit( &pAtomic->value, value, order );
+}
+
+static inline void* KAtomicExchangePtr( KAtomicPtr* pAtomic, void* value, KAtomicOrder order )
+{
+  return atomic_exchange_explicit( &pAtomic->value, value, order );
+}
+
+static inline bool KAtomicCompareExchangePtr( KAtomicPtr* pAtomic, void** pExpected, void* desired, KAtomicOrder order )
+{
+  return atomic_compare_exchange_strong_explicit( &pAtomic->value, pExpected, desired, order, KAtomicFailureOrder( order ) );
+}
+
+static inline void KAtomicFence( KAtomicOrder order )
+{
+  atomic_thread_fence( order );
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __ATOMIC_INTERFACE_IMPL_H__
@@ -0,0 +1,159 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <EventInterface.h>
+#include <pthread.h>
+#include <Logable.h>
+#include <errno.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef LINUX_PTHREAD
+#define EVENT_CLOCK             CLOCK_MONOTONIC
+#else
+#define EVENT_CLOCK             CLOCK_REALTIME
+#endif
+
+static void GetDeadline( struct timespec* pDeadline, uint32_t timeout )
+{
+  clock_gettime( EVENT_CLOCK, pDeadline );
+  if ( timeout != NO_SLEEP ) {
+    pDeadline->tv_sec += timeout / 1000;
+    pDeadline->tv_nsec += ( timeout % 1000 ) * 1000000;
+    if ( pDeadline->tv_nsec >= 1000000000 ) {
+      pDeadline->tv_sec++;
+      pDeadline->tv_nsec -= 1000000000;
+    }
+  }
+}
+
+static bool IsSatisfied( uint32_t current, uint32_t flags, uint32_t options )
+{
+  return ( options & KEVENT_WAIT_ALL ) ? ( ( current & flags ) == flags ) : ( ( current & flags ) != 0 );
+}
+
+bool KEventCreate( KEvent* pEvent, const char* pEventName )
+{
+  bool retval = false;
+  pthread_condattr_t attr;
+  if ( pEvent ) {
+    pEvent->flags = 0;
+    pthread_condattr_init( &attr );
+#ifdef LINUX_PTHREAD
+    pthread_condattr_setclock( &attr, EVENT_CLOCK );
+#endif
+    if ( pthread_mutex_init( &pEvent->mutex, NULL ) != 0 ) {
+      LOG( "%s(): Couldn't Initialize Mutex of %s", __FUNCTION__, pEventName );
+    }
+    else if ( pthread_cond_init( &pEvent->cond, &attr ) != 0 ) {
+      LOG( "%s(): Couldn't Initialize Condition of %s", __FUNCTION__, pEventName );
+      pthread_mutex_destroy( &pEvent->mutex );
+    }
+    else {
+      retval = true;
+    }
+    pthread_condattr_destroy( &attr );
+  }
+  return retval;
+}
+
+void KEventDelete( KEvent* pEvent )
+{
+  if ( pEvent ) {
+    pthread_cond_destroy( &pEvent->cond );
+    pthread_mutex_destroy( &pEvent->mutex );
+  }
+}
+
+uint32_t KEventSet( KEvent* pEvent, uint32_t flags )
+{
+  uint32_t retval = 0;
+  if ( pEvent ) {
+    pthread_mutex_lock( &pEvent->mutex );
+    pEvent->flags |= ( flags & KEVENT_FLAGS_MASK );
+    retval = pEvent->flags;
+    //Waiters check their own condition, each may be waiting for different flags
+    pthread_cond_broadcast( &pEvent->cond );
+    pthread_mutex_unlock( &pEvent->mutex );
+  }
+  return retval;
+}
+
+uint32_t KEventClear( KEvent* pEvent, uint32_t flags )
+{
+  uint32_t retval = 0;
+  if ( pEvent ) {
+    pthread_mutex_lock( &pEvent->mutex );
+    retval = pEvent->flags;
+    pEvent->flags &= ~flags;
+    pthread_mutex_unlock( &pEvent->mutex );
+  }
+  return retval;
+}
+
+uint32_t KEventGet( KEvent* pEvent )
+{
+  uint32_t retval = 0;
+  if ( pEvent ) {
+    pthread_mutex_lock( &pEvent->mutex );
+    retval = pEvent->flags;
+    pthread_mutex_unlock( &pEvent->mutex );
+  }
+  return retval;
+}
+
+uint32_t KEventWait( KEvent* pEvent, uint32_t flags, uint32_t options, uint32_t timeout )
+{
+  uint32_t retval = 0;
+  bool inTime = true;
+  struct timespec deadline;
+  if ( pEvent && flags ) {
+    if ( timeout != WAIT_FOREVER ) {
+      GetDeadline( &deadline, timeout );
+    }
+    pthread_mutex_lock( &pEvent->mutex );
+    while( inTime && !IsSatisfied( pEvent->flags, flags, options ) ) {
+      if ( timeout == WAIT_FOREVER ) {
+        pthread_cond_wait( &pEvent->cond, &pEvent->mutex );
+      }
+      else if ( pthread_cond_timedwait( &pEvent->cond, &pEvent->mutex, &deadline ) == ETIMEDOUT ) {
+        inTime = IsSatisfied( pEvent->flags, flags, options );
+      }
+    }
+    if ( inTime ) {
+      retval = pEvent->flags;
+      if ( options & KEVENT_CLEAR_ON_EXIT ) {
+        pEvent->flags &= ~flags;
+      }
+    }
+    pthread_mutex_unlock( &pEvent->mutex );
+  }
+  return retval;
+}
+
+#ifdef __cplusplus
+}
+#endif
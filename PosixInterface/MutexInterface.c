@@ -24,6 +24,7 @@
 
 #include <MutexInterface.h>
 #include <pthread.h>
+#include <sched.h>
 #include <Logable.h>
 #include <assert.h>
 
@@ -31,60 +32,203 @@
 extern "C" {
 #endif
 
-bool  KMutexCreate( KMutex* pMutex, const char* pMutexName )
+#if defined( __GLIBC__ ) && defined( __USE_GNU )
+#define KMUTEX_ADAPTIVE_TYPE      PTHREAD_MUTEX_ADAPTIVE_NP
+#else
+#define KMUTEX_ADAPTIVE_TYPE      PTHREAD_MUTEX_NORMAL
+#endif
+
+/**
+ * Scheduling a time shared thread had before it was raised to take a
+ * ceiling mutex and how many ceiling mutexes it holds since.
+ */
+typedef struct _CeilingBoost {
+  bool raised;
+  uint32_t held;
+  int policy;
+  struct sched_param param;
+}CeilingBoost;
+
+static __thread CeilingBoost s_ceilingBoost;
+
+/**
+ * pthreads refuses a PTHREAD_PRIO_PROTECT mutex to a time shared thread, so
+ * the thread is moved to SCHED_FIFO at the ceiling, which is where the
+ * protocol would put it anyway, before it tries the lock. glibc doesn't undo
+ * its bookkeeping when a ceiling lock fails, so trying first isn't an option.
+ */
+static int RaiseToCeiling( KMutex* pMutex )
+{
+  int err = 0;
+  int ceiling = 0;
+  int policy = SCHED_OTHER;
+  struct sched_param param = { 0 };
+  struct sched_param raised = { 0 };
+  if ( !s_ceilingBoost.raised &&
+       pthread_mutex_getprioceiling( &pMutex->mutex, &ceiling ) == 0 &&
+       pthread_getschedparam( pthread_self(), &policy, &param ) == 0 &&
+       policy != SCHED_FIFO && policy != SCHED_RR ) {
+    raised.sched_priority = ceiling;
+    err = pthread_setschedparam( pthread_self(), SCHED_FIFO, &raised );
+    if ( err ) {
+      LOG( "%s(): Couldn't raise time shared thread to ceiling %d. Err: %d", __FUNCTION__, ceiling, err );
+    } else {
+      s_ceilingBoost.raised = true;
+      s_ceilingBoost.policy = policy;
+      s_ceilingBoost.param = param;
+    }
+  }
+  return err;
+}
+
+static void LowerFromCeiling( void )
+{
+  if ( s_ceilingBoost.raised && s_ceilingBoost.held == 0 ) {
+    pthread_setschedparam( pthread_self(), s_ceilingBoost.policy, &s_ceilingBoost.param );
+    s_ceilingBoost.raised = false;
+  }
+}
+
+/**
+ * Tries the switch RaiseToCeiling() makes and puts the caller back, so a
+ * ceiling mutex the process could never lock is refused when it's created.
+ */
+static bool CanRaiseToCeiling( uint32_t ceiling )
+{
+  bool retval = false;
+  int policy = SCHED_OTHER;
+  struct sched_param param = { 0 };
+  struct sched_param raised = { 0 };
+  raised.sched_priority = ( int )ceiling;
+  if ( pthread_getschedparam( pthread_self(), &policy, &param ) != 0 ) {
+    //Can't tell, treat as refused
+  } else if ( policy == SCHED_FIFO || policy == SCHED_RR ) {
+    retval = true;
+  } else if ( pthread_setschedparam( pthread_self(), SCHED_FIFO, &raised ) == 0 ) {
+    pthread_setschedparam( pthread_self(), policy, &param );
+    retval = true;
+  }
+  return retval;
+}
+
+static bool LockCeiling( KMutex* pMutex, uint32_t timeout )
+{
+  int err = RaiseToCeiling( pMutex );
+  if ( err ) {
+    //Can't take it at all
+  } else if ( timeout == NO_SLEEP &&
+    pthread_mutex_trylock( &pMutex->mutex ) == 0 ) {
+    //Acquired Lock
+  } else {
+    err = pthread_mutex_lock( &pMutex->mutex );
+  }
+  if ( err ) {
+    LowerFromCeiling();
+  } else {
+    s_ceilingBoost.held++;
+  }
+  return ( err == 0 );
+}
+
+static bool SetKind( pthread_mutexattr_t* pAttr, KMutexKind kind, uint32_t ceiling )
+{
+  int type = PTHREAD_MUTEX_NORMAL;
+  int protocol = PTHREAD_PRIO_NONE;
+  bool retval = false;
+  switch( kind ) {
+  case KMUTEX_KIND_FAST:
+    break;
+  case KMUTEX_KIND_ADAPTIVE:
+    type = KMUTEX_ADAPTIVE_TYPE;
+    break;
+  case KMUTEX_KIND_PRIO_INHERIT:
+    protocol = PTHREAD_PRIO_INHERIT;
+    break;
+  case KMUTEX_KIND_PRIO_CEILING:
+    protocol = PTHREAD_PRIO_PROTECT;
+    break;
+  default:
+    type = PTHREAD_MUTEX_ERRORCHECK;
+    protocol = PTHREAD_PRIO_INHERIT;
+    break;
+  }
+  if ( pthread_mutexattr_settype( pAttr, type ) != 0 ) {
+    LOG( "%s(): Couldn't set Mutex Type", __FUNCTION__ );
+  } else if ( pthread_mutexattr_setprotocol( pAttr, protocol ) != 0 ) {
+    LOG( "%s(): Couldn't set Mutex Protocol", __FUNCTION__ );
+  } else if ( protocol == PTHREAD_PRIO_PROTECT &&
+              pthread_mutexattr_setprioceiling( pAttr, ( int )ceiling ) != 0 ) {
+    LOG( "%s(): Couldn't set Mutex Priority Ceiling %u", __FUNCTION__, ceiling );
+  } else {
+    retval = true;
+  }
+  return retval;
+}
+
+bool  KMutexCreateEx( KMutex* pMutex, const char* pMutexName, KMutexKind kind, uint32_t ceiling )
 {
   bool retval = false;
   pthread_mutexattr_t attr;
   if ( pMutex ) {
     pthread_mutexattr_init( &attr );
-    if ( pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_ERRORCHECK ) == 0 ) {
-      if ( pthread_mutexattr_setprotocol( &attr, PTHREAD_PRIO_INHERIT ) == 0 ) {
-        if ( pthread_mutex_init( pMutex, &attr ) == 0 ) {
-          retval = true;
-        }
-        else{
-          LOG( "%s(): Couldn't Initialize Mutex %s", __FUNCTION__, pMutexName );
-        }
+    if ( kind == KMUTEX_KIND_PRIO_CEILING && !CanRaiseToCeiling( ceiling ) ) {
+      LOG( "%s(): No real time priorities for ceiling %u of Mutex %s", __FUNCTION__, ceiling, pMutexName );
+    } else if ( SetKind( &attr, kind, ceiling ) ) {
+      if ( pthread_mutex_init( &pMutex->mutex, &attr ) == 0 ) {
+        pMutex->isCeiling = ( kind == KMUTEX_KIND_PRIO_CEILING );
+        retval = true;
       }
-      else
-      {
-        LOG( "%s(): Couldn't set Mutex Protocol", __FUNCTION__ );
+      else{
+        LOG( "%s(): Couldn't Initialize Mutex %s", __FUNCTION__, pMutexName );
       }
-    } else {
-      LOG( "%s(): Couldn't set Mutex Type", __FUNCTION__ );
     }
     pthread_mutexattr_destroy( &attr );
   }
   return retval;
 }
 
+bool  KMutexCreate( KMutex* pMutex, const char* pMutexName )
+{
+  return KMutexCreateEx( pMutex, pMutexName, KMUTEX_KIND_DEFAULT, 0 );
+}
+
 void KMutexDelete( KMutex* pMutex )
 {
   if ( pMutex ) {
-    pthread_mutex_destroy( pMutex );
+    pthread_mutex_destroy( &pMutex->mutex );
   }
 }
 
+/**
+ * Only a ceiling mutex can fail for lack of rights, the others failing
+ * means the mutex is broken.
+ */
 bool KMutexLock( KMutex* pMutex, uint32_t timeout )
 {
   bool retval = false;
-  if ( pMutex ) {
-    if ( timeout == NO_SLEEP &&
-      pthread_mutex_trylock( pMutex ) == 0 ) {
-      //Acquired Lock
-      retval = true;
-    } else if( pthread_mutex_lock( pMutex ) == 0 ) {
-      retval = true;
-    }
+  if ( pMutex == NULL ) {
+    //Nothing to lock
+  } else if ( pMutex->isCeiling ) {
+    retval = LockCeiling( pMutex, timeout );
+  } else if ( timeout == NO_SLEEP &&
+    pthread_mutex_trylock( &pMutex->mutex ) == 0 ) {
+    //Acquired Lock
+    retval = true;
+  } else if( pthread_mutex_lock( &pMutex->mutex ) == 0 ) {
+    retval = true;
   }
-  assert( retval == true );
+  assert( retval == true || ( pMutex && pMutex->isCeiling ) );
   return retval;
 }
 
 void KMutexUnlock( KMutex* pMutex )
 {
   if( pMutex ) {
-    pthread_mutex_unlock( pMutex );
+    pthread_mutex_unlock( &pMutex->mutex );
+    if ( pMutex->isCeiling ) {
+      s_ceilingBoost.held--;
+      LowerFromCeiling();
+    }
   }
 }
 
@@ -26,6 +26,7 @@
 
 #include <pthread.h>
 #include <semaphore.h>
+#include <AtomicInterfaceImpl.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,9 +41,12 @@ typedef struct _KThread
   pthread_t pthread;
   KThreadCallback fn;
   void* arg;
-  bool isComplete;
+  KAtomicU32 isComplete;             /**< Set once the thread has been joined */
   char threadName[ THREAD_NAME_MAX_SIZE ];
   uint32_t sanity;
+  struct _KThreadStartup* pStartup;   /**< Set while KThreadCreate() waits for the thread to apply its scheduling */
+  void* pGuard;                       /**< Guard pages carved out of the caller's stack, NULL if none */
+  size_t guardSize;
 }KThread;
 
 typedef struct _KSema {
@@ -50,7 +54,54 @@ typedef struct _KSema {
   char* pSemaphoreName;
 }KSema;
 
-typedef pthread_mutex_t KMutex;
+/**
+ * @struct KMutex - isCeiling is fixed at create time so that only
+ *         KMUTEX_KIND_PRIO_CEILING mutexes pay for the scheduling
+ *         switch around their lock.
+ */
+typedef struct _KMutex {
+  pthread_mutex_t mutex;
+  bool isCeiling;
+}KMutex;
+
+/**
+ * @struct KRwLock - Readers and writers are counted in state, so
+ *         that readers only touch the mutex while a writer holds
+ *         or waits for the lock.
+ */
+typedef struct _KRwLock
+{
+  KAtomicU32 state;                 /**< Readers in the low 16 bits, writers holding or waiting above */
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  bool isWriterActive;              /**< Guarded by mutex */
+}KRwLock;
+
+typedef struct _KEvent
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  uint32_t flags;                   /**< Guarded by mutex */
+}KEvent;
+
+#define SEMANTIC_THREAD_PRIORITY_LOWEST    ( 1 )
+#define SEMANTIC_THREAD_PRIORITY_HIGHEST   ( 99 )
+#define SEMANTIC_THREAD_PRIORITY_MID       ( ( SEMANTIC_THREAD_PRIORITY_HIGHEST + SEMANTIC_THREAD_PRIORITY_LOWEST ) / 2 )
+#define SEMANTIC_THREAD_PRIORITY_LOW       ( ( SEMANTIC_THREAD_PRIORITY_MID + SEMANTIC_THREAD_PRIORITY_LOWEST ) / 2 )
+#define SEMANTIC_THREAD_PRIORITY_HIGH      ( ( SEMANTIC_THREAD_PRIORITY_HIGHEST + SEMANTIC_THREAD_PRIORITY_MID ) / 2 )
+
+/**
+ * Called on every iteration of a busy wait. Lets a sibling 
+ * hyperthread have the core and keeps the spinning thread from
+ * flooding the memory bus. 
+ */
+#if defined( __i386__ ) || defined( __x86_64__ )
+#define KCPU_RELAX()                        __builtin_ia32_pause()
+#elif defined( __aarch64__ ) || defined( __arm__ )
+#define KCPU_RELAX()                        __asm__ __volatile__( "yield" ::: "memory" )
+#else
+#define KCPU_RELAX()                        do { } while( 0 )
+#endif
 
 #ifdef __cplusplus
 }
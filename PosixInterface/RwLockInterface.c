@@ -0,0 +1,198 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <RwLockInterface.h>
+#include <pthread.h>
+#include <Logable.h>
+#include <errno.h>
+#include <time.h>
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RWLOCK_WRITER           ( 1u << 16 )
+#define RWLOCK_READERS_MASK     ( RWLOCK_WRITER - 1 )
+
+#ifdef LINUX_PTHREAD
+#define RWLOCK_CLOCK            CLOCK_MONOTONIC
+#else
+#define RWLOCK_CLOCK            CLOCK_REALTIME
+#endif
+
+/**
+ * Returns the state after adding value to it.
+ */
+static uint32_t AddState( KRwLock* pLock, uint32_t value )
+{
+  return KAtomicFetchAdd32( &pLock->state, value, KATOMIC_ACQ_REL ) + value;
+}
+
+static void GetDeadline( struct timespec* pDeadline, uint32_t timeout )
+{
+  clock_gettime( RWLOCK_CLOCK, pDeadline );
+  if ( timeout != NO_SLEEP ) {
+    pDeadline->tv_sec += timeout / 1000;
+    pDeadline->tv_nsec += ( timeout % 1000 ) * 1000000;
+    if ( pDeadline->tv_nsec >= 1000000000 ) {
+      pDeadline->tv_sec++;
+      pDeadline->tv_nsec -= 1000000000;
+    }
+  }
+}
+
+/**
+ * Waits on the condition with the mutex held. Returns false once
+ * the deadline has passed.
+ */
+static bool Wait( KRwLock* pLock, uint32_t timeout, const struct timespec* pDeadline )
+{
+  bool retval = true;
+  if ( timeout == WAIT_FOREVER ) {
+    pthread_cond_wait( &pLock->cond, &pLock->mutex );
+  }
+  else if ( pthread_cond_timedwait( &pLock->cond, &pLock->mutex, pDeadline ) == ETIMEDOUT ) {
+    retval = false;
+  }
+  return retval;
+}
+
+bool KRwLockCreate( KRwLock* pLock, const char* pLockName )
+{
+  bool retval = false;
+  pthread_condattr_t attr;
+  if ( pLock ) {
+    KAtomicStore32( &pLock->state, 0, KATOMIC_RELAXED );
+    pLock->isWriterActive = false;
+    pthread_condattr_init( &attr );
+#ifdef LINUX_PTHREAD
+    pthread_condattr_setclock( &attr, RWLOCK_CLOCK );
+#endif
+    if ( pthread_mutex_init( &pLock->mutex, NULL ) != 0 ) {
+      LOG( "%s(): Couldn't Initialize Mutex of %s", __FUNCTION__, pLockName );
+    }
+    else if ( pthread_cond_init( &pLock->cond, &attr ) != 0 ) {
+      LOG( "%s(): Couldn't Initialize Condition of %s", __FUNCTION__, pLockName );
+      pthread_mutex_destroy( &pLock->mutex );
+    }
+    else {
+      retval = true;
+    }
+    pthread_condattr_destroy( &attr );
+  }
+  return retval;
+}
+
+void KRwLockDelete( KRwLock* pLock )
+{
+  if ( pLock ) {
+    pthread_cond_destroy( &pLock->cond );
+    pthread_mutex_destroy( &pLock->mutex );
+  }
+}
+
+bool KRwLockReadLock( KRwLock* pLock, uint32_t timeout )
+{
+  bool retval = false;
+  bool inTime = true;
+  struct timespec deadline;
+  if ( pLock ) {
+    if ( timeout != WAIT_FOREVER ) {
+      GetDeadline( &deadline, timeout );
+    }
+    while( !retval && inTime ) {
+      if ( !( AddState( pLock, 1 ) & ~RWLOCK_READERS_MASK ) ) {
+        retval = true;
+      }
+      else {
+        //A writer holds or waits for the lock, back out and wait for it
+        pthread_mutex_lock( &pLock->mutex );
+        if ( !( AddState( pLock, ( uint32_t )-1 ) & RWLOCK_READERS_MASK ) ) {
+          pthread_cond_broadcast( &pLock->cond );
+        }
+        while( inTime && ( KAtomicLoad32( &pLock->state, KATOMIC_ACQUIRE ) & ~RWLOCK_READERS_MASK ) ) {
+          inTime = Wait( pLock, timeout, &deadline );
+        }
+        pthread_mutex_unlock( &pLock->mutex );
+      }
+    }
+  }
+  return retval;
+}
+
+void KRwLockReadUnlock( KRwLock* pLock )
+{
+  if ( pLock ) {
+    uint32_t state = AddState( pLock, ( uint32_t )-1 );
+    if ( state && !( state & RWLOCK_READERS_MASK ) ) {
+      //Last reader out while a writer waits
+      pthread_mutex_lock( &pLock->mutex );
+      pthread_cond_broadcast( &pLock->cond );
+      pthread_mutex_unlock( &pLock->mutex );
+    }
+  }
+}
+
+bool KRwLockWriteLock( KRwLock* pLock, uint32_t timeout )
+{
+  bool retval = false;
+  bool inTime = true;
+  struct timespec deadline;
+  if ( pLock ) {
+    if ( timeout != WAIT_FOREVER ) {
+      GetDeadline( &deadline, timeout );
+    }
+    pthread_mutex_lock( &pLock->mutex );
+    AddState( pLock, RWLOCK_WRITER );
+    while( inTime && ( pLock->isWriterActive || ( KAtomicLoad32( &pLock->state, KATOMIC_ACQUIRE ) & RWLOCK_READERS_MASK ) ) ) {
+      inTime = Wait( pLock, timeout, &deadline );
+    }
+    if ( inTime ) {
+      pLock->isWriterActive = true;
+      retval = true;
+    }
+    else if ( !( AddState( pLock, -RWLOCK_WRITER ) & ~RWLOCK_READERS_MASK ) ) {
+      //Gave up as the last writer, let the readers in
+      pthread_cond_broadcast( &pLock->cond );
+    }
+    pthread_mutex_unlock( &pLock->mutex );
+  }
+  return retval;
+}
+
+void KRwLockWriteUnlock( KRwLock* pLock )
+{
+  if ( pLock ) {
+    pthread_mutex_lock( &pLock->mutex );
+    assert( pLock->isWriterActive );
+    pLock->isWriterActive = false;
+    AddState( pLock, -RWLOCK_WRITER );
+    pthread_cond_broadcast( &pLock->cond );
+    pthread_mutex_unlock( &pLock->mutex );
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
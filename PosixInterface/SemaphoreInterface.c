@@ -31,6 +31,9 @@
 #endif
 #include <Logable.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
 #include <stdlib.h>
 #include <assert.h>
 
@@ -92,11 +95,33 @@ bool KSemaGet( KSema* pSema, uint32_t timeout )
       status = sem_trywait( pSema->pNamedSema );
       if ( !status ) {
         retval = true;
-      } else {
-        LOG( "%s(): Error while trying to peek at sema value (%d)", __FUNCTION__, status );
+      } else if ( errno != EAGAIN ) {
+        //EAGAIN just means the semaphore is not available
+        LOG( "%s(): Error while trying to peek at sema value (%d)", __FUNCTION__, errno );
       }
     } else {
-      LOG( "%s(): Timed waiting on semaphore not implemented for pthreads", __FUNCTION__ ); 
+#ifdef LINUX_PTHREAD
+      struct timespec deadline;
+      clock_gettime( CLOCK_REALTIME, &deadline );
+      deadline.tv_sec += timeout / 1000;
+      deadline.tv_nsec += ( timeout % 1000 ) * 1000000;
+      if ( deadline.tv_nsec >= 1000000000 ) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+      }
+      while( ( status = sem_timedwait( pSema->pNamedSema, &deadline ) ) != 0 && errno == EINTR );
+      if ( !status ) {
+        retval = true;
+      } else if ( errno != ETIMEDOUT ) {
+        LOG( "%s(): Error during timed wait on semaphore (%d)", __FUNCTION__, errno );
+      }
+#else
+      //No sem_timedwait() on OSX, poll at 1ms granularity instead.
+      uint32_t waited = 0;
+      while( !( retval = ( sem_trywait( pSema->pNamedSema ) == 0 ) ) && waited++ < timeout ) {
+        usleep( 1000 );
+      }
+#endif
     }
   }
   return retval;
@@ -0,0 +1,155 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __SPINLOCK_INTERFACE_IMPL_H__
+#define __SPINLOCK_INTERFACE_IMPL_H__
+
+#include <PlatformInterface.h>
+#include <AtomicInterface.h>
+#include <sched.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Relaxes spent per thread ahead of a ticket lock waiter before
+ * it looks at the lock again. 
+ */
+#define KSPINLOCK_BACKOFF             ( 16 )
+
+/**
+ * Relaxes a waiter spends before it gives up the cpu. The thread
+ * it waits on may have been preempted, possibly to let it run. 
+ */
+#define KSPINLOCK_SPINS               ( 1024 )
+
+typedef struct _KSpinLock
+{
+  KAtomicU32 next;                  /**< Ticket handed to the next thread */
+  KAtomicU32 owner;                 /**< Ticket of the thread holding the lock */
+}KSpinLock;
+
+typedef struct _KMcsNode
+{
+  KAtomicPtr pNext;                 /**< Waiter the lock goes to next */
+  KAtomicU32 isWaiting;             /**< Cleared by the previous holder */
+}KMcsNode;
+
+typedef struct _KMcsLock
+{
+  KAtomicPtr pTail;                 /**< Last waiter, NULL if the lock is free */
+}KMcsLock;
+
+#define KSPINLOCK_INIT                { KATOMIC_INIT( 0 ), KATOMIC_INIT( 0 ) }
+#define KMCSLOCK_INIT                 { KATOMIC_INIT( NULL ) }
+
+static inline void KSpinLockRelax( uint32_t count, uint32_t* pSpins )
+{
+  *pSpins += count;
+  while( count-- ) {
+    KCPU_RELAX();
+  }
+  if ( *pSpins >= KSPINLOCK_SPINS ) {
+    sched_yield();
+    *pSpins = 0;
+  }
+}
+
+static inline void KSpinLockInit( KSpinLock* pLock )
+{
+  KAtomicStore32( &pLock->next, 0, KATOMIC_RELAXED );
+  KAtomicStore32( &pLock->owner, 0, KATOMIC_RELAXED );
+}
+
+static inline void KSpinLockLock( KSpinLock* pLock )
+{
+  uint32_t ticket = KAtomicFetchAdd32( &pLock->next, 1, KATOMIC_RELAXED );
+  uint32_t owner = KAtomicLoad32( &pLock->owner, KATOMIC_ACQUIRE );
+  uint32_t spins = 0;
+  while( owner != ticket ) {
+    KSpinLockRelax( ( ticket - owner ) * KSPINLOCK_BACKOFF, &spins );
+    owner = KAtomicLoad32( &pLock->owner, KATOMIC_ACQUIRE );
+  }
+}
+
+static inline bool KSpinLockTryLock( KSpinLock* pLock )
+{
+  uint32_t owner = KAtomicLoad32( &pLock->owner, KATOMIC_ACQUIRE );
+  //Only free if no ticket has been handed out past the owner
+  return KAtomicCompareExchange32( &pLock->next, &owner, owner + 1, KATOMIC_ACQUIRE );
+}
+
+static inline void KSpinLockUnlock( KSpinLock* pLock )
+{
+  uint32_t owner = KAtomicLoad32( &pLock->owner, KATOMIC_RELAXED );
+  KAtomicStore32( &pLock->owner, owner + 1, KATOMIC_RELEASE );
+}
+
+static inline void KMcsLockInit( KMcsLock* pLock )
+{
+  KAtomicStorePtr( &pLock->pTail, NULL, KATOMIC_RELAXED );
+}
+
+static inline void KMcsLockLock( KMcsLock* pLock, KMcsNode* pNode )
+{
+  KMcsNode* pPrev = NULL;
+  uint32_t spins = 0;
+  KAtomicStorePtr( &pNode->pNext, NULL, KATOMIC_RELAXED );
+  KAtomicStore32( &pNode->isWaiting, 1, KATOMIC_RELAXED );
+  pPrev = ( KMcsNode* )KAtomicExchangePtr( &pLock->pTail, pNode, KATOMIC_ACQ_REL );
+  if ( pPrev ) {
+    KAtomicStorePtr( &pPrev->pNext, pNode, KATOMIC_RELEASE );
+    while( KAtomicLoad32( &pNode->isWaiting, KATOMIC_ACQUIRE ) ) {
+      KSpinLockRelax( 1, &spins );
+    }
+  }
+}
+
+static inline bool KMcsLockTryLock( KMcsLock* pLock, KMcsNode* pNode )
+{
+  void* pExpected = NULL;
+  KAtomicStorePtr( &pNode->pNext, NULL, KATOMIC_RELAXED );
+  return KAtomicCompareExchangePtr( &pLock->pTail, &pExpected, pNode, KATOMIC_ACQUIRE );
+}
+
+static inline void KMcsLockUnlock( KMcsLock* pLock, KMcsNode* pNode )
+{
+  KMcsNode* pNext = ( KMcsNode* )KAtomicLoadPtr( &pNode->pNext, KATOMIC_ACQUIRE );
+  void* pExpected = pNode;
+  uint32_t spins = 0;
+  if ( pNext || !KAtomicCompareExchangePtr( &pLock->pTail, &pExpected, NULL, KATOMIC_RELEASE ) ) {
+    //A waiter may have swapped itself in but not linked up yet
+    while( !pNext ) {
+      KSpinLockRelax( 1, &spins );
+      pNext = ( KMcsNode* )KAtomicLoadPtr( &pNode->pNext, KATOMIC_ACQUIRE );
+    }
+    KAtomicStore32( &pNext->isWaiting, 0, KATOMIC_RELEASE );
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SPINLOCK_INTERFACE_IMPL_H__
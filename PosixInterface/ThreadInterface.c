@@ -25,7 +25,18 @@
 #include <ThreadInterface.h>
 #include <Logable.h>
 #include <pthread.h>
+#include <sched.h>
+#include <errno.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <limits.h>
+#include <AbstractUtilsConfig.h>
+#include <assert.h>
+#ifdef LINUX_PTHREAD
+#include <sys/syscall.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,19 +44,266 @@ extern "C" {
 
 const uint32_t KThreadHandleSize = sizeof( KThread );
 
+#ifdef LINUX_PTHREAD
+#define KTHREAD_SCHED_DEADLINE_POLICY     ( 6 )
+
+//Not exported by glibc, see sched_setattr(2)
+typedef struct _KThreadSchedAttr
+{
+  uint32_t size;
+  uint32_t policy;
+  uint64_t flags;
+  int32_t nice;
+  uint32_t priority;
+  uint64_t runtime;
+  uint64_t deadline;
+  uint64_t period;
+}KThreadSchedAttr;
+#endif
+
+/**
+ * The nice value and the deadline policy can't be set through 
+ * the pthread attributes, the new thread applies them itself 
+ * while KThreadCreate() waits to hear how that went. 
+ */
+typedef struct _KThreadStartup
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  const KThreadSchedParams* pSched;
+  bool isDone;
+  int err;
+}KThreadStartup;
+
+static int ApplyThreadSched( const KThreadSchedParams* pSched )
+{
+  int err = 0;
+#ifdef LINUX_PTHREAD
+  if ( pSched->policy == KTHREAD_SCHED_DEADLINE ) {
+#ifdef SYS_sched_setattr
+    KThreadSchedAttr attr = { 0 };
+    attr.size = sizeof( attr );
+    attr.policy = KTHREAD_SCHED_DEADLINE_POLICY;
+    attr.runtime = pSched->deadline.runtimeNs;
+    attr.deadline = pSched->deadline.deadlineNs;
+    attr.period = pSched->deadline.periodNs;
+    if ( syscall( SYS_sched_setattr, 0, &attr, 0 ) ) {
+      err = errno;
+    }
+#else
+    err = ENOSYS;
+#endif
+  }
+  else if ( setpriority( PRIO_PROCESS, ( id_t )syscall( SYS_gettid ), pSched->niceValue ) ) {
+    //On Linux the nice value is per thread
+    err = errno;
+  }
+#else
+  //The nice value is per process and there is no deadline scheduling
+  err = ENOTSUP;
+#endif
+  if ( err ) {
+    LOG( "%s(): Unable to apply policy %d / nice %d. Err: %d", __FUNCTION__, pSched->policy, pSched->niceValue, err );
+  }
+  return err;
+}
+
 static void* Thread( void* arg )
 {
   KThread* pThread = ( KThread* )arg;
+  KThreadStartup* pStartup = pThread->pStartup;
+  int err = 0;
 #ifdef LINUX_PTHREAD
   pthread_setname_np( pThread->pthread, pThread->threadName );
 #else
   pthread_setname_np( pThread->threadName );
 #endif
-  pThread->fn( pThread->arg );
-  pThread->isComplete = true;
+  if ( pStartup ) {
+    err = ApplyThreadSched( pStartup->pSched );
+    pthread_mutex_lock( &pStartup->mutex );
+    pStartup->err = err;
+    pStartup->isDone = true;
+    pthread_cond_signal( &pStartup->cond );
+    pthread_mutex_unlock( &pStartup->mutex );
+  }
+  if ( !err ) {
+    pThread->fn( pThread->arg );
+  }
   return NULL;
 }
 
+/**
+ * Runs the thread on the caller's stack instead of one mmap()ed 
+ * by the C library, so that creating it allocates nothing. The 
+ * lowest whole pages of the buffer become 
+ * KTHREAD_STACK_GUARD_PAGES guard pages if what is left is still 
+ * a usable stack, and every page of the stack is touched up 
+ * front so that the thread never takes a page fault on it. 
+ * Stacks sized for an RTOS can be smaller than the C library 
+ * accepts, the thread then gets a PTHREAD_STACK_MIN stack of the
+ * library's instead. 
+ */
+static int SetStack( KThread* pThread, pthread_attr_t* pAttr, const KThreadCreateParams* pParams )
+{
+  int err = 0;
+  uintptr_t base = 0, top = 0;
+  size_t stackSize = pParams->stackSizeInBytes;
+  pThread->pGuard = NULL;
+  pThread->guardSize = 0;
+  if ( pParams->pStack ) {
+    base = ( ( uintptr_t )pParams->pStack + 15 ) & ~( uintptr_t )15;
+    top = ( ( uintptr_t )pParams->pStack + pParams->stackSizeInBytes ) & ~( uintptr_t )15;
+  }
+  if ( top > base && top - base >= PTHREAD_STACK_MIN ) {
+    uintptr_t pageSize = ( uintptr_t )sysconf( _SC_PAGESIZE );
+    uintptr_t guard = ( ( uintptr_t )pParams->pStack + pageSize - 1 ) & ~( pageSize - 1 );
+    uintptr_t guardEnd = guard + ( KTHREAD_STACK_GUARD_PAGES * pageSize );
+    uintptr_t page = 0;
+    if ( KTHREAD_STACK_GUARD_PAGES && guardEnd < top && top - guardEnd >= PTHREAD_STACK_MIN ) {
+      if ( !mprotect( ( void* )guard, guardEnd - guard, PROT_NONE ) ) {
+        pThread->pGuard = ( void* )guard;
+        pThread->guardSize = guardEnd - guard;
+        base = guardEnd;
+      }
+      else {
+        LOG( "%s(): Unable to set up the stack guard. Err: %d", __FUNCTION__, errno );
+      }
+    }
+    for( page = base; page < top; page += pageSize ) {
+      *( volatile uint8_t* )page = 0;
+    }
+    err = pthread_attr_setstack( pAttr, ( void* )base, top - base );
+  }
+  else {
+    if ( stackSize < PTHREAD_STACK_MIN ) {
+      LOG( "%s(): %s asked for a %u byte stack, using a %u byte one", 
+           __FUNCTION__, pParams->pThreadName, pParams->stackSizeInBytes, ( uint32_t )PTHREAD_STACK_MIN );
+      stackSize = PTHREAD_STACK_MIN;
+    }
+    err = pthread_attr_setstacksize( pAttr, stackSize );
+  }
+  return err;
+}
+
+/**
+ * Gives the guard pages back to the owner of the stack, once the 
+ * thread is gone. 
+ */
+static void ReleaseStack( KThread* pThread )
+{
+  if ( pThread->pGuard ) {
+    mprotect( pThread->pGuard, pThread->guardSize, PROT_READ | PROT_WRITE );
+    pThread->pGuard = NULL;
+  }
+}
+
+/**
+ * Set once a time shared process has been told that the priorities of its 
+ * KTHREAD_SCHED_DEFAULT threads go unused, so it's only said once. 
+ */
+static KAtomicU32 s_warnedPriorityIgnored = KATOMIC_INIT( 0 );
+
+static int SetScheduling( pthread_attr_t* pAttr, const KThreadCreateParams* pParams )
+{
+  int err = 0;
+  int policy = SCHED_OTHER;
+  struct sched_param schedParam = { 0 };
+  bool isExplicit = true;
+  switch( pParams->sched.policy ) {
+    case KTHREAD_SCHED_DEFAULT:
+      //A real time creator hands its policy on, at the priority asked for
+      if ( pthread_getschedparam( pthread_self(), &policy, &schedParam ) == 0 &&
+           ( policy == SCHED_FIFO || policy == SCHED_RR ) ) {
+        schedParam.sched_priority = pParams->threadPriority;
+      } else {
+        isExplicit = false;
+        if ( pParams->threadPriority &&
+             KAtomicExchange32( &s_warnedPriorityIgnored, 1, KATOMIC_RELAXED ) == 0 ) {
+          LOG( "%s(): %s is time shared, priority %u and those of later default threads are ignored",
+               __FUNCTION__, pParams->pThreadName, pParams->threadPriority );
+        }
+      }
+      break;
+    case KTHREAD_SCHED_DEADLINE:
+      //Deadline scheduling is applied by the thread itself
+      isExplicit = false;
+      break;
+    case KTHREAD_SCHED_OTHER:
+      policy = SCHED_OTHER;
+      break;
+    case KTHREAD_SCHED_FIFO:
+      policy = SCHED_FIFO;
+      schedParam.sched_priority = pParams->threadPriority;
+      break;
+    case KTHREAD_SCHED_RR:
+      policy = SCHED_RR;
+      schedParam.sched_priority = pParams->threadPriority;
+      break;
+    default:
+      err = EINVAL;
+      break;
+  }
+  if ( !err && pParams->sched.niceValue && 
+       pParams->sched.policy != KTHREAD_SCHED_DEFAULT && pParams->sched.policy != KTHREAD_SCHED_OTHER ) {
+    //Only time shared threads have a nice value
+    err = EINVAL;
+  }
+  if ( !err ) {
+    err = pthread_attr_setinheritsched( pAttr, isExplicit ? PTHREAD_EXPLICIT_SCHED : PTHREAD_INHERIT_SCHED );
+  }
+  if ( !err && isExplicit ) {
+    err = pthread_attr_setschedpolicy( pAttr, policy );
+    if ( !err ) {
+      err = pthread_attr_setschedparam( pAttr, &schedParam );
+    }
+  }
+  if ( err ) {
+    LOG( "%s(): Unable to set policy %d, priority %u. Err: %d",
+         __FUNCTION__, pParams->sched.policy, pParams->threadPriority, err );
+  }
+  return err;
+}
+
+static int SetAffinity( pthread_attr_t* pAttr, uint64_t cpuAffinityMask )
+{
+  int err = 0;
+  if ( cpuAffinityMask ) {
+#ifdef LINUX_PTHREAD
+    cpu_set_t cpuSet;
+    uint32_t cpu = 0;
+    CPU_ZERO( &cpuSet );
+    for( cpu = 0; cpu < 64; cpu++ ) {
+      if ( cpuAffinityMask & ( 1ULL << cpu ) ) {
+        CPU_SET( cpu, &cpuSet );
+      }
+    }
+    err = pthread_attr_setaffinity_np( pAttr, sizeof( cpuSet ), &cpuSet );
+#else
+    err = ENOTSUP;
+#endif
+    if ( err ) {
+      LOG( "%s(): Unable to set CPU affinity 0x%llx. Err: %d", __FUNCTION__, ( unsigned long long )cpuAffinityMask, err );
+    }
+  }
+  return err;
+}
+
+static bool WaitForStartup( KThread* pThread, KThreadStartup* pStartup )
+{
+  pthread_mutex_lock( &pStartup->mutex );
+  while( !pStartup->isDone ) {
+    pthread_cond_wait( &pStartup->cond, &pStartup->mutex );
+  }
+  pthread_mutex_unlock( &pStartup->mutex );
+  pThread->pStartup = NULL;
+  if ( pStartup->err ) {
+    //The thread has exited without running its function
+    pthread_join( pThread->pthread, NULL );
+    ReleaseStack( pThread );
+  }
+  return !pStartup->err;
+}
+
 bool KThreadCreate( KThread* pThread, const KThreadCreateParams* pParams )
 {
   bool retval = false;
@@ -54,36 +312,53 @@ bool KThreadCreate( KThread* pThread, const KThreadCreateParams* pParams )
     pthread_attr_t attr;
     err = pthread_attr_init( &attr );
     if ( !err ) {
-      struct sched_param schedParam = { 0 };
+      KThreadStartup startup = { .pSched = &pParams->sched };
+      bool needsStartup = ( pParams->sched.niceValue || pParams->sched.policy == KTHREAD_SCHED_DEADLINE );
       err = pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_JOINABLE );
       if ( !err ) {
-        err = pthread_attr_setstacksize( &attr, pParams->stackSizeInBytes );
+        err = SetStack( pThread, &attr, pParams );
         if( !err ) {
-          schedParam.sched_priority = pParams->threadPriority;
-          err = pthread_attr_setschedpolicy( &attr, SCHED_RR );
+          err = SetScheduling( &attr, pParams );
           if ( !err ) {
-            pthread_attr_setschedparam( &attr, &schedParam );
+            err = SetAffinity( &attr, pParams->sched.cpuAffinityMask );
+          }
+          if ( err ) {
+            ReleaseStack( pThread );
+          }
+          else {
             pThread->fn = pParams->fn;
             pThread->arg = pParams->threadArg;
-            pThread->isComplete = false;
+            KAtomicStore32( &pThread->isComplete, false, KATOMIC_RELAXED );
             pThread->sanity = THREAD_SANITY_CHECK;
+            pThread->pStartup = NULL;
             if( pParams->pThreadName ) {
               strncpy( pThread->threadName, pParams->pThreadName, sizeof( pThread->threadName ) );
             } else {
               memset( pThread->threadName, 0, sizeof( pThread->threadName ) );
             }
+            if ( needsStartup ) {
+              pthread_mutex_init( &startup.mutex, NULL );
+              pthread_cond_init( &startup.cond, NULL );
+              pThread->pStartup = &startup;
+            }
             err = pthread_create( &pThread->pthread, &attr, Thread, pThread );
             if ( !err ) {
-              retval  = true;
+              retval = ( needsStartup ) ? WaitForStartup( pThread, &startup ) : true;
             } else {
+              //EPERM for a real time policy without the privilege to use it
               LOG( "%s(): Unable to create thread. Err: %d", __FUNCTION__, err );
+              ReleaseStack( pThread );
+            }
+            if ( needsStartup ) {
+              pthread_cond_destroy( &startup.cond );
+              pthread_mutex_destroy( &startup.mutex );
+              pThread->pStartup = NULL;
             }
-          } else {
-            LOG( "%s(): Unable to set Pthread Scheduling to OTHER: %d", __FUNCTION__, err );
           }
         } else {
-          LOG( "%s(): Unable to set stack size to: %d, err: %d",
+          LOG( "%s(): Unable to set the stack of %d bytes, err: %d",
                __FUNCTION__, pParams->stackSizeInBytes, err );
+          ReleaseStack( pThread );
         }
       } else {
         LOG( "%s(): Unable to make thread joinable. Err: %d", __FUNCTION__, err );
@@ -110,12 +385,17 @@ bool KThreadJoin( KThread* pThread )
 {
   bool retval = true;
   int err = 0;
-  if ( pThread && !pThread->isComplete ) {
+  //Only the first join reaps the thread, the stack can't be reused before that
+  if ( pThread && !KAtomicExchange32( &pThread->isComplete, true, KATOMIC_ACQ_REL ) ) {
     err = pthread_join( pThread->pthread, NULL );
     if ( err ) {
       LOG( "%s(): Was not able to wait for thread to join. Err: %d", __FUNCTION__, err );
+      KAtomicStore32( &pThread->isComplete, false, KATOMIC_RELEASE );
       retval = false;
     }
+    else {
+      ReleaseStack( pThread );
+    }
   } 
   return retval;
 }
@@ -134,6 +414,96 @@ const char* KThreadGetName( KThread* pThread )
   return pThread->threadName;
 }
 
+void KThreadSleep( uint32_t timeInMs )
+{
+  usleep( timeInMs * 1000 );
+}
+
+void KThreadYield( void )
+{
+  sched_yield();
+}
+
+uint32_t KThreadGetCpuCount( void )
+{
+  long count = sysconf( _SC_NPROCESSORS_ONLN );
+  return ( count > 0 ) ? ( uint32_t )count : 1;
+}
+
+/**
+ * Values live in a __thread array indexed by the key, a Get is a
+ * plain load. A single pthread key, set the first time a thread
+ * stores a value, runs the destructors when the thread exits. 
+ */
+typedef struct _KThreadLocalTable
+{
+  pthread_mutex_t mutex;
+  pthread_once_t once;
+  pthread_key_t exitKey;
+  uint32_t count;
+  KThreadLocalDestructor fnDestroy[ KTHREAD_LOCALS_MAX ];
+}KThreadLocalTable;
+
+static KThreadLocalTable s_locals = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_ONCE_INIT };
+static __thread void* s_localValues[ KTHREAD_LOCALS_MAX ];
+static __thread bool s_hasLocalValues;
+
+static void ThreadLocalExit( void* arg )
+{
+  void** pValues = ( void** )arg;
+  uint32_t i = 0;
+  for( i = 0; i < KTHREAD_LOCALS_MAX; i++ ) {
+    void* pValue = pValues[ i ];
+    pValues[ i ] = NULL;
+    if ( pValue && s_locals.fnDestroy[ i ] ) {
+      s_locals.fnDestroy[ i ]( pValue );
+    }
+  }
+}
+
+static void ThreadLocalInit( void )
+{
+  int err = pthread_key_create( &s_locals.exitKey, ThreadLocalExit );
+  if ( err ) {
+    LOG( "%s(): Was not able to create the exit key. Err: %d", __FUNCTION__, err );
+  }
+}
+
+bool KThreadLocalCreate( KThreadLocal* pKey, KThreadLocalDestructor fnDestroy )
+{
+  bool retval = false;
+  if ( pKey ) {
+    pthread_once( &s_locals.once, ThreadLocalInit );
+    pthread_mutex_lock( &s_locals.mutex );
+    if ( s_locals.count < KTHREAD_LOCALS_MAX ) {
+      s_locals.fnDestroy[ s_locals.count ] = fnDestroy;
+      *pKey = s_locals.count++;
+      retval = true;
+    }
+    else {
+      LOG( "%s(): All %d keys are taken", __FUNCTION__, KTHREAD_LOCALS_MAX );
+    }
+    pthread_mutex_unlock( &s_locals.mutex );
+  }
+  return retval;
+}
+
+void* KThreadLocalGet( KThreadLocal key )
+{
+  assert( key < KTHREAD_LOCALS_MAX );
+  return s_localValues[ key ];
+}
+
+void KThreadLocalSet( KThreadLocal key, void* pValue )
+{
+  assert( key < KTHREAD_LOCALS_MAX );
+  s_localValues[ key ] = pValue;
+  if ( pValue && !s_hasLocalValues ) {
+    s_hasLocalValues = true;
+    pthread_setspecific( s_locals.exitKey, s_localValues );
+  }
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,176 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <Actor.h>
+#include <ThreadInterface.h>
+#include <SemaphoreInterface.h>
+#include <AtomicInterface.h>
+#include <string.h>
+
+#define ACTOR_TEST_ACTORS             ( 256 )
+#define ACTOR_TEST_MESSAGES           ( 8 )
+#define ACTOR_TEST_WORKERS            ( 4 )
+#define ACTOR_TEST_BATCH              ( 3 )
+#define ACTOR_TEST_HOPS               ( 4 * ACTOR_TEST_ACTORS )
+#define ACTOR_TEST_STACK_SIZE         ( 1 << 16 )
+
+typedef struct _ActorTestMessage
+{
+  KActorMessage header;
+  uint32_t seq;
+}ActorTestMessage;
+
+typedef struct _ActorTestState
+{
+  KAtomicU32 isBusy;
+  uint32_t handled;
+  uint32_t nextSeq;
+  uint32_t errors;
+}ActorTestState;
+
+typedef struct _ActorTestData
+{
+  uint8_t stackStore[ KACTOR_WORKERS_MAX * ACTOR_TEST_STACK_SIZE ];
+  KActorSystem system;
+  KActor actors[ ACTOR_TEST_ACTORS ];
+  ActorTestState states[ ACTOR_TEST_ACTORS ];
+  ActorTestMessage messages[ ACTOR_TEST_ACTORS ][ ACTOR_TEST_MESSAGES ];
+  KSema doneSema;
+}ActorTestData;
+
+static ActorTestData s_actorTest;
+
+static bool CreateSystem( uint32_t workerCount, uint32_t batch )
+{
+  KActorSystemDef def = 
+  {
+    .pName = "actorTest",
+    .workerCount = workerCount,
+    .stackSize = ACTOR_TEST_STACK_SIZE,
+    .priority = SEMANTIC_THREAD_PRIORITY_MID,
+    .pStack = s_actorTest.stackStore,
+    .batch = batch
+  };
+  return KActorSystemCreate( &s_actorTest.system, &def );
+}
+
+static void setUp( void )
+{
+  memset( s_actorTest.states, 0, sizeof( s_actorTest.states ) );
+  KSemaCreate( &s_actorTest.doneSema, "ActorTestDone", 0 );
+}
+
+static void tearDown( void )
+{
+  KActorSystemDestroy( &s_actorTest.system );
+  KSemaDelete( &s_actorTest.doneSema );
+}
+
+static void CountMessage( KActor* pActor, KActorMessage* pMessage )
+{
+  ActorTestState* pState = ( ActorTestState* )KActorGetContext( pActor );
+  ActorTestMessage* pTestMessage = ( ActorTestMessage* )pMessage;
+  if ( KAtomicExchange32( &pState->isBusy, 1, KATOMIC_ACQUIRE ) ) {
+    pState->errors++;
+  }
+  if ( pTestMessage->seq != pState->nextSeq ) {
+    pState->errors++;
+  }
+  pState->nextSeq = pTestMessage->seq + 1;
+  KAtomicStore32( &pState->isBusy, 0, KATOMIC_RELEASE );
+  if ( ++pState->handled == ACTOR_TEST_MESSAGES ) {
+    KSemaPut( &s_actorTest.doneSema );
+  }
+}
+
+static void ForwardMessage( KActor* pActor, KActorMessage* pMessage )
+{
+  ActorTestState* pState = ( ActorTestState* )KActorGetContext( pActor );
+  ActorTestMessage* pTestMessage = ( ActorTestMessage* )pMessage;
+  uint32_t index = ( uint32_t )( pState - s_actorTest.states );
+  pState->handled++;
+  if ( ++pTestMessage->seq == ACTOR_TEST_HOPS ) {
+    KSemaPut( &s_actorTest.doneSema );
+  }
+  else {
+    KActorSend( &s_actorTest.actors[ ( index + 1 ) % ACTOR_TEST_ACTORS ], pMessage );
+  }
+}
+
+static void ActorSystemCanBeCreated( void )
+{
+  TEST_ASSERT( CreateSystem( ACTOR_TEST_WORKERS, 0 ) );
+  TEST_ASSERT_EQUAL_INT( ACTOR_TEST_WORKERS, s_actorTest.system.workerCount );
+  TEST_ASSERT_EQUAL_INT( KACTOR_DEFAULT_BATCH, s_actorTest.system.batch );
+}
+
+static void ActorsHandleMailOneAtATime( void )
+{
+  uint32_t i = 0, j = 0;
+  TEST_ASSERT( CreateSystem( ACTOR_TEST_WORKERS, ACTOR_TEST_BATCH ) );
+  for( i = 0; i < ACTOR_TEST_ACTORS; i++ ) {
+    KActorInit( &s_actorTest.actors[ i ], &s_actorTest.system, CountMessage, &s_actorTest.states[ i ] );
+  }
+  //Interleave the actors so that most of them are ready at once
+  for( j = 0; j < ACTOR_TEST_MESSAGES; j++ ) {
+    for( i = 0; i < ACTOR_TEST_ACTORS; i++ ) {
+      s_actorTest.messages[ i ][ j ].seq = j;
+      KActorSend( &s_actorTest.actors[ i ], &s_actorTest.messages[ i ][ j ].header );
+    }
+  }
+  for( i = 0; i < ACTOR_TEST_ACTORS; i++ ) {
+    TEST_ASSERT( KSemaGet( &s_actorTest.doneSema, WAIT_FOREVER ) );
+  }
+  for( i = 0; i < ACTOR_TEST_ACTORS; i++ ) {
+    TEST_ASSERT_EQUAL_INT( ACTOR_TEST_MESSAGES, s_actorTest.states[ i ].handled );
+    TEST_ASSERT_EQUAL_INT( 0, s_actorTest.states[ i ].errors );
+  }
+}
+
+static void HandlersCanSendToActors( void )
+{
+  uint32_t i = 0, handled = 0;
+  TEST_ASSERT( CreateSystem( ACTOR_TEST_WORKERS, 0 ) );
+  for( i = 0; i < ACTOR_TEST_ACTORS; i++ ) {
+    KActorInit( &s_actorTest.actors[ i ], &s_actorTest.system, ForwardMessage, &s_actorTest.states[ i ] );
+  }
+  s_actorTest.messages[ 0 ][ 0 ].seq = 0;
+  KActorSend( &s_actorTest.actors[ 0 ], &s_actorTest.messages[ 0 ][ 0 ].header );
+  TEST_ASSERT( KSemaGet( &s_actorTest.doneSema, WAIT_FOREVER ) );
+  for( i = 0; i < ACTOR_TEST_ACTORS; i++ ) {
+    handled += s_actorTest.states[ i ].handled;
+  }
+  TEST_ASSERT_EQUAL_INT( ACTOR_TEST_HOPS, handled );
+}
+
+TestRef ActorTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "ActorSystemCanBeCreated", ActorSystemCanBeCreated ),
+    new_TestFixture( "ActorsHandleMailOneAtATime", ActorsHandleMailOneAtATime ),
+    new_TestFixture( "HandlersCanSendToActors", HandlersCanSendToActors )
+  };
+  EMB_UNIT_TESTCALLER( ActorApiTest, "ActorApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&ActorApiTest;
+}
@@ -27,6 +27,21 @@
 
 extern TestRef PoolTest_ApiTests();
 extern TestRef KThreadTest_ApiTests();
+extern TestRef MutexTest_ApiTests();
+extern TestRef RwLockTest_ApiTests();
+extern TestRef EventTest_ApiTests();
+extern TestRef AtomicTest_ApiTests();
+extern TestRef ThreadPoolTest_ApiTests();
+extern TestRef SeqLockTest_ApiTests();
+extern TestRef EpochTest_ApiTests();
+extern TestRef SpinLockTest_ApiTests();
+extern TestRef BarrierTest_ApiTests();
+extern TestRef MessageQueueTest_ApiTests();
+extern TestRef TimerWheelTest_ApiTests();
+extern TestRef TopicTest_ApiTests();
+extern TestRef MessageThreadTest_ApiTests();
+extern TestRef ExecutorTest_ApiTests();
+extern TestRef ActorTest_ApiTests();
 extern TestRef PriorityWakeTest();
 extern TestRef PriorityDonateChainTest();
 
@@ -40,6 +55,21 @@ static void TestRunner( void* arg )
   {
     TestRunner_runTest( PoolTest_ApiTests() );
     TestRunner_runTest( KThreadTest_ApiTests() );
+    TestRunner_runTest( MutexTest_ApiTests() );
+    TestRunner_runTest( RwLockTest_ApiTests() );
+    TestRunner_runTest( EventTest_ApiTests() );
+    TestRunner_runTest( AtomicTest_ApiTests() );
+    TestRunner_runTest( ThreadPoolTest_ApiTests() );
+    TestRunner_runTest( SeqLockTest_ApiTests() );
+    TestRunner_runTest( EpochTest_ApiTests() );
+    TestRunner_runTest( SpinLockTest_ApiTests() );
+    TestRunner_runTest( BarrierTest_ApiTests() );
+    TestRunner_runTest( MessageQueueTest_ApiTests() );
+    TestRunner_runTest( TimerWheelTest_ApiTests() );
+    TestRunner_runTest( TopicTest_ApiTests() );
+    TestRunner_runTest( MessageThreadTest_ApiTests() );
+    TestRunner_runTest( ExecutorTest_ApiTests() );
+    TestRunner_runTest( ActorTest_ApiTests() );
     ConsoleLog( "ALL DONE\n" );
     //TestRunner_runTest( PriorityWakeTest() );
     //TestRunner_runTest( PriorityDonateChainTest() );
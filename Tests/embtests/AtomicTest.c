@@ -0,0 +1,132 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <AtomicInterface.h>
+#include <ThreadInterface.h>
+
+#define ATOMIC_TEST_THREADS           ( 4 )
+#define ATOMIC_TEST_INCREMENTS        ( 100000 )
+#define ATOMIC_TEST_STACK_SIZE        ( 1 << 14 )
+
+typedef struct _AtomicTestData
+{
+  KThread threads[ ATOMIC_TEST_THREADS ];
+  uint8_t stacks[ ATOMIC_TEST_THREADS ][ ATOMIC_TEST_STACK_SIZE ];
+  KAtomicU32 counter;
+  KAtomicU32 casCounter;
+  KAtomicU64 total;
+}AtomicTestData;
+
+static AtomicTestData s_atomicTest;
+
+static void setUp( void )
+{
+  KAtomicStore32( &s_atomicTest.counter, 0, KATOMIC_RELAXED );
+  KAtomicStore32( &s_atomicTest.casCounter, 0, KATOMIC_RELAXED );
+  KAtomicStore64( &s_atomicTest.total, 0, KATOMIC_RELAXED );
+}
+
+static void tearDown( void )
+{
+}
+
+static void Increment( void* arg )
+{
+  uint32_t i = 0;
+  for( i = 0; i < ATOMIC_TEST_INCREMENTS; i++ ) {
+    uint32_t expected = KAtomicLoad32( &s_atomicTest.casCounter, KATOMIC_RELAXED );
+    KAtomicFetchAdd32( &s_atomicTest.counter, 1, KATOMIC_RELAXED );
+    KAtomicFetchAdd64( &s_atomicTest.total, i, KATOMIC_RELAXED );
+    //A failed exchange hands back the current value to retry with
+    while( !KAtomicCompareExchange32( &s_atomicTest.casCounter, &expected, expected + 1, KATOMIC_ACQ_REL ) );
+  }
+}
+
+static void ConcurrentUpdatesAreNotLost( void )
+{
+  uint64_t perThread = ( ( uint64_t )ATOMIC_TEST_INCREMENTS * ( ATOMIC_TEST_INCREMENTS - 1 ) ) / 2;
+  uint32_t i = 0;
+  for( i = 0; i < ATOMIC_TEST_THREADS; i++ ) {
+    KTHREAD_CREATE_PARAMS( incrementParams,
+                           "AtomicTest",
+                           Increment,
+                           NULL,
+                           s_atomicTest.stacks[ i ],
+                           ATOMIC_TEST_STACK_SIZE,
+                           SEMANTIC_THREAD_PRIORITY_MID );
+    TEST_ASSERT( KThreadCreate( &s_atomicTest.threads[ i ], KTHREAD_PARAMS( incrementParams ) ) );
+  }
+  for( i = 0; i < ATOMIC_TEST_THREADS; i++ ) {
+    TEST_ASSERT( KThreadJoin( &s_atomicTest.threads[ i ] ) );
+    TEST_ASSERT( KThreadDelete( &s_atomicTest.threads[ i ] ) );
+  }
+  TEST_ASSERT_EQUAL_INT( ATOMIC_TEST_THREADS * ATOMIC_TEST_INCREMENTS, KAtomicLoad32( &s_atomicTest.counter, KATOMIC_SEQ_CST ) );
+  TEST_ASSERT_EQUAL_INT( ATOMIC_TEST_THREADS * ATOMIC_TEST_INCREMENTS, KAtomicLoad32( &s_atomicTest.casCounter, KATOMIC_SEQ_CST ) );
+  TEST_ASSERT( KAtomicLoad64( &s_atomicTest.total, KATOMIC_SEQ_CST ) == ATOMIC_TEST_THREADS * perThread );
+}
+
+static void CompareExchangeReportsCurrentValue( void )
+{
+  KAtomicU32 value = KATOMIC_INIT( 5 );
+  KAtomicPtr ptr = KATOMIC_INIT( NULL );
+  uint32_t expected = 4;
+  void* pExpected = &expected;
+  TEST_ASSERT( !KAtomicCompareExchange32( &value, &expected, 7, KATOMIC_SEQ_CST ) );
+  TEST_ASSERT_EQUAL_INT( 5, expected );
+  TEST_ASSERT_EQUAL_INT( 5, KAtomicLoad32( &value, KATOMIC_RELAXED ) );
+  TEST_ASSERT( KAtomicCompareExchange32( &value, &expected, 7, KATOMIC_SEQ_CST ) );
+  TEST_ASSERT_EQUAL_INT( 7, KAtomicLoad32( &value, KATOMIC_RELAXED ) );
+
+  TEST_ASSERT( !KAtomicCompareExchangePtr( &ptr, &pExpected, &value, KATOMIC_ACQ_REL ) );
+  TEST_ASSERT( pExpected == NULL );
+  TEST_ASSERT( KAtomicCompareExchangePtr( &ptr, &pExpected, &value, KATOMIC_ACQ_REL ) );
+  TEST_ASSERT( KAtomicLoadPtr( &ptr, KATOMIC_ACQUIRE ) == &value );
+  TEST_ASSERT( KAtomicExchangePtr( &ptr, NULL, KATOMIC_ACQ_REL ) == &value );
+  TEST_ASSERT( KAtomicLoadPtr( &ptr, KATOMIC_RELAXED ) == NULL );
+}
+
+static void ReadModifyWriteReturnsOldValue( void )
+{
+  KAtomicU32 value = KATOMIC_INIT( 0x0F );
+  TEST_ASSERT_EQUAL_INT( 0x0F, KAtomicFetchOr32( &value, 0xF0, KATOMIC_RELAXED ) );
+  TEST_ASSERT_EQUAL_INT( 0xFF, KAtomicFetchAnd32( &value, 0x3C, KATOMIC_RELAXED ) );
+  TEST_ASSERT_EQUAL_INT( 0x3C, KAtomicFetchSub32( &value, 0x3C, KATOMIC_RELAXED ) );
+  //Subtraction wraps like unsigned arithmetic
+  TEST_ASSERT_EQUAL_INT( 0, KAtomicFetchSub32( &value, 1, KATOMIC_RELAXED ) );
+  TEST_ASSERT( KAtomicExchange32( &value, 3, KATOMIC_SEQ_CST ) == UINT32_MAX );
+  TEST_ASSERT_EQUAL_INT( 3, KAtomicFetchAdd32( &value, 1, KATOMIC_SEQ_CST ) );
+  KAtomicFence( KATOMIC_SEQ_CST );
+  TEST_ASSERT_EQUAL_INT( 4, KAtomicLoad32( &value, KATOMIC_ACQUIRE ) );
+}
+
+TestRef AtomicTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "ConcurrentUpdatesAreNotLost", ConcurrentUpdatesAreNotLost ),
+    new_TestFixture( "CompareExchangeReportsCurrentValue", CompareExchangeReportsCurrentValue ),
+    new_TestFixture( "ReadModifyWriteReturnsOldValue", ReadModifyWriteReturnsOldValue )
+  };
+  EMB_UNIT_TESTCALLER( AtomicApiTest, "AtomicApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&AtomicApiTest;
+}
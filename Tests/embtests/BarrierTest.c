@@ -0,0 +1,144 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <Barrier.h>
+#include <ThreadInterface.h>
+#include <AtomicInterface.h>
+#include <string.h>
+
+#define BARRIER_TEST_THREADS          ( 4 )
+#define BARRIER_TEST_PHASES           ( 2000 )
+#define BARRIER_TEST_SPINS            ( 1000 )
+#define BARRIER_TEST_STACK_SIZE       ( 1 << 16 )
+
+typedef struct _BarrierTestData
+{
+  KThread threads[ BARRIER_TEST_THREADS ];
+  uint8_t stacks[ BARRIER_TEST_THREADS ][ BARRIER_TEST_STACK_SIZE ];
+  KBarrier barrier;
+  KAtomicU32 progress[ BARRIER_TEST_THREADS ];  /**< Phases each thread has arrived for */
+  KAtomicU32 lastCount;                         /**< Threads that were told they arrived last */
+  KAtomicU32 errors;
+  uint32_t callbackPhases;                      /**< Only touched by the callback */
+}BarrierTestData;
+
+static BarrierTestData s_barrierTest;
+
+static void setUp( void )
+{
+  memset( &s_barrierTest.barrier, 0, sizeof( s_barrierTest.barrier ) );
+  memset( s_barrierTest.progress, 0, sizeof( s_barrierTest.progress ) );
+  KAtomicStore32( &s_barrierTest.lastCount, 0, KATOMIC_RELAXED );
+  KAtomicStore32( &s_barrierTest.errors, 0, KATOMIC_RELAXED );
+  s_barrierTest.callbackPhases = 0;
+}
+
+static void tearDown( void )
+{
+  KBarrierDestroy( &s_barrierTest.barrier );
+}
+
+static void LastArrived( void* pContext )
+{
+  BarrierTestData* pData = ( BarrierTestData* )pContext;
+  uint32_t i = 0;
+  pData->callbackPhases++;
+  //Everyone has arrived and no one has been let go yet
+  for( i = 0; i < BARRIER_TEST_THREADS; i++ ) {
+    if ( KAtomicLoad32( &pData->progress[ i ], KATOMIC_RELAXED ) != pData->callbackPhases ) {
+      KAtomicFetchAdd32( &pData->errors, 1, KATOMIC_RELAXED );
+    }
+  }
+}
+
+static void Worker( void* arg )
+{
+  uint32_t index = ( uint32_t )( uintptr_t )arg;
+  uint32_t phase = 0, i = 0, progress = 0;
+  for( phase = 1; phase <= BARRIER_TEST_PHASES; phase++ ) {
+    KAtomicStore32( &s_barrierTest.progress[ index ], phase, KATOMIC_RELAXED );
+    if ( KBarrierWait( &s_barrierTest.barrier ) ) {
+      KAtomicFetchAdd32( &s_barrierTest.lastCount, 1, KATOMIC_RELAXED );
+    }
+    //Others may be a phase ahead already, but never behind
+    for( i = 0; i < BARRIER_TEST_THREADS; i++ ) {
+      progress = KAtomicLoad32( &s_barrierTest.progress[ i ], KATOMIC_RELAXED );
+      if ( progress != phase && progress != phase + 1 ) {
+        KAtomicFetchAdd32( &s_barrierTest.errors, 1, KATOMIC_RELAXED );
+      }
+    }
+  }
+}
+
+static void RunPhases( uint32_t spinCount )
+{
+  KBarrierDef def = { "BarrierTest", BARRIER_TEST_THREADS, spinCount, LastArrived, &s_barrierTest };
+  uint32_t i = 0;
+  TEST_ASSERT( KBarrierCreate( &s_barrierTest.barrier, &def ) );
+  for( i = 0; i < BARRIER_TEST_THREADS; i++ ) {
+    KTHREAD_CREATE_PARAMS( workerParams,
+                           "BarrierTest",
+                           Worker,
+                           ( void* )( uintptr_t )i,
+                           s_barrierTest.stacks[ i ],
+                           BARRIER_TEST_STACK_SIZE,
+                           SEMANTIC_THREAD_PRIORITY_MID );
+    TEST_ASSERT( KThreadCreate( &s_barrierTest.threads[ i ], KTHREAD_PARAMS( workerParams ) ) );
+  }
+  for( i = 0; i < BARRIER_TEST_THREADS; i++ ) {
+    TEST_ASSERT( KThreadDelete( &s_barrierTest.threads[ i ] ) );
+  }
+  TEST_ASSERT_EQUAL_INT( 0, KAtomicLoad32( &s_barrierTest.errors, KATOMIC_RELAXED ) );
+  TEST_ASSERT_EQUAL_INT( BARRIER_TEST_PHASES, KAtomicLoad32( &s_barrierTest.lastCount, KATOMIC_RELAXED ) );
+  TEST_ASSERT_EQUAL_INT( BARRIER_TEST_PHASES, s_barrierTest.callbackPhases );
+}
+
+static void BlockingWaitKeepsPhasesInStep( void )
+{
+  RunPhases( 0 );
+}
+
+static void SpinningWaitKeepsPhasesInStep( void )
+{
+  RunPhases( BARRIER_TEST_SPINS );
+}
+
+static void SingleThreadNeverWaits( void )
+{
+  KBarrierDef def = { "BarrierTest", 1, 0, NULL, NULL };
+  TEST_ASSERT( KBarrierCreate( &s_barrierTest.barrier, &def ) );
+  TEST_ASSERT( KBarrierWait( &s_barrierTest.barrier ) );
+  TEST_ASSERT( KBarrierWait( &s_barrierTest.barrier ) );
+}
+
+TestRef BarrierTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "BlockingWaitKeepsPhasesInStep", BlockingWaitKeepsPhasesInStep ),
+    new_TestFixture( "SpinningWaitKeepsPhasesInStep", SpinningWaitKeepsPhasesInStep ),
+    new_TestFixture( "SingleThreadNeverWaits", SingleThreadNeverWaits )
+  };
+  EMB_UNIT_TESTCALLER( BarrierApiTest, "BarrierApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&BarrierApiTest;
+}
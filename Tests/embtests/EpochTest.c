@@ -0,0 +1,209 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <Epoch.h>
+#include <ThreadInterface.h>
+#include <AtomicInterface.h>
+#include <string.h>
+
+#define EPOCH_TEST_READERS            ( 3 )
+#define EPOCH_TEST_SWAPS              ( 20000 )
+#define EPOCH_TEST_READS              ( 1000 )
+#define EPOCH_TEST_NODES              ( 64 )
+#define EPOCH_TEST_STACK_SIZE         ( 1 << 16 )
+#define EPOCH_TEST_HOLD_EVERY         ( 16 )
+#define EPOCH_TEST_MAGIC              ( 0x45504f43 )
+
+typedef struct _EpochTestNode
+{
+  uint32_t magic;
+  uint32_t value;
+  KEpochNode epochNode;
+}EpochTestNode;
+
+typedef struct _EpochTestData
+{
+  KThread readers[ EPOCH_TEST_READERS ];
+  uint8_t stacks[ EPOCH_TEST_READERS ][ EPOCH_TEST_STACK_SIZE ];
+  uint8_t poolStore[ POOL_STORE_SIZE( EPOCH_TEST_NODES, sizeof( EpochTestNode ) ) ];
+  MemPool pool;
+  KEpochDomain domain;
+  KAtomicPtr pShared;
+  KAtomicU32 isSwapping;
+  KAtomicU32 corrupt;
+  KAtomicU32 reads;
+}EpochTestData;
+
+static EpochTestData s_epochTest;
+
+static void setUp( void )
+{
+  PoolCreate( &s_epochTest.pool, s_epochTest.poolStore, sizeof( s_epochTest.poolStore ), EPOCH_TEST_NODES );
+  KEpochDomainCreate( &s_epochTest.domain );
+  KAtomicStorePtr( &s_epochTest.pShared, NULL, KATOMIC_RELAXED );
+  KAtomicStore32( &s_epochTest.corrupt, 0, KATOMIC_RELAXED );
+  KAtomicStore32( &s_epochTest.reads, 0, KATOMIC_RELAXED );
+}
+
+static void tearDown( void )
+{
+  KEpochDomainDestroy( &s_epochTest.domain );
+  PoolRelease( &s_epochTest.pool );
+}
+
+static EpochTestNode* NewNode( uint32_t value )
+{
+  EpochTestNode* pNode = ( EpochTestNode* )PoolAlloc( &s_epochTest.pool );
+  if ( pNode ) {
+    //Scribbles on reused nodes, a reader still holding one sees it change
+    pNode->magic = 0;
+    KAtomicFence( KATOMIC_RELEASE );
+    pNode->magic = EPOCH_TEST_MAGIC;
+    pNode->value = value;
+  }
+  return pNode;
+}
+
+static void RetireNode( KEpochThread* pThread, EpochTestNode* pNode )
+{
+  KEpochRetire( pThread, &pNode->epochNode, &s_epochTest.pool, pNode );
+}
+
+static void Reader( void* arg )
+{
+  KEpochThread* pThread = KEpochRegister( &s_epochTest.domain );
+  volatile EpochTestNode* pNode = NULL;
+  uint32_t value = 0;
+  uint32_t reads = 0;
+  if ( !pThread ) {
+    KAtomicFetchAdd32( &s_epochTest.corrupt, 1, KATOMIC_RELAXED );
+    return;
+  }
+  while( KAtomicLoad32( &s_epochTest.isSwapping, KATOMIC_ACQUIRE ) ) {
+    KEpochEnter( pThread );
+    pNode = ( EpochTestNode* )KAtomicLoadPtr( &s_epochTest.pShared, KATOMIC_ACQUIRE );
+    value = pNode->value;
+    //Now and then let the writer retire the node while it is held
+    if ( ( ++reads % EPOCH_TEST_HOLD_EVERY ) == 0 ) {
+      KThreadSleep( 1 );
+    }
+    if ( pNode->magic != EPOCH_TEST_MAGIC || pNode->value != value ) {
+      KAtomicFetchAdd32( &s_epochTest.corrupt, 1, KATOMIC_RELAXED );
+    }
+    KEpochExit( pThread );
+    KAtomicFetchAdd32( &s_epochTest.reads, 1, KATOMIC_RELAXED );
+  }
+  KEpochUnregister( pThread );
+}
+
+static void RetiredObjectOutlivesReaders( void )
+{
+  KEpochThread* pThread = KEpochRegister( &s_epochTest.domain );
+  EpochTestNode* pNode = NULL;
+  uint32_t i = 0;
+  TEST_ASSERT_NOT_NULL( pThread );
+  for( i = 0; i < EPOCH_TEST_NODES; i++ ) {
+    pNode = NewNode( i );
+  }
+  TEST_ASSERT_NULL( PoolAlloc( &s_epochTest.pool ) );
+  KEpochEnter( pThread );
+  RetireNode( pThread, pNode );
+  for( i = 0; i < 4; i++ ) {
+    TEST_ASSERT_EQUAL_INT( 1, KEpochReclaim( pThread ) );
+  }
+  TEST_ASSERT_NULL( PoolAlloc( &s_epochTest.pool ) );
+  TEST_ASSERT_EQUAL_INT( EPOCH_TEST_MAGIC, pNode->magic );
+  KEpochExit( pThread );
+  for( i = 0; i < 4 && KEpochReclaim( pThread ); i++ );
+  TEST_ASSERT_EQUAL_INT( 0, KEpochReclaim( pThread ) );
+  TEST_ASSERT( PoolAlloc( &s_epochTest.pool ) == pNode );
+  KEpochUnregister( pThread );
+}
+
+static void RegisterIsBounded( void )
+{
+  KEpochThread* threads[ KEPOCH_THREADS_MAX ];
+  KEpochThread* pThread = NULL;
+  uint32_t i = 0;
+  for( i = 0; i < KEPOCH_THREADS_MAX; i++ ) {
+    threads[ i ] = KEpochRegister( &s_epochTest.domain );
+    TEST_ASSERT_NOT_NULL( threads[ i ] );
+  }
+  TEST_ASSERT_NULL( KEpochRegister( &s_epochTest.domain ) );
+  KEpochUnregister( threads[ 0 ] );
+  pThread = KEpochRegister( &s_epochTest.domain );
+  TEST_ASSERT( pThread == threads[ 0 ] );
+  for( i = 0; i < KEPOCH_THREADS_MAX; i++ ) {
+    KEpochUnregister( threads[ i ] );
+  }
+}
+
+static void ReadersNeverSeeFreedObjects( void )
+{
+  KEpochThread* pThread = KEpochRegister( &s_epochTest.domain );
+  EpochTestNode* pNode = NULL;
+  EpochTestNode* pOld = NULL;
+  uint32_t i = 0;
+  TEST_ASSERT_NOT_NULL( pThread );
+  KAtomicStorePtr( &s_epochTest.pShared, NewNode( 0 ), KATOMIC_RELEASE );
+  KAtomicStore32( &s_epochTest.isSwapping, true, KATOMIC_RELAXED );
+  for( i = 0; i < EPOCH_TEST_READERS; i++ ) {
+    KTHREAD_CREATE_PARAMS( readerParams,
+                           "EpochTest",
+                           Reader,
+                           NULL,
+                           s_epochTest.stacks[ i ],
+                           EPOCH_TEST_STACK_SIZE,
+                           SEMANTIC_THREAD_PRIORITY_MID );
+    TEST_ASSERT( KThreadCreate( &s_epochTest.readers[ i ], KTHREAD_PARAMS( readerParams ) ) );
+  }
+  for( i = 1; i <= EPOCH_TEST_SWAPS || KAtomicLoad32( &s_epochTest.reads, KATOMIC_RELAXED ) < EPOCH_TEST_READS; i++ ) {
+    while( !( pNode = NewNode( i ) ) ) {
+      //Every node is waiting on a reader
+      KEpochReclaim( pThread );
+      KThreadSleep( 1 );
+    }
+    pOld = ( EpochTestNode* )KAtomicExchangePtr( &s_epochTest.pShared, pNode, KATOMIC_ACQ_REL );
+    RetireNode( pThread, pOld );
+  }
+  KAtomicStore32( &s_epochTest.isSwapping, false, KATOMIC_RELEASE );
+  for( i = 0; i < EPOCH_TEST_READERS; i++ ) {
+    TEST_ASSERT( KThreadDelete( &s_epochTest.readers[ i ] ) );
+  }
+  pOld = ( EpochTestNode* )KAtomicExchangePtr( &s_epochTest.pShared, NULL, KATOMIC_ACQ_REL );
+  RetireNode( pThread, pOld );
+  KEpochUnregister( pThread );
+  TEST_ASSERT_EQUAL_INT( 0, KAtomicLoad32( &s_epochTest.corrupt, KATOMIC_RELAXED ) );
+}
+
+TestRef EpochTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "RetiredObjectOutlivesReaders", RetiredObjectOutlivesReaders ),
+    new_TestFixture( "RegisterIsBounded", RegisterIsBounded ),
+    new_TestFixture( "ReadersNeverSeeFreedObjects", ReadersNeverSeeFreedObjects )
+  };
+  EMB_UNIT_TESTCALLER( EpochApiTest, "EpochApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&EpochApiTest;
+}
@@ -0,0 +1,124 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <EventInterface.h>
+#include <ThreadInterface.h>
+#include <TimeInterface.h>
+
+#define EVENT_TEST_STACK_SIZE         ( 1 << 14 )
+#define EVENT_TEST_WAIT_MS            ( 1000 )
+
+#define EVENT_TEST_SHUTDOWN           ( 1 << 0 )
+#define EVENT_TEST_DATA               ( 1 << 1 )
+#define EVENT_TEST_TIMER              ( 1 << 2 )
+
+typedef struct _EventTestData
+{
+  KThread thread;
+  uint8_t stack[ EVENT_TEST_STACK_SIZE ];
+  KEvent event;
+  uint32_t delayMs;
+  uint32_t flagsToSet;
+}EventTestData;
+
+static EventTestData s_eventTest;
+
+static void setUp( void )
+{
+  KEventCreate( &s_eventTest.event, "EventTest" );
+}
+
+static void tearDown( void )
+{
+  KEventDelete( &s_eventTest.event );
+}
+
+static void DelayedSetter( void* arg )
+{
+  KThreadSleep( s_eventTest.delayMs );
+  KEventSet( &s_eventTest.event, s_eventTest.flagsToSet );
+}
+
+static void SetLater( uint32_t flags, uint32_t delayMs )
+{
+  KTHREAD_CREATE_PARAMS( setterParams,
+                         "EventTestSetter",
+                         DelayedSetter,
+                         NULL,
+                         s_eventTest.stack,
+                         EVENT_TEST_STACK_SIZE,
+                         SEMANTIC_THREAD_PRIORITY_MID );
+  s_eventTest.flagsToSet = flags;
+  s_eventTest.delayMs = delayMs;
+  TEST_ASSERT( KThreadCreate( &s_eventTest.thread, KTHREAD_PARAMS( setterParams ) ) );
+}
+
+static void WaitAnyWakesOnOneFlag( void )
+{
+  KEvent* pEvent = &s_eventTest.event;
+  uint32_t flags = 0;
+  SetLater( EVENT_TEST_DATA, 5 );
+  flags = KEventWait( pEvent, EVENT_TEST_SHUTDOWN | EVENT_TEST_DATA | EVENT_TEST_TIMER, KEVENT_WAIT_ANY, EVENT_TEST_WAIT_MS );
+  TEST_ASSERT_EQUAL_INT( EVENT_TEST_DATA, flags );
+  TEST_ASSERT( KThreadDelete( &s_eventTest.thread ) );
+  //Without KEVENT_CLEAR_ON_EXIT the flag stays set
+  TEST_ASSERT_EQUAL_INT( EVENT_TEST_DATA, KEventGet( pEvent ) );
+  TEST_ASSERT_EQUAL_INT( EVENT_TEST_DATA, KEventClear( pEvent, EVENT_TEST_DATA ) );
+  TEST_ASSERT_EQUAL_INT( 0, KEventGet( pEvent ) );
+}
+
+static void WaitAllNeedsEveryFlag( void )
+{
+  KEvent* pEvent = &s_eventTest.event;
+  uint32_t flags = 0;
+  KEventSet( pEvent, EVENT_TEST_DATA );
+  TEST_ASSERT_EQUAL_INT( 0, KEventWait( pEvent, EVENT_TEST_DATA | EVENT_TEST_TIMER, KEVENT_WAIT_ALL, NO_SLEEP ) );
+  SetLater( EVENT_TEST_TIMER, 5 );
+  flags = KEventWait( pEvent, EVENT_TEST_DATA | EVENT_TEST_TIMER, KEVENT_WAIT_ALL | KEVENT_CLEAR_ON_EXIT, EVENT_TEST_WAIT_MS );
+  TEST_ASSERT_EQUAL_INT( ( EVENT_TEST_DATA | EVENT_TEST_TIMER ), flags );
+  TEST_ASSERT( KThreadDelete( &s_eventTest.thread ) );
+  TEST_ASSERT_EQUAL_INT( 0, KEventGet( pEvent ) );
+}
+
+static void WaitTimesOut( void )
+{
+  KEvent* pEvent = &s_eventTest.event;
+  uint64_t start = KTimeGetMicroseconds();
+  KEventSet( pEvent, EVENT_TEST_TIMER );
+  TEST_ASSERT_EQUAL_INT( 0, KEventWait( pEvent, EVENT_TEST_SHUTDOWN, KEVENT_WAIT_ANY, 20 ) );
+  TEST_ASSERT( KTimeGetMicroseconds() - start >= 20000 );
+  TEST_ASSERT_EQUAL_INT( 0, KEventWait( pEvent, EVENT_TEST_SHUTDOWN, KEVENT_WAIT_ANY, NO_SLEEP ) );
+  TEST_ASSERT_EQUAL_INT( EVENT_TEST_TIMER, KEventWait( pEvent, EVENT_TEST_TIMER, KEVENT_WAIT_ANY, NO_SLEEP ) );
+}
+
+TestRef EventTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "WaitAnyWakesOnOneFlag", WaitAnyWakesOnOneFlag ),
+    new_TestFixture( "WaitAllNeedsEveryFlag", WaitAllNeedsEveryFlag ),
+    new_TestFixture( "WaitTimesOut", WaitTimesOut )
+  };
+  EMB_UNIT_TESTCALLER( EventApiTest, "EventApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&EventApiTest;
+}
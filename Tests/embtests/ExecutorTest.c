@@ -0,0 +1,196 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <Executor.h>
+#include <ThreadInterface.h>
+#include <SemaphoreInterface.h>
+#include <string.h>
+
+#define EXECUTOR_TEST_DEQUE_DEPTH       ( 16 )
+#define EXECUTOR_TEST_TASKS             ( 32 )
+#define EXECUTOR_TEST_STACK_SIZE        ( 1 << 16 )
+#define EXECUTOR_TEST_SUM_RANGE         ( 1 << 14 )
+#define EXECUTOR_TEST_SUM_LEAF          ( 64 )
+#define EXECUTOR_TEST_WORKERS           ( 4 )
+
+KEXECUTOR_DEF( executorTest, EXECUTOR_TEST_DEQUE_DEPTH, EXECUTOR_TEST_TASKS );
+
+typedef struct _ExecutorTestData
+{
+  uint8_t stackStore[ KEXECUTOR_WORKERS_MAX * EXECUTOR_TEST_STACK_SIZE ];
+  uint8_t ran[ EXECUTOR_TEST_TASKS ];
+  KSema startedSema;
+  KSema releaseSema;
+}ExecutorTestData;
+
+static ExecutorTestData s_executorTest;
+
+typedef struct _SumRange
+{
+  uint32_t first;
+  uint32_t last;
+  uint64_t sum;
+}SumRange;
+
+static bool CreateExecutor( uint32_t workerCount, uint32_t dequeDepth )
+{
+  KExecutorDef def = 
+  {
+    .pName = "executorTest",
+    .workerCount = workerCount,
+    .stackSize = EXECUTOR_TEST_STACK_SIZE,
+    .priority = SEMANTIC_THREAD_PRIORITY_MID,
+    .pStack = s_executorTest.stackStore,
+    .pBackingStore = KEXECUTOR_STORE( executorTest ),
+    .dequeDepth = dequeDepth,
+    .taskCount = EXECUTOR_TEST_TASKS
+  };
+  return KExecutorCreate( &KEXECUTOR( executorTest ), &def );
+}
+
+static void setUp( void )
+{
+  memset( s_executorTest.ran, 0, sizeof( s_executorTest.ran ) );
+  KSemaCreate( &s_executorTest.startedSema, "ExecutorTestStarted", 0 );
+  KSemaCreate( &s_executorTest.releaseSema, "ExecutorTestRelease", 0 );
+}
+
+static void tearDown( void )
+{
+  KExecutorDestroy( &KEXECUTOR( executorTest ) );
+  KSemaDelete( &s_executorTest.startedSema );
+  KSemaDelete( &s_executorTest.releaseSema );
+}
+
+static void MarkRan( KExecutorWorker* pWorker, void* arg )
+{
+  s_executorTest.ran[ ( uintptr_t )arg ] = 1;
+}
+
+static void BlockTillReleased( KExecutorWorker* pWorker, void* arg )
+{
+  KSemaPut( &s_executorTest.startedSema );
+  KSemaGet( &s_executorTest.releaseSema, WAIT_FOREVER );
+}
+
+static void SumTask( KExecutorWorker* pWorker, void* arg )
+{
+  SumRange* pRange = ( SumRange* )arg;
+  uint32_t i = 0;
+  if ( ( pRange->last - pRange->first ) <= EXECUTOR_TEST_SUM_LEAF ) {
+    pRange->sum = 0;
+    for( i = pRange->first; i < pRange->last; i++ ) {
+      pRange->sum += i;
+    }
+  }
+  else {
+    uint32_t middle = pRange->first + ( ( pRange->last - pRange->first ) / 2 );
+    SumRange left = { pRange->first, middle, 0 };
+    SumRange right = { middle, pRange->last, 0 };
+    KTaskGroup group;
+    KTaskGroupInit( &group );
+    KExecutorSpawn( pWorker, &group, SumTask, &left );
+    SumTask( pWorker, &right );
+    KExecutorJoin( pWorker, &group );
+    KTaskGroupDestroy( &group );
+    pRange->sum = left.sum + right.sum;
+  }
+}
+
+static void ExecutorCanBeCreated( void )
+{
+  uint32_t expected = KThreadGetCpuCount();
+  if ( expected > KEXECUTOR_WORKERS_MAX ) {
+    expected = KEXECUTOR_WORKERS_MAX;
+  }
+  TEST_ASSERT( CreateExecutor( 0, EXECUTOR_TEST_DEQUE_DEPTH ) );
+  TEST_ASSERT_EQUAL_INT( expected, KExecutorGetWorkerCount( &KEXECUTOR( executorTest ) ) );
+}
+
+static void DequeDepthMustBePowerOf2( void )
+{
+  TEST_ASSERT( !CreateExecutor( 2, EXECUTOR_TEST_DEQUE_DEPTH - 1 ) );
+}
+
+static void SubmittedTasksAllRun( void )
+{
+  KTaskGroup group;
+  uintptr_t i = 0;
+  TEST_ASSERT( CreateExecutor( 2, EXECUTOR_TEST_DEQUE_DEPTH ) );
+  TEST_ASSERT( KTaskGroupInit( &group ) );
+  for( i = 0; i < EXECUTOR_TEST_TASKS; i++ ) {
+    TEST_ASSERT( KExecutorSubmit( &KEXECUTOR( executorTest ), &group, MarkRan, ( void* )i ) );
+  }
+  KTaskGroupWait( &group );
+  KTaskGroupDestroy( &group );
+  for( i = 0; i < EXECUTOR_TEST_TASKS; i++ ) {
+    TEST_ASSERT( s_executorTest.ran[ i ] );
+  }
+}
+
+static void ForkJoinSumsRange( void )
+{
+  SumRange range = { 0, EXECUTOR_TEST_SUM_RANGE, 0 };
+  KTaskGroup group;
+  TEST_ASSERT( CreateExecutor( EXECUTOR_TEST_WORKERS, EXECUTOR_TEST_DEQUE_DEPTH ) );
+  TEST_ASSERT( KTaskGroupInit( &group ) );
+  TEST_ASSERT( KExecutorSubmit( &KEXECUTOR( executorTest ), &group, SumTask, &range ) );
+  KTaskGroupWait( &group );
+  KTaskGroupDestroy( &group );
+  TEST_ASSERT( range.sum == ( ( uint64_t )EXECUTOR_TEST_SUM_RANGE * ( EXECUTOR_TEST_SUM_RANGE - 1 ) ) / 2 );
+}
+
+static void SubmitFailsWhenTasksExhausted( void )
+{
+  KTaskGroup group;
+  uintptr_t i = 0;
+  TEST_ASSERT( CreateExecutor( 1, EXECUTOR_TEST_DEQUE_DEPTH ) );
+  TEST_ASSERT( KTaskGroupInit( &group ) );
+  //Keep the only worker busy, its task is handed back once it starts
+  TEST_ASSERT( KExecutorSubmit( &KEXECUTOR( executorTest ), &group, BlockTillReleased, NULL ) );
+  TEST_ASSERT( KSemaGet( &s_executorTest.startedSema, WAIT_FOREVER ) );
+  for( i = 0; i < EXECUTOR_TEST_TASKS; i++ ) {
+    TEST_ASSERT( KExecutorSubmit( &KEXECUTOR( executorTest ), &group, MarkRan, ( void* )i ) );
+  }
+  TEST_ASSERT( !KExecutorSubmit( &KEXECUTOR( executorTest ), &group, MarkRan, NULL ) );
+  KSemaPut( &s_executorTest.releaseSema );
+  KTaskGroupWait( &group );
+  KTaskGroupDestroy( &group );
+  for( i = 0; i < EXECUTOR_TEST_TASKS; i++ ) {
+    TEST_ASSERT( s_executorTest.ran[ i ] );
+  }
+}
+
+TestRef ExecutorTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "ExecutorCanBeCreated", ExecutorCanBeCreated ),
+    new_TestFixture( "DequeDepthMustBePowerOf2", DequeDepthMustBePowerOf2 ),
+    new_TestFixture( "SubmittedTasksAllRun", SubmittedTasksAllRun ),
+    new_TestFixture( "ForkJoinSumsRange", ForkJoinSumsRange ),
+    new_TestFixture( "SubmitFailsWhenTasksExhausted", SubmitFailsWhenTasksExhausted )
+  };
+  EMB_UNIT_TESTCALLER( ExecutorApiTest, "ExecutorApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&ExecutorApiTest;
+}
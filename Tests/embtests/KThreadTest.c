@@ -25,6 +25,8 @@
 #include <embUnit/embUnit.h>
 #include <ThreadInterface.h>
 #include <MutexInterface.h>
+#include <SemaphoreInterface.h>
+#include <string.h>
 
 typedef struct _ThreadTest1Data
 {
@@ -52,7 +54,7 @@ static void TearDown(void)
 typedef struct _ThreadData
 {
   KThread thread;
-  uint8_t stack[ 1024 ];
+  uint8_t stack[ 1 << 16 ];
 }ThreadData;
 
 
@@ -99,7 +101,8 @@ static ThreadData s_testThreadHi;
 static void TestBasicPremption( void )
 {
   memset( &s_tst1, 0, sizeof( s_tst1 ));
-  if( KMutexCreate( &s_tst1.mtx, "ThreadPremptTestMtx" )) {
+  TEST_ASSERT( KMutexCreate( &s_tst1.mtx, "ThreadPremptTestMtx" ) );
+  {
     s_tst1.value = 0;
     KTHREAD_CREATE_PARAMS( threadParamsMid,
                            "ThreadPremptTestMid",
@@ -112,26 +115,168 @@ static void TestBasicPremption( void )
                            "ThreadPremptTestHi",
                            PremptTestThreadHi,
                            NULL,
-                           s_testThreadMid.stack,
-                           sizeof( s_testThreadMid.stack ),
+                           s_testThreadHi.stack,
+                           sizeof( s_testThreadHi.stack ),
                            SEMANTIC_THREAD_PRIORITY_HIGH );
-    if( KThreadCreate( &s_testThreadMid.thread, KTHREAD_PARAMS( threadParamsMid ) )) {
-      if( KThreadCreate( &s_testThreadHi.thread, KTHREAD_PARAMS( threadParamsHi ) )) {
-        TEST_ASSERT( KThreadJoin( &s_testThreadMid.thread ) );
-        TEST_ASSERT( KThreadJoin( &s_testThreadHi.thread ) );
-        TEST_ASSERT( KThreadDelete( &s_testThreadMid.thread ) );
-        TEST_ASSERT( KThreadDelete( &s_testThreadHi.thread ) );
-      }
-    }
+    TEST_ASSERT( KThreadCreate( &s_testThreadMid.thread, KTHREAD_PARAMS( threadParamsMid ) ) );
+    TEST_ASSERT( KThreadCreate( &s_testThreadHi.thread, KTHREAD_PARAMS( threadParamsHi ) ) );
+    TEST_ASSERT( KThreadJoin( &s_testThreadMid.thread ) );
+    TEST_ASSERT( KThreadJoin( &s_testThreadHi.thread ) );
+    TEST_ASSERT( KThreadDelete( &s_testThreadMid.thread ) );
+    TEST_ASSERT( KThreadDelete( &s_testThreadHi.thread ) );
     KMutexDelete( &s_tst1.mtx );
   }
 }
 
+typedef struct _SchedThreadData
+{
+  KThread thread;
+  uint8_t stack[ 1 << 14 ];
+}SchedThreadData;
+
+static SchedThreadData s_testThreadSched;
+static void SchedParamsAreApplied( void )
+{
+  KThreadSchedParams sched = { .policy = KTHREAD_SCHED_OTHER, .cpuAffinityMask = 1 };
+  KTHREAD_CREATE_PARAMS_SCHED( schedThreadParams,
+                               "ThreadSchedTest",
+                               TestThreadFunction,
+                               NULL,
+                               s_testThreadSched.stack,
+                               sizeof( s_testThreadSched.stack ),
+                               SEMANTIC_THREAD_PRIORITY_MID,
+                               sched );
+  s_tst1.value = 0;
+  TEST_ASSERT( KThreadCreate( &s_testThreadSched.thread, KTHREAD_PARAMS( schedThreadParams ) ) );
+  TEST_ASSERT( KThreadDelete( &s_testThreadSched.thread ) );
+  TEST_ASSERT( s_tst1.value == 1 );
+}
+
+static void NiceNeedsTimeSharedPolicy( void )
+{
+  KThreadSchedParams sched = { .policy = KTHREAD_SCHED_FIFO, .niceValue = 5 };
+  KTHREAD_CREATE_PARAMS_SCHED( schedThreadParams,
+                               "ThreadSchedTest",
+                               TestThreadFunction,
+                               NULL,
+                               s_testThreadSched.stack,
+                               sizeof( s_testThreadSched.stack ),
+                               SEMANTIC_THREAD_PRIORITY_MID,
+                               sched );
+  TEST_ASSERT( !KThreadCreate( &s_testThreadSched.thread, KTHREAD_PARAMS( schedThreadParams ) ) );
+}
+
+static uintptr_t s_stackLocal;
+
+static void StackFunction( void *arg )
+{
+  uint8_t local = 0;
+  s_stackLocal = ( uintptr_t )&local;
+}
+
+static void CallerStackIsUsed( void )
+{
+  KTHREAD_CREATE_PARAMS( stackThreadParams,
+                         "ThreadStackTest",
+                         StackFunction,
+                         NULL,
+                         s_testThreadSched.stack,
+                         sizeof( s_testThreadSched.stack ),
+                         SEMANTIC_THREAD_PRIORITY_MID );
+  uint32_t i = 0;
+  //Joining hands the stack back, the same buffer can be used again right away
+  for( i = 0; i < 2; i++ ) {
+    s_stackLocal = 0;
+    TEST_ASSERT( KThreadCreate( &s_testThreadSched.thread, KTHREAD_PARAMS( stackThreadParams ) ) );
+    TEST_ASSERT( KThreadJoin( &s_testThreadSched.thread ) );
+    TEST_ASSERT( s_stackLocal >= ( uintptr_t )s_testThreadSched.stack );
+    TEST_ASSERT( s_stackLocal < ( uintptr_t )s_testThreadSched.stack + sizeof( s_testThreadSched.stack ) );
+    TEST_ASSERT( KThreadDelete( &s_testThreadSched.thread ) );
+  }
+  memset( s_testThreadSched.stack, 0, sizeof( s_testThreadSched.stack ) );
+}
+
+/**
+ * Sized for an RTOS, smaller than some ports accept. 
+ */
+static uint8_t s_smallStack[ 1024 ];
+static void SmallStackStillRuns( void )
+{
+  KTHREAD_CREATE_PARAMS( smallThreadParams,
+                         "ThreadSmallStackTest",
+                         TestThreadFunction,
+                         NULL,
+                         s_smallStack,
+                         sizeof( s_smallStack ),
+                         SEMANTIC_THREAD_PRIORITY_MID );
+  s_tst1.value = 0;
+  TEST_ASSERT( KThreadCreate( &s_testThreadA.thread, KTHREAD_PARAMS( smallThreadParams ) ) );
+  TEST_ASSERT( KThreadJoin( &s_testThreadA.thread ) );
+  TEST_ASSERT( s_tst1.value == 1 );
+  TEST_ASSERT( KThreadDelete( &s_testThreadA.thread ) );
+}
+
+typedef struct _ThreadLocalTestData
+{
+  KThreadLocal key;
+  KSema destroyedSema;
+  uint32_t mainValue;
+  uint32_t threadValue;
+  void* pSeenFirst;
+  void* pSeenLast;
+  void* pDestroyed;
+}ThreadLocalTestData;
+
+static ThreadLocalTestData s_localTest;
+
+static void DestroyLocal( void* pValue )
+{
+  s_localTest.pDestroyed = pValue;
+  KSemaPut( &s_localTest.destroyedSema );
+}
+
+static void ThreadLocalFunction( void* arg )
+{
+  s_localTest.pSeenFirst = KThreadLocalGet( s_localTest.key );
+  KThreadLocalSet( s_localTest.key, &s_localTest.threadValue );
+  s_localTest.pSeenLast = KThreadLocalGet( s_localTest.key );
+}
+
+static void ThreadLocalsArePerThread( void )
+{
+  KTHREAD_CREATE_PARAMS( localThreadParams,
+                         "ThreadLocalTest",
+                         ThreadLocalFunction,
+                         NULL,
+                         s_testThreadSched.stack,
+                         sizeof( s_testThreadSched.stack ),
+                         SEMANTIC_THREAD_PRIORITY_MID );
+  TEST_ASSERT( KSemaCreate( &s_localTest.destroyedSema, "ThreadLocalTest", 0 ) );
+  TEST_ASSERT( KThreadLocalCreate( &s_localTest.key, DestroyLocal ) );
+  TEST_ASSERT( KThreadLocalGet( s_localTest.key ) == NULL );
+  KThreadLocalSet( s_localTest.key, &s_localTest.mainValue );
+  TEST_ASSERT( KThreadCreate( &s_testThreadSched.thread, KTHREAD_PARAMS( localThreadParams ) ) );
+  //The destructor runs once the thread function has returned
+  TEST_ASSERT( KSemaGet( &s_localTest.destroyedSema, 1000 ) );
+  TEST_ASSERT( KThreadDelete( &s_testThreadSched.thread ) );
+  TEST_ASSERT( s_localTest.pSeenFirst == NULL );
+  TEST_ASSERT( s_localTest.pSeenLast == &s_localTest.threadValue );
+  TEST_ASSERT( s_localTest.pDestroyed == &s_localTest.threadValue );
+  TEST_ASSERT( KThreadLocalGet( s_localTest.key ) == &s_localTest.mainValue );
+  KThreadLocalSet( s_localTest.key, NULL );
+  KSemaDelete( &s_localTest.destroyedSema );
+}
+
 TestRef KThreadTest_ApiTests()
 {
   EMB_UNIT_TESTFIXTURES(fixtures) {
     new_TestFixture( "TreadApiTest", ThreadApiTest ),
-    new_TestFixture( "BasicPremption", TestBasicPremption )
+    new_TestFixture( "BasicPremption", TestBasicPremption ),
+    new_TestFixture( "SchedParamsAreApplied", SchedParamsAreApplied ),
+    new_TestFixture( "NiceNeedsTimeSharedPolicy", NiceNeedsTimeSharedPolicy ),
+    new_TestFixture( "ThreadLocalsArePerThread", ThreadLocalsArePerThread ),
+    new_TestFixture( "CallerStackIsUsed", CallerStackIsUsed ),
+    new_TestFixture( "SmallStackStillRuns", SmallStackStillRuns )
 
   };
   EMB_UNIT_TESTCALLER( KThreadBasic, "KThreadBasic", SetUp, TearDown, fixtures );
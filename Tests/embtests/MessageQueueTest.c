@@ -0,0 +1,349 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <embUnit.h>
+#include <MessageQueue.h>
+#include <ThreadInterface.h>
+
+#define MESSAGE_QUEUE_TEST_DEPTH        ( 4 )
+#define MESSAGE_QUEUE_TEST_STACK_SIZE   ( 1 << 14 )
+
+typedef struct _QueueTestItem
+{
+  uint32_t key;
+  uint32_t val;
+}QueueTestItem;
+
+MESSAGE_QUEUE_COALESCING_DEF( coalescingTest, MESSAGE_QUEUE_TEST_DEPTH );
+MESSAGE_QUEUE_DEF( overflowTest, MESSAGE_QUEUE_TEST_DEPTH );
+
+typedef struct _MessageQueueTestData
+{
+  bool queueCreated;
+  bool overflowQueueCreated;
+  QueueTestItem* pLastDiscarded;
+  uint32_t numDiscarded;
+}MessageQueueTestData;
+
+static MessageQueueTestData s_queueTest;
+
+static bool ItemKey( void* pContext, void* pItem, uint32_t* pKey )
+{
+  *pKey = ( ( QueueTestItem* )pItem )->key;
+  return true;
+}
+
+static void* ItemSum( void* pContext, void* pPending, void* pNew )
+{
+  ( ( QueueTestItem* )pPending )->val += ( ( QueueTestItem* )pNew )->val;
+  return pPending;
+}
+
+static void ItemDiscard( void* pContext, void* pItem )
+{
+  MessageQueueTestData* pData = ( MessageQueueTestData* )pContext;
+  pData->pLastDiscarded = ( QueueTestItem* )pItem;
+  pData->numDiscarded++;
+}
+
+static bool ItemEvictable( void* pContext, void* pItem )
+{
+  //Key 0 stands in for a control item that must be delivered
+  return ( ( QueueTestItem* )pItem )->key != 0;
+}
+
+static void setUp( void )
+{
+  s_queueTest.pLastDiscarded = 0;
+  s_queueTest.numDiscarded = 0;
+  s_queueTest.queueCreated = MessageQueueInitializeCoalescing( &MESSAGE_QUEUE( coalescingTest ),
+                                                               MESSAGE_QUEUE_STORE( coalescingTest ),
+                                                               MESSAGE_QUEUE_TEST_DEPTH,
+                                                               MESSAGE_QUEUE_INDEX_STORE( coalescingTest ),
+                                                               ItemKey,
+                                                               NULL );
+  MessageQueueSetContext( &MESSAGE_QUEUE( coalescingTest ), &s_queueTest );
+  MessageQueueSetDiscardHandler( &MESSAGE_QUEUE( coalescingTest ), ItemDiscard );
+  s_queueTest.overflowQueueCreated = MessageQueueInitialize( &MESSAGE_QUEUE( overflowTest ),
+                                                             MESSAGE_QUEUE_STORE( overflowTest ),
+                                                             MESSAGE_QUEUE_TEST_DEPTH );
+  MessageQueueSetContext( &MESSAGE_QUEUE( overflowTest ), &s_queueTest );
+  MessageQueueSetDiscardHandler( &MESSAGE_QUEUE( overflowTest ), ItemDiscard );
+}
+
+static void tearDown( void )
+{
+  MessageQueueDeInitialize( &MESSAGE_QUEUE( coalescingTest ) );
+  MessageQueueDeInitialize( &MESSAGE_QUEUE( overflowTest ) );
+}
+
+static void FillOverflowQueue( QueueTestItem* pItems )
+{
+  for( uint32_t i = 0; i < MESSAGE_QUEUE_TEST_DEPTH; i++ ) {
+    pItems[ i ].key = i;
+    pItems[ i ].val = i;
+    TEST_ASSERT( MessageQueueEnQueue( &MESSAGE_QUEUE( overflowTest ), &pItems[ i ] ) );
+  }
+}
+
+static void CoalescingQueueCanBeCreated( void )
+{
+  TEST_ASSERT( s_queueTest.queueCreated );
+}
+
+static void LatestItemReplacesPending( void )
+{
+  MessageQueue* pQ = &MESSAGE_QUEUE( coalescingTest );
+  QueueTestItem a = { 1, 10 }, b = { 2, 20 }, aNew = { 1, 11 };
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &a ) );
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &b ) );
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &aNew ) );
+  TEST_ASSERT_EQUAL_INT( 1, s_queueTest.numDiscarded );
+  TEST_ASSERT( s_queueTest.pLastDiscarded == &a );
+  //The replacement keeps the position of the original
+  TEST_ASSERT( MessageQueueDeQueue( pQ ) == &aNew );
+  TEST_ASSERT( MessageQueueDeQueue( pQ ) == &b );
+}
+
+static void FullQueueStillCoalesces( void )
+{
+  MessageQueue* pQ = &MESSAGE_QUEUE( coalescingTest );
+  QueueTestItem items[ MESSAGE_QUEUE_TEST_DEPTH ];
+  QueueTestItem update = { 0, 100 };
+  for( uint32_t i = 0; i < MESSAGE_QUEUE_TEST_DEPTH; i++ ) {
+    items[ i ].key = i;
+    items[ i ].val = i;
+    TEST_ASSERT( MessageQueueEnQueue( pQ, &items[ i ] ) );
+  }
+  //Would block forever if it needed a free slot
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &update ) );
+  TEST_ASSERT( s_queueTest.pLastDiscarded == &items[ 0 ] );
+  TEST_ASSERT( MessageQueueDeQueue( pQ ) == &update );
+  for( uint32_t i = 1; i < MESSAGE_QUEUE_TEST_DEPTH; i++ ) {
+    TEST_ASSERT( MessageQueueDeQueue( pQ ) == &items[ i ] );
+  }
+}
+
+static void MergeKeepsPendingItem( void )
+{
+  MessageQueue* pQ = &MESSAGE_QUEUE( coalescingTest );
+  QueueTestItem a = { 7, 1 }, a2 = { 7, 2 }, a3 = { 7, 3 };
+  pQ->fnMerge = ItemSum;
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &a ) );
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &a2 ) );
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &a3 ) );
+  TEST_ASSERT_EQUAL_INT( 2, s_queueTest.numDiscarded );
+  TEST_ASSERT( s_queueTest.pLastDiscarded == &a3 );
+  TEST_ASSERT( MessageQueueDeQueue( pQ ) == &a );
+  TEST_ASSERT_EQUAL_INT( 6, a.val );
+}
+
+static void IndexSurvivesWrapAround( void )
+{
+  MessageQueue* pQ = &MESSAGE_QUEUE( coalescingTest );
+  QueueTestItem items[ 3 ];
+  for( uint32_t round = 0; round < 50; round++ ) {
+    for( uint32_t i = 0; i < 3; i++ ) {
+      items[ i ].key = ( round * 3 + i ) % 5;
+      items[ i ].val = round;
+      TEST_ASSERT( MessageQueueEnQueue( pQ, &items[ i ] ) );
+    }
+    for( uint32_t i = 0; i < 3; i++ ) {
+      TEST_ASSERT( MessageQueueDeQueue( pQ ) == &items[ i ] );
+    }
+  }
+  TEST_ASSERT_EQUAL_INT( 0, s_queueTest.numDiscarded );
+}
+
+static void FailPolicyRejects( void )
+{
+  MessageQueue* pQ = &MESSAGE_QUEUE( overflowTest );
+  QueueTestItem items[ MESSAGE_QUEUE_TEST_DEPTH ], extra = { 9, 9 };
+  MessageQueueStats stats;
+  TEST_ASSERT( s_queueTest.overflowQueueCreated );
+  MessageQueueSetOverflowPolicy( pQ, MESSAGE_QUEUE_OVERFLOW_FAIL, 0 );
+  FillOverflowQueue( items );
+  TEST_ASSERT( !MessageQueueEnQueue( pQ, &extra ) );
+  //The item stays with the producer
+  TEST_ASSERT_EQUAL_INT( 0, s_queueTest.numDiscarded );
+  MessageQueueGetStats( pQ, &stats );
+  TEST_ASSERT_EQUAL_INT( 1, stats.rejected );
+  TEST_ASSERT( MessageQueueDeQueue( pQ ) == &items[ 0 ] );
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &extra ) );
+}
+
+static void DropNewestDiscardsItem( void )
+{
+  MessageQueue* pQ = &MESSAGE_QUEUE( overflowTest );
+  QueueTestItem items[ MESSAGE_QUEUE_TEST_DEPTH ], extra = { 9, 9 };
+  MessageQueueStats stats;
+  MessageQueueSetOverflowPolicy( pQ, MESSAGE_QUEUE_OVERFLOW_DROP_NEWEST, 0 );
+  FillOverflowQueue( items );
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &extra ) );
+  TEST_ASSERT( s_queueTest.pLastDiscarded == &extra );
+  MessageQueueGetStats( pQ, &stats );
+  TEST_ASSERT_EQUAL_INT( 1, stats.droppedNewest );
+  for( uint32_t i = 0; i < MESSAGE_QUEUE_TEST_DEPTH; i++ ) {
+    TEST_ASSERT( MessageQueueDeQueue( pQ ) == &items[ i ] );
+  }
+}
+
+static void DropOldestKeepsOrder( void )
+{
+  MessageQueue* pQ = &MESSAGE_QUEUE( overflowTest );
+  QueueTestItem items[ MESSAGE_QUEUE_TEST_DEPTH ], extra[ 2 ];
+  MessageQueueStats stats;
+  MessageQueueSetOverflowPolicy( pQ, MESSAGE_QUEUE_OVERFLOW_DROP_OLDEST, 0 );
+  FillOverflowQueue( items );
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &extra[ 0 ] ) );
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &extra[ 1 ] ) );
+  TEST_ASSERT_EQUAL_INT( 2, s_queueTest.numDiscarded );
+  TEST_ASSERT( s_queueTest.pLastDiscarded == &items[ 1 ] );
+  MessageQueueGetStats( pQ, &stats );
+  TEST_ASSERT_EQUAL_INT( 2, stats.droppedOldest );
+  for( uint32_t i = 2; i < MESSAGE_QUEUE_TEST_DEPTH; i++ ) {
+    TEST_ASSERT( MessageQueueDeQueue( pQ ) == &items[ i ] );
+  }
+  TEST_ASSERT( MessageQueueDeQueue( pQ ) == &extra[ 0 ] );
+  TEST_ASSERT( MessageQueueDeQueue( pQ ) == &extra[ 1 ] );
+}
+
+static void DropOldestSkipsPinnedItems( void )
+{
+  MessageQueue* pQ = &MESSAGE_QUEUE( coalescingTest );
+  QueueTestItem items[ MESSAGE_QUEUE_TEST_DEPTH ], extra = { 9, 9 }, update = { 0, 100 };
+  MessageQueueSetOverflowPolicy( pQ, MESSAGE_QUEUE_OVERFLOW_DROP_OLDEST, 0 );
+  MessageQueueSetEvictFilter( pQ, ItemEvictable );
+  for( uint32_t i = 0; i < MESSAGE_QUEUE_TEST_DEPTH; i++ ) {
+    items[ i ].key = i;
+    items[ i ].val = i;
+    TEST_ASSERT( MessageQueueEnQueue( pQ, &items[ i ] ) );
+  }
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &extra ) );
+  TEST_ASSERT( s_queueTest.pLastDiscarded == &items[ 1 ] );
+  //The pinned item moved up a slot, the index has to follow it
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &update ) );
+  TEST_ASSERT( s_queueTest.pLastDiscarded == &items[ 0 ] );
+  TEST_ASSERT( MessageQueueDeQueue( pQ ) == &update );
+  for( uint32_t i = 2; i < MESSAGE_QUEUE_TEST_DEPTH; i++ ) {
+    TEST_ASSERT( MessageQueueDeQueue( pQ ) == &items[ i ] );
+  }
+  TEST_ASSERT( MessageQueueDeQueue( pQ ) == &extra );
+}
+
+static void BlockDeadlineTimesOut( void )
+{
+  MessageQueue* pQ = &MESSAGE_QUEUE( overflowTest );
+  QueueTestItem items[ MESSAGE_QUEUE_TEST_DEPTH ], extra = { 9, 9 };
+  MessageQueueStats stats;
+  MessageQueueSetOverflowPolicy( pQ, MESSAGE_QUEUE_OVERFLOW_BLOCK_DEADLINE, 20 );
+  FillOverflowQueue( items );
+  TEST_ASSERT( !MessageQueueEnQueue( pQ, &extra ) );
+  MessageQueueGetStats( pQ, &stats );
+  TEST_ASSERT_EQUAL_INT( 1, stats.timedOut );
+  //A per call policy overrides the queue default
+  TEST_ASSERT( MessageQueueEnQueueEx( pQ, &extra, MESSAGE_QUEUE_OVERFLOW_DROP_NEWEST, 0 ) );
+  TEST_ASSERT( s_queueTest.pLastDiscarded == &extra );
+}
+
+typedef struct _SpinTestProducer
+{
+  KThread thread;
+  uint8_t stack[ MESSAGE_QUEUE_TEST_STACK_SIZE ];
+  uint32_t delayMs;
+  QueueTestItem item;
+}SpinTestProducer;
+
+static SpinTestProducer s_producer;
+
+static void DelayedProducer( void* arg )
+{
+  SpinTestProducer* pProducer = ( SpinTestProducer* )arg;
+  KThreadSleep( pProducer->delayMs );
+  MessageQueueEnQueue( &MESSAGE_QUEUE( overflowTest ), &pProducer->item );
+}
+
+static void StartDelayedProducer( uint32_t delayMs )
+{
+  KTHREAD_CREATE_PARAMS( producerParams,
+                         "SpinTestProducer",
+                         DelayedProducer,
+                         &s_producer,
+                         s_producer.stack,
+                         sizeof( s_producer.stack ),
+                         SEMANTIC_THREAD_PRIORITY_MID );
+  s_producer.delayMs = delayMs;
+  TEST_ASSERT( KThreadCreate( &s_producer.thread, KTHREAD_PARAMS( producerParams ) ) );
+}
+
+static void SpinningDequeuePollsItem( void )
+{
+  MessageQueue* pQ = &MESSAGE_QUEUE( overflowTest );
+  MessageQueueStats stats;
+  //Spin long enough that the item always shows up while polling
+  MessageQueueSetSpin( pQ, 1000000 );
+  StartDelayedProducer( 1 );
+  TEST_ASSERT( MessageQueueDeQueue( pQ ) == &s_producer.item );
+  TEST_ASSERT( KThreadDelete( &s_producer.thread ) );
+  MessageQueueGetStats( pQ, &stats );
+  TEST_ASSERT_EQUAL_INT( 1, stats.polled );
+  TEST_ASSERT_EQUAL_INT( 0, stats.blocked );
+}
+
+static void SpinExpiresAndBlocks( void )
+{
+  MessageQueue* pQ = &MESSAGE_QUEUE( overflowTest );
+  QueueTestItem item = { 1, 1 };
+  MessageQueueStats stats;
+  MessageQueueSetSpin( pQ, 1000 );
+  //Items already queued are taken without spinning or blocking
+  TEST_ASSERT( MessageQueueEnQueue( pQ, &item ) );
+  TEST_ASSERT( MessageQueueDeQueue( pQ ) == &item );
+  StartDelayedProducer( 50 );
+  TEST_ASSERT( MessageQueueDeQueue( pQ ) == &s_producer.item );
+  TEST_ASSERT( KThreadDelete( &s_producer.thread ) );
+  MessageQueueGetStats( pQ, &stats );
+  TEST_ASSERT_EQUAL_INT( 0, stats.polled );
+  TEST_ASSERT_EQUAL_INT( 1, stats.blocked );
+}
+
+TestRef MessageQueueTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "CoalescingQueueCanBeCreated", CoalescingQueueCanBeCreated ),
+    new_TestFixture( "LatestItemReplacesPending", LatestItemReplacesPending ),
+    new_TestFixture( "FullQueueStillCoalesces", FullQueueStillCoalesces ),
+    new_TestFixture( "MergeKeepsPendingItem", MergeKeepsPendingItem ),
+    new_TestFixture( "IndexSurvivesWrapAround", IndexSurvivesWrapAround ),
+    new_TestFixture( "FailPolicyRejects", FailPolicyRejects ),
+    new_TestFixture( "DropNewestDiscardsItem", DropNewestDiscardsItem ),
+    new_TestFixture( "DropOldestKeepsOrder", DropOldestKeepsOrder ),
+    new_TestFixture( "DropOldestSkipsPinnedItems", DropOldestSkipsPinnedItems ),
+    new_TestFixture( "BlockDeadlineTimesOut", BlockDeadlineTimesOut ),
+    new_TestFixture( "SpinningDequeuePollsItem", SpinningDequeuePollsItem ),
+    new_TestFixture( "SpinExpiresAndBlocks", SpinExpiresAndBlocks )
+  };
+  EMB_UNIT_TESTCALLER( MessageQueueApiTest, "MessageQueueApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&MessageQueueApiTest;
+}
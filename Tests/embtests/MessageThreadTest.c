@@ -23,9 +23,24 @@
  */
 #include <embUnit/embUnit.h>
 #include <MessageThread.h>
+#include <MessageCoroutine.h>
+#include <TimeInterface.h>
+#include <ThreadInterface.h>
+#include <SemaphoreInterface.h>
+#include <MutexInterface.h>
+
+#define MESSAGE_THREAD_TEST_NUM_MESSAGES        ( 8 )
+#define MESSAGE_THREAD_TEST_WORKERS             ( 3 )
+#define MESSAGE_THREAD_TEST_STACK_SIZE          ( 1 << 15 )
+#define MESSAGE_THREAD_TEST_WAIT_MS             ( 1000 )
+#define MESSAGE_THREAD_TEST_CALL_TIMEOUT_MS     ( 10 )
+#define MESSAGE_THREAD_TEST_CO_DELAY_US         ( 5000 )
+#define MESSAGE_THREAD_TEST_BUDGET_US           ( 2000 )
+#define MESSAGE_THREAD_TEST_TIMER_DELAY_US      ( 20000 )
+#define MESSAGE_THREAD_TEST_TIMER_PERIOD_US     ( 2000 )
+#define MESSAGE_THREAD_TEST_TIMER_REPEATS       ( 3 )
+#define MESSAGE_THREAD_TEST_FILL_COROUTINES     ( 2 )
 
-#define MESSAGE_THREAD_TEST_NUM_MESSAGES        (50)
-#if 0
 typedef struct _MessageThreadTestDataType
 {
   uint32_t val;
@@ -34,28 +49,549 @@ typedef struct _MessageThreadTestDataType
 typedef struct _MessageThreadTest
 {
   uint8_t msgStore[ MESSAGE_THREAD_BACKING_STORE_SIZE( MESSAGE_THREAD_TEST_NUM_MESSAGES, MessageThreadTestDataType ) ];
+  uint8_t stackStore[ MESSAGE_THREAD_TEST_WORKERS * MESSAGE_THREAD_TEST_STACK_SIZE ];
+  uint8_t coMsgStore[ MESSAGE_THREAD_BACKING_STORE_SIZE( MESSAGE_THREAD_TEST_NUM_MESSAGES, MessageThreadTestDataType ) ];
+  uint8_t coStackStore[ MESSAGE_THREAD_TEST_STACK_SIZE ];
+  KMutex mutex;
+  KSema releaseSema;
+  uint32_t numProcessed;
+  uint32_t numInside;
+  uint32_t maxInside;
+  uint32_t valSum;
+  uint64_t firstProcessedUs;
+  bool blockInProcess;
+  KThread destroyer;
+  MessageThreadHandle hDestroyed;
+  KSema destroyedSema;
+  MessageCoroutine fillCo[ MESSAGE_THREAD_TEST_FILL_COROUTINES ];
 }MessageThreadTest;
 
 static MessageThreadTest s_tstData;
 
-static void SetUp()
+static void TestInit( MessageThreadHandle hThread )
+{
+}
+
+static void TestProcess( MessageThreadHandle hThread, MessageHandle hMessage )
+{
+  KMutexLock( &s_tstData.mutex, WAIT_FOREVER );
+  if ( s_tstData.numProcessed++ == 0 ) {
+    s_tstData.firstProcessedUs = KTimeGetMicroseconds();
+  }
+  s_tstData.valSum += ( ( MessageThreadTestDataType* )hMessage )->val;
+  s_tstData.numInside++;
+  s_tstData.maxInside = ( s_tstData.numInside > s_tstData.maxInside ) ? s_tstData.numInside : s_tstData.maxInside;
+  KMutexUnlock( &s_tstData.mutex );
+  if ( s_tstData.blockInProcess ) {
+    KSemaGet( &s_tstData.releaseSema, MESSAGE_THREAD_TEST_WAIT_MS );
+  }
+  KMutexLock( &s_tstData.mutex, WAIT_FOREVER );
+  s_tstData.numInside--;
+  KMutexUnlock( &s_tstData.mutex );
+  //The response to a MessageThreadCall()
+  ( ( MessageThreadTestDataType* )hMessage )->val++;
+}
+
+MESSAGE_THREAD_GROUP_DEF( testThread, s_tstData.stackStore, MESSAGE_THREAD_TEST_STACK_SIZE, SEMANTIC_THREAD_PRIORITY_MID,
+                          s_tstData.msgStore, MESSAGE_THREAD_TEST_NUM_MESSAGES, MessageThreadTestDataType, NULL,
+                          TestInit, TestProcess, 1 );
+MESSAGE_THREAD_GROUP_DEF( testGroup, s_tstData.stackStore, MESSAGE_THREAD_TEST_STACK_SIZE, SEMANTIC_THREAD_PRIORITY_MID,
+                          s_tstData.msgStore, MESSAGE_THREAD_TEST_NUM_MESSAGES, MessageThreadTestDataType, NULL,
+                          TestInit, TestProcess, MESSAGE_THREAD_TEST_WORKERS );
+MESSAGE_THREAD_GROUP_DEF( testCoThread, s_tstData.coStackStore, MESSAGE_THREAD_TEST_STACK_SIZE, SEMANTIC_THREAD_PRIORITY_MID,
+                          s_tstData.coMsgStore, MESSAGE_THREAD_TEST_NUM_MESSAGES, MessageThreadTestDataType, NULL,
+                          TestInit, TestProcess, 1 );
+static const MessageThreadDef s_budgetThreadDef =
+{
+  .threadName = "testBudgetThread",
+  .stackSize = MESSAGE_THREAD_TEST_STACK_SIZE,
+  .priority = SEMANTIC_THREAD_PRIORITY_MID,
+  .messageBackingStore = s_tstData.msgStore,
+  .messageQDepth = MESSAGE_THREAD_TEST_NUM_MESSAGES,
+  .messageSize = sizeof( MessageThreadTestDataType ),
+  .fnInit = TestInit,
+  .fnProcess = TestProcess,
+  .pStack = s_tstData.stackStore,
+  .processBudgetUs = MESSAGE_THREAD_TEST_BUDGET_US,
+  .queueBudgetUs = MESSAGE_THREAD_TEST_BUDGET_US
+};
+static const MessageThreadDef s_dropOldestThreadDef =
+{
+  .threadName = "testDropOldestThread",
+  .stackSize = MESSAGE_THREAD_TEST_STACK_SIZE,
+  .priority = SEMANTIC_THREAD_PRIORITY_MID,
+  .messageBackingStore = s_tstData.msgStore,
+  .messageQDepth = MESSAGE_THREAD_TEST_NUM_MESSAGES,
+  .messageSize = sizeof( MessageThreadTestDataType ),
+  .fnInit = TestInit,
+  .fnProcess = TestProcess,
+  .pStack = s_tstData.stackStore,
+  .overflowPolicy = MESSAGE_QUEUE_OVERFLOW_DROP_OLDEST
+};
+MESSAGE_THREAD_GROUP_DEF( testHugeGroup, s_tstData.stackStore, MESSAGE_THREAD_TEST_STACK_SIZE, SEMANTIC_THREAD_PRIORITY_MID,
+                          s_tstData.msgStore, MESSAGE_THREAD_TEST_NUM_MESSAGES, MessageThreadTestDataType, NULL,
+                          TestInit, TestProcess, MESSAGE_THREAD_WORKERS_MAX + 1 );
+
+static void SetUp( void )
+{
+  MessageThreadSystemInit();
+  KMutexCreate( &s_tstData.mutex, "MessageThreadTest" );
+  KSemaCreate( &s_tstData.releaseSema, "MessageThreadTest", 0 );
+  s_tstData.numProcessed = 0;
+  s_tstData.numInside = 0;
+  s_tstData.maxInside = 0;
+  s_tstData.valSum = 0;
+  s_tstData.firstProcessedUs = 0;
+  s_tstData.blockInProcess = false;
+}
+
+static void TearDown( void )
+{
+  KSemaDelete( &s_tstData.releaseSema );
+  KMutexDelete( &s_tstData.mutex );
+}
+
+static void PostMessages( MessageThreadHandle hThread, uint32_t count )
+{
+  uint32_t i = 0;
+  for( i = 0; i < count; i++ ) {
+    MessageThreadTestDataType* pMsg = ( MessageThreadTestDataType* )MessageThreadAllocateMessage( hThread );
+    pMsg->val = i;
+    TEST_ASSERT( MessageThreadPost( hThread, pMsg ) );
+  }
+}
+
+static void MessageThreadCanCreate( void )
+{
+  uint32_t i = 0;
+  //Destroying a thread must give back its slot in the thread table
+  for( i = 0; i < MESSAGE_THREADS_MAX + 1; i++ ) {
+    MessageThreadHandle hThread = MessageThreadCreate( MESSAGE_THREAD( testThread ) );
+    TEST_ASSERT( hThread );
+    PostMessages( hThread, MESSAGE_THREAD_TEST_NUM_MESSAGES );
+    //Pending messages are processed before the thread exits
+    MessageThreadDestroy( hThread );
+  }
+  TEST_ASSERT_EQUAL_INT( ( MESSAGE_THREADS_MAX + 1 ) * MESSAGE_THREAD_TEST_NUM_MESSAGES, s_tstData.numProcessed );
+  TEST_ASSERT_EQUAL_INT( 1, s_tstData.maxInside );
+}
+
+static void GroupWorkersRunConcurrently( void )
+{
+  MessageThreadHandle hGroup = MessageThreadCreate( MESSAGE_THREAD( testGroup ) );
+  uint32_t i = 0;
+  TEST_ASSERT( hGroup );
+  s_tstData.blockInProcess = true;
+  PostMessages( hGroup, MESSAGE_THREAD_TEST_WORKERS );
+  //Every worker ends up blocked in a message at the same time
+  for( i = 0; i < MESSAGE_THREAD_TEST_WAIT_MS && s_tstData.maxInside < MESSAGE_THREAD_TEST_WORKERS; i++ ) {
+    KThreadSleep( 1 );
+  }
+  for( i = 0; i < MESSAGE_THREAD_TEST_WORKERS; i++ ) {
+    KSemaPut( &s_tstData.releaseSema );
+  }
+  MessageThreadDestroy( hGroup );
+  TEST_ASSERT_EQUAL_INT( MESSAGE_THREAD_TEST_WORKERS, s_tstData.maxInside );
+  TEST_ASSERT_EQUAL_INT( MESSAGE_THREAD_TEST_WORKERS, s_tstData.numProcessed );
+}
+
+static void TooManyWorkersFails( void )
+{
+  TEST_ASSERT( !MessageThreadCreate( MESSAGE_THREAD( testHugeGroup ) ) );
+}
+
+static void CallReturnsReply( void )
+{
+  MessageThreadHandle hThread = MessageThreadCreate( MESSAGE_THREAD( testThread ) );
+  uint32_t i = 0;
+  TEST_ASSERT( hThread );
+  //Wait slots are handed back after every call
+  for( i = 0; i < MESSAGE_THREAD_CALL_SLOTS_MAX + 1; i++ ) {
+    MessageThreadTestDataType reply = { 0 };
+    MessageThreadTestDataType* pMsg = ( MessageThreadTestDataType* )MessageThreadAllocateMessage( hThread );
+    pMsg->val = i;
+    TEST_ASSERT( MessageThreadCall( hThread, pMsg, &reply, MESSAGE_THREAD_TEST_WAIT_MS ) );
+    TEST_ASSERT_EQUAL_INT( i + 1, reply.val );
+  }
+  MessageThreadDestroy( hThread );
+  TEST_ASSERT_EQUAL_INT( MESSAGE_THREAD_CALL_SLOTS_MAX + 1, s_tstData.numProcessed );
+}
+
+static void CallTimesOut( void )
+{
+  MessageThreadHandle hThread = MessageThreadCreate( MESSAGE_THREAD( testThread ) );
+  MessageThreadTestDataType reply = { 0 };
+  MessageThreadTestDataType* pMsg = NULL;
+  TEST_ASSERT( hThread );
+  s_tstData.blockInProcess = true;
+  pMsg = ( MessageThreadTestDataType* )MessageThreadAllocateMessage( hThread );
+  TEST_ASSERT( !MessageThreadCall( hThread, pMsg, &reply, MESSAGE_THREAD_TEST_CALL_TIMEOUT_MS ) );
+  s_tstData.blockInProcess = false;
+  KSemaPut( &s_tstData.releaseSema );
+  //The abandoned call must not disturb the next one
+  pMsg = ( MessageThreadTestDataType* )MessageThreadAllocateMessage( hThread );
+  pMsg->val = 41;
+  TEST_ASSERT( MessageThreadCall( hThread, pMsg, &reply, MESSAGE_THREAD_TEST_WAIT_MS ) );
+  TEST_ASSERT_EQUAL_INT( 42, reply.val );
+  MessageThreadDestroy( hThread );
+  TEST_ASSERT_EQUAL_INT( 2, s_tstData.numProcessed );
+}
+
+static void FillVal( MessageHandle hMessage, void* pArg )
+{
+  ( ( MessageThreadTestDataType* )hMessage )->val = *( uint32_t* )pArg;
+}
+
+static void PostCopyAndFillAllocateInPlace( void )
+{
+  MessageThreadHandle hThread = MessageThreadCreate( MESSAGE_THREAD( testThread ) );
+  MessageThreadTestDataType msg = { 0 };
+  uint32_t i = 0, expectedSum = 0;
+  TEST_ASSERT( hThread );
+  s_tstData.blockInProcess = true;
+  for( i = 0; i < MESSAGE_THREAD_TEST_NUM_MESSAGES; i++ ) {
+    msg.val = i;
+    if ( i % 2 ) {
+      TEST_ASSERT( MessageThreadPostCopy( hThread, &msg, sizeof( msg ) ) );
+    }
+    else {
+      TEST_ASSERT( MessageThreadPostFill( hThread, FillVal, &msg.val ) );
+    }
+    expectedSum += i;
+  }
+  for( i = 0; i < MESSAGE_THREAD_TEST_WAIT_MS && !s_tstData.maxInside; i++ ) {
+    KThreadSleep( 1 );
+  }
+  //The Q has room again but every message is in use, the post fails without blocking
+  TEST_ASSERT( !MessageThreadPostCopy( hThread, &msg, sizeof( msg ) ) );
+  s_tstData.blockInProcess = false;
+  KSemaPut( &s_tstData.releaseSema );
+  MessageThreadDestroy( hThread );
+  TEST_ASSERT_EQUAL_INT( MESSAGE_THREAD_TEST_NUM_MESSAGES, s_tstData.numProcessed );
+  TEST_ASSERT_EQUAL_INT( expectedSum, s_tstData.valSum );
+}
+
+typedef struct _StatsVisitData
+{
+  MessageThreadHandle hThread;
+  uint32_t timesSeen;
+  MessageThreadStats stats;
+}StatsVisitData;
+
+static void StatsVisit( void* pContext, MessageThreadHandle hThread, const MessageThreadStats* pStats )
+{
+  StatsVisitData* pData = ( StatsVisitData* )pContext;
+  if ( hThread == pData->hThread ) {
+    pData->timesSeen++;
+    pData->stats = *pStats;
+  }
+}
+
+static void StatsCountProcessedMessages( void )
+{
+  MessageThreadHandle hThread = MessageThreadCreate( MESSAGE_THREAD( testThread ) );
+  MessageThreadTestDataType* pMsg = NULL;
+  StatsVisitData visit = { 0 };
+  uint32_t i = 0, histogramTotal = 0;
+  TEST_ASSERT( hThread );
+  PostMessages( hThread, MESSAGE_THREAD_TEST_NUM_MESSAGES - 1 );
+  //Returns once all the messages posted before it are processed
+  pMsg = ( MessageThreadTestDataType* )MessageThreadAllocateMessage( hThread );
+  TEST_ASSERT( MessageThreadCall( hThread, pMsg, NULL, MESSAGE_THREAD_TEST_WAIT_MS ) );
+  visit.hThread = hThread;
+  TEST_ASSERT( MessageThreadForEach( StatsVisit, &visit ) >= 1 );
+  TEST_ASSERT_EQUAL_INT( 1, visit.timesSeen );
+  TEST_ASSERT_EQUAL_STRING( "testThread", visit.stats.threadName );
+  TEST_ASSERT_EQUAL_INT( 1, visit.stats.workerCount );
+  TEST_ASSERT_EQUAL_INT( MESSAGE_THREAD_TEST_NUM_MESSAGES, ( uint32_t )visit.stats.processed );
+  for( i = 0; i < MESSAGE_THREAD_STATS_BUCKETS; i++ ) {
+    histogramTotal += visit.stats.histogram[ i ];
+  }
+  TEST_ASSERT_EQUAL_INT( MESSAGE_THREAD_TEST_NUM_MESSAGES, histogramTotal );
+  TEST_ASSERT( visit.stats.maxProcessUs <= visit.stats.busyUs );
+  TEST_ASSERT( visit.stats.busyUs + visit.stats.idleUs <= visit.stats.elapsedUs );
+  MessageThreadDestroy( hThread );
+  //Destroyed threads are no longer visited
+  visit.timesSeen = 0;
+  MessageThreadForEach( StatsVisit, &visit );
+  TEST_ASSERT_EQUAL_INT( 0, visit.timesSeen );
+}
+
+typedef struct _CoroutineTestState
+{
+  MessageCoroutine co;
+  MessageThreadHandle hPeer;
+  MessageHandle hRequest;
+  uint32_t replyVal;
+  uint64_t startUs;
+  uint64_t sleptUs;
+  KSema doneSema;
+}CoroutineTestState;
+
+static CoroutineTestState s_coTest;
+
+static MessageCoStatus TestCoroutine( MessageCoroutine* pCo, void* pArg )
+{
+  CoroutineTestState* pState = ( CoroutineTestState* )pArg;
+  MessageHandle hReply = NULL;
+  MESSAGE_CO_BEGIN( pCo );
+  MESSAGE_CO_AWAIT_ALLOC( pCo, pState->hPeer, pState->hRequest );
+  ( ( MessageThreadTestDataType* )pState->hRequest )->val = 41;
+  MESSAGE_CO_AWAIT_CALL( pCo, pState->hPeer, pState->hRequest );
+  hReply = MessageCoroutineGetReply( pCo );
+  if ( hReply ) {
+    pState->replyVal = ( ( MessageThreadTestDataType* )hReply )->val;
+    MessageThreadDestroyMessage( pState->hPeer, &hReply );
+  }
+  pState->startUs = KTimeGetMicroseconds();
+  MESSAGE_CO_AWAIT_DELAY( pCo, MESSAGE_THREAD_TEST_CO_DELAY_US );
+  pState->sleptUs = KTimeGetMicroseconds() - pState->startUs;
+  KSemaPut( &pState->doneSema );
+  MESSAGE_CO_END( pCo );
+}
+
+static void StartTestCoroutine( MessageThreadHandle hPeer, MessageThreadHandle hCoThread )
 {
+  s_coTest.hPeer = hPeer;
+  s_coTest.replyVal = 0;
+  s_coTest.sleptUs = 0;
+  TEST_ASSERT( KSemaCreate( &s_coTest.doneSema, "MessageCoroutineTest", 0 ) );
+  TEST_ASSERT( MessageCoroutineStart( hCoThread, &s_coTest.co, TestCoroutine, &s_coTest ) );
+}
 
+static void CoroutineAwaitsCallAndDelay( void )
+{
+  MessageThreadHandle hPeer = MessageThreadCreate( MESSAGE_THREAD( testThread ) );
+  MessageThreadHandle hCoThread = MessageThreadCreate( MESSAGE_THREAD( testCoThread ) );
+  TEST_ASSERT( hPeer && hCoThread );
+  StartTestCoroutine( hPeer, hCoThread );
+  TEST_ASSERT( KSemaGet( &s_coTest.doneSema, MESSAGE_THREAD_TEST_WAIT_MS ) );
+  TEST_ASSERT_EQUAL_INT( 42, s_coTest.replyVal );
+  //The delay is rounded to timer ticks
+  TEST_ASSERT( s_coTest.sleptUs + MESSAGE_TIMER_TICK_US >= MESSAGE_THREAD_TEST_CO_DELAY_US );
+  KSemaDelete( &s_coTest.doneSema );
+  MessageThreadDestroy( hCoThread );
+  MessageThreadDestroy( hPeer );
 }
 
-static void TearDown()
-{}
+static void CoroutineAwaitsAllocation( void )
+{
+  MessageThreadHandle hPeer = MessageThreadCreate( MESSAGE_THREAD( testThread ) );
+  MessageThreadHandle hCoThread = MessageThreadCreate( MESSAGE_THREAD( testCoThread ) );
+  MessageHandle held[ MESSAGE_THREAD_TEST_NUM_MESSAGES ];
+  uint32_t i = 0;
+  TEST_ASSERT( hPeer && hCoThread );
+  for( i = 0; i < MESSAGE_THREAD_TEST_NUM_MESSAGES; i++ ) {
+    held[ i ] = MessageThreadTryAllocateMessage( hPeer );
+    TEST_ASSERT( held[ i ] );
+  }
+  TEST_ASSERT( !MessageThreadTryAllocateMessage( hPeer ) );
+  StartTestCoroutine( hPeer, hCoThread );
+  //Stays suspended, without blocking its thread, till a message is freed
+  KThreadSleep( MESSAGE_THREAD_TEST_CALL_TIMEOUT_MS );
+  TEST_ASSERT( !KSemaGet( &s_coTest.doneSema, NO_SLEEP ) );
+  MessageThreadDestroyMessage( hPeer, &held[ 0 ] );
+  TEST_ASSERT( KSemaGet( &s_coTest.doneSema, MESSAGE_THREAD_TEST_WAIT_MS ) );
+  TEST_ASSERT_EQUAL_INT( 42, s_coTest.replyVal );
+  for( i = 1; i < MESSAGE_THREAD_TEST_NUM_MESSAGES; i++ ) {
+    MessageThreadDestroyMessage( hPeer, &held[ i ] );
+  }
+  KSemaDelete( &s_coTest.doneSema );
+  MessageThreadDestroy( hCoThread );
+  MessageThreadDestroy( hPeer );
+}
 
-static void MessageThreadCanCreate()
+typedef struct _LatencyTestData
 {
+  KSema stuckSema;
+  MessageThreadHandle hThread;
+  uint32_t numStuck;
+}LatencyTestData;
 
+static void LatencyCallback( void* pContext, const MessageLatencyEvent* pEvent )
+{
+  LatencyTestData* pData = ( LatencyTestData* )pContext;
+  if ( pEvent->hThread == pData->hThread && pEvent->kind == MESSAGE_LATENCY_STUCK ) {
+    pData->numStuck++;
+    KSemaPut( &pData->stuckSema );
+  }
 }
-TestRef MessageThreadTest_ApiTests()
+
+static void WatchdogReportsOverruns( void )
 {
-  EMB_UNIT_TESTFIXTURES(fixtures) {
+  LatencyTestData data = { 0 };
+  MessageLatencyEvent events[ 4 ];
+  MessageThreadStats stats;
+  MessageThreadTestDataType* pMsg = NULL;
+  uint32_t total = 0, numEvents = 0;
+  TEST_ASSERT( KSemaCreate( &data.stuckSema, "MessageLatencyTest", 0 ) );
+  data.hThread = MessageThreadCreate( &s_budgetThreadDef );
+  TEST_ASSERT( data.hThread );
+  MessageThreadSetLatencyCallback( LatencyCallback, &data );
+  s_tstData.blockInProcess = true;
+  PostMessages( data.hThread, 2 );
+  //The first message is stuck in the handler, the second waits behind it
+  TEST_ASSERT( KSemaGet( &data.stuckSema, MESSAGE_THREAD_TEST_WAIT_MS ) );
+  s_tstData.blockInProcess = false;
+  KSemaPut( &s_tstData.releaseSema );
+  pMsg = ( MessageThreadTestDataType* )MessageThreadAllocateMessage( data.hThread );
+  TEST_ASSERT( MessageThreadCall( data.hThread, pMsg, NULL, MESSAGE_THREAD_TEST_WAIT_MS ) );
+  MessageThreadGetStats( data.hThread, &stats );
+  TEST_ASSERT_EQUAL_INT( 1, stats.stuck );
+  TEST_ASSERT_EQUAL_INT( 1, stats.processOverruns );
+  TEST_ASSERT( stats.queueOverruns >= 1 );
+  numEvents = MessageThreadGetLatencyEvents( events, 4, &total );
+  TEST_ASSERT( numEvents >= 3 );
+  TEST_ASSERT( total >= numEvents );
+  TEST_ASSERT_EQUAL_STRING( "testBudgetThread", events[ numEvents - 1 ].threadName );
+  TEST_ASSERT( events[ numEvents - 1 ].durationUs > events[ numEvents - 1 ].budgetUs );
+  MessageThreadSetLatencyCallback( NULL, NULL );
+  MessageThreadDestroy( data.hThread );
+  KSemaDelete( &data.stuckSema );
+  TEST_ASSERT_EQUAL_INT( 1, data.numStuck );
+}
 
+static uint32_t GetNumProcessed( void )
+{
+  uint32_t retval = 0;
+  KMutexLock( &s_tstData.mutex, WAIT_FOREVER );
+  retval = s_tstData.numProcessed;
+  KMutexUnlock( &s_tstData.mutex );
+  return retval;
+}
+
+static uint32_t WaitForProcessed( uint32_t count )
+{
+  uint32_t i = 0;
+  for( i = 0; i < MESSAGE_THREAD_TEST_WAIT_MS && GetNumProcessed() < count; i++ ) {
+    KThreadSleep( 1 );
+  }
+  return GetNumProcessed();
+}
+
+static void DelayedPostArrivesAfterDelay( void )
+{
+  MessageThreadHandle hThread = MessageThreadCreate( MESSAGE_THREAD( testThread ) );
+  MessageThreadTestDataType* pMsg = NULL;
+  uint64_t postedUs = 0;
+  TEST_ASSERT( hThread );
+  pMsg = ( MessageThreadTestDataType* )MessageThreadAllocateMessage( hThread );
+  pMsg->val = 7;
+  postedUs = KTimeGetMicroseconds();
+  TEST_ASSERT( MessageThreadPostDelayed( hThread, pMsg, MESSAGE_THREAD_TEST_TIMER_DELAY_US ) );
+  //An armed message can't be armed again
+  TEST_ASSERT( !MessageThreadPostDelayed( hThread, pMsg, MESSAGE_THREAD_TEST_TIMER_DELAY_US ) );
+  TEST_ASSERT_EQUAL_INT( 1, WaitForProcessed( 1 ) );
+  TEST_ASSERT( s_tstData.firstProcessedUs - postedUs + MESSAGE_TIMER_TICK_US >= MESSAGE_THREAD_TEST_TIMER_DELAY_US );
+  TEST_ASSERT_EQUAL_INT( 7, s_tstData.valSum );
+  MessageThreadDestroy( hThread );
+}
+
+static void PeriodicPostRepeatsUntilCancelled( void )
+{
+  MessageThreadHandle hThread = MessageThreadCreate( MESSAGE_THREAD( testThread ) );
+  MessageThreadTestDataType* pMsg = NULL;
+  uint32_t numProcessed = 0;
+  TEST_ASSERT( hThread );
+  pMsg = ( MessageThreadTestDataType* )MessageThreadAllocateMessage( hThread );
+  pMsg->val = 3;
+  TEST_ASSERT( MessageThreadPostPeriodic( hThread, pMsg, MESSAGE_THREAD_TEST_TIMER_PERIOD_US ) );
+  TEST_ASSERT( WaitForProcessed( MESSAGE_THREAD_TEST_TIMER_REPEATS ) >= MESSAGE_THREAD_TEST_TIMER_REPEATS );
+  TEST_ASSERT( MessageThreadCancelTimer( hThread, pMsg ) );
+  //Lets copies posted before the cancel drain
+  KThreadSleep( 5 * MESSAGE_THREAD_TEST_TIMER_PERIOD_US / 1000 );
+  numProcessed = GetNumProcessed();
+  KThreadSleep( 10 * MESSAGE_THREAD_TEST_TIMER_PERIOD_US / 1000 );
+  TEST_ASSERT_EQUAL_INT( numProcessed, GetNumProcessed() );
+  //Every period posts a copy of the template
+  TEST_ASSERT_EQUAL_INT( 3 * numProcessed, s_tstData.valSum );
+  TEST_ASSERT( !MessageThreadCancelTimer( hThread, pMsg ) );
+  MessageThreadDestroy( hThread );
+}
+
+static void CancelledDelayedPostIsNeverDelivered( void )
+{
+  MessageThreadHandle hThread = MessageThreadCreate( MESSAGE_THREAD( testThread ) );
+  MessageThreadTestDataType* pMsg = NULL;
+  TEST_ASSERT( hThread );
+  pMsg = ( MessageThreadTestDataType* )MessageThreadAllocateMessage( hThread );
+  TEST_ASSERT( MessageThreadPostDelayed( hThread, pMsg, MESSAGE_THREAD_TEST_TIMER_DELAY_US ) );
+  TEST_ASSERT( MessageThreadCancelTimer( hThread, pMsg ) );
+  KThreadSleep( 2 * MESSAGE_THREAD_TEST_TIMER_DELAY_US / 1000 );
+  TEST_ASSERT_EQUAL_INT( 0, GetNumProcessed() );
+  MessageThreadDestroy( hThread );
+}
+
+static MessageCoStatus FillCoroutine( MessageCoroutine* pCo, void* pArg )
+{
+  MESSAGE_CO_BEGIN( pCo );
+  MESSAGE_CO_END( pCo );
+}
+
+static void DestroyInBackground( void* arg )
+{
+  MessageThreadDestroy( s_tstData.hDestroyed );
+  KSemaPut( &s_tstData.destroyedSema );
+}
+
+static void DestroyFullDropOldestThread( void )
+{
+  MessageThreadHandle hThread = MessageThreadCreate( &s_dropOldestThreadDef );
+  MessageThreadTestDataType* pTemplate = NULL;
+  uint32_t i = 0;
+  TEST_ASSERT( hThread );
+  TEST_ASSERT( KSemaCreate( &s_tstData.destroyedSema, "MessageThreadTest", 0 ) );
+  s_tstData.blockInProcess = true;
+  PostMessages( hThread, 1 );
+  TEST_ASSERT_EQUAL_INT( 1, WaitForProcessed( 1 ) );
+  //Leaves one message free for the periodic copies
+  PostMessages( hThread, MESSAGE_THREAD_TEST_NUM_MESSAGES - 3 );
+  s_tstData.hDestroyed = hThread;
+  KTHREAD_CREATE_PARAMS( destroyerParams,
+                         "MessageThreadTestDestroyer",
+                         DestroyInBackground,
+                         NULL,
+                         s_tstData.coStackStore,
+                         MESSAGE_THREAD_TEST_STACK_SIZE,
+                         SEMANTIC_THREAD_PRIORITY_MID );
+  TEST_ASSERT( KThreadCreate( &s_tstData.destroyer, KTHREAD_PARAMS( destroyerParams ) ) );
+  KThreadSleep( 10 );
+  //The DIE message is queued, coroutine wake ups fill the Q the rest of the way
+  for( i = 0; i < MESSAGE_THREAD_TEST_FILL_COROUTINES; i++ ) {
+    TEST_ASSERT( MessageCoroutineStart( hThread, &s_tstData.fillCo[ i ], FillCoroutine, NULL ) );
+  }
+  pTemplate = ( MessageThreadTestDataType* )MessageThreadAllocateMessage( hThread );
+  pTemplate->val = 0;
+  TEST_ASSERT( MessageThreadPostPeriodic( hThread, pTemplate, MESSAGE_THREAD_TEST_TIMER_PERIOD_US ) );
+  //Every period the copy evicts the oldest message, which must never be a control one
+  KThreadSleep( 20 * MESSAGE_THREAD_TEST_TIMER_PERIOD_US / 1000 );
+  s_tstData.blockInProcess = false;
+  KSemaPut( &s_tstData.releaseSema );
+  TEST_ASSERT( KSemaGet( &s_tstData.destroyedSema, MESSAGE_THREAD_TEST_WAIT_MS ) );
+  TEST_ASSERT( KThreadDelete( &s_tstData.destroyer ) );
+  //The posted messages were all evicted before the worker got back to the Q
+  TEST_ASSERT_EQUAL_INT( 1, GetNumProcessed() );
+  KSemaDelete( &s_tstData.destroyedSema );
+}
+
+TestRef MessageThreadTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "MessageThreadCanCreate", MessageThreadCanCreate ),
+    new_TestFixture( "GroupWorkersRunConcurrently", GroupWorkersRunConcurrently ),
+    new_TestFixture( "TooManyWorkersFails", TooManyWorkersFails ),
+    new_TestFixture( "CallReturnsReply", CallReturnsReply ),
+    new_TestFixture( "CallTimesOut", CallTimesOut ),
+    new_TestFixture( "PostCopyAndFillAllocateInPlace", PostCopyAndFillAllocateInPlace ),
+    new_TestFixture( "StatsCountProcessedMessages", StatsCountProcessedMessages ),
+    new_TestFixture( "CoroutineAwaitsCallAndDelay", CoroutineAwaitsCallAndDelay ),
+    new_TestFixture( "CoroutineAwaitsAllocation", CoroutineAwaitsAllocation ),
+    new_TestFixture( "WatchdogReportsOverruns", WatchdogReportsOverruns ),
+    new_TestFixture( "DelayedPostArrivesAfterDelay", DelayedPostArrivesAfterDelay ),
+    new_TestFixture( "PeriodicPostRepeatsUntilCancelled", PeriodicPostRepeatsUntilCancelled ),
+    new_TestFixture( "CancelledDelayedPostIsNeverDelivered", CancelledDelayedPostIsNeverDelivered ),
+    new_TestFixture( "DestroyFullDropOldestThread", DestroyFullDropOldestThread )
   };
   EMB_UNIT_TESTCALLER( MessageThreadApiTest, "MessageThreadApiTest", SetUp, TearDown, fixtures );
-  return &MessageThreadApiTest;
+  return ( TestRef )&MessageThreadApiTest;
 }
-#endif
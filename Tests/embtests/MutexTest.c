@@ -0,0 +1,123 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <MutexInterface.h>
+#include <ThreadInterface.h>
+
+#define MUTEX_TEST_THREADS            ( 4 )
+#define MUTEX_TEST_ITERATIONS         ( 20000 )
+#define MUTEX_TEST_STACK_SIZE         ( 1 << 14 )
+
+typedef struct _MutexTestData
+{
+  KThread threads[ MUTEX_TEST_THREADS ];
+  uint8_t stacks[ MUTEX_TEST_THREADS ][ MUTEX_TEST_STACK_SIZE ];
+  KMutex mutex;
+  uint32_t count;
+}MutexTestData;
+
+static MutexTestData s_mutexTest;
+
+static void setUp( void )
+{
+  s_mutexTest.count = 0;
+}
+
+static void tearDown( void )
+{
+}
+
+static void CountUnderLock( void* arg )
+{
+  uint32_t i = 0;
+  for( i = 0; i < MUTEX_TEST_ITERATIONS; i++ ) {
+    KMutexLock( &s_mutexTest.mutex, WAIT_FOREVER );
+    s_mutexTest.count++;
+    KMutexUnlock( &s_mutexTest.mutex );
+  }
+}
+
+static void CountWithKind( KMutexKind kind, uint32_t ceiling )
+{
+  uint32_t i = 0;
+  s_mutexTest.count = 0;
+  if ( !KMutexCreateEx( &s_mutexTest.mutex, "MutexTest", kind, ceiling ) ) {
+    //Only a ceiling can be refused, when real time priorities aren't allowed
+    TEST_ASSERT( kind == KMUTEX_KIND_PRIO_CEILING );
+  } else {
+    for( i = 0; i < MUTEX_TEST_THREADS; i++ ) {
+      KTHREAD_CREATE_PARAMS( counterParams,
+                             "MutexTestCounter",
+                             CountUnderLock,
+                             NULL,
+                             s_mutexTest.stacks[ i ],
+                             MUTEX_TEST_STACK_SIZE,
+                             SEMANTIC_THREAD_PRIORITY_MID );
+      TEST_ASSERT( KThreadCreate( &s_mutexTest.threads[ i ], KTHREAD_PARAMS( counterParams ) ) );
+    }
+    for( i = 0; i < MUTEX_TEST_THREADS; i++ ) {
+      TEST_ASSERT( KThreadDelete( &s_mutexTest.threads[ i ] ) );
+    }
+    KMutexDelete( &s_mutexTest.mutex );
+    TEST_ASSERT_EQUAL_INT( MUTEX_TEST_THREADS * MUTEX_TEST_ITERATIONS, s_mutexTest.count );
+  }
+}
+
+static void EveryKindExcludes( void )
+{
+  CountWithKind( KMUTEX_KIND_DEFAULT, 0 );
+  CountWithKind( KMUTEX_KIND_FAST, 0 );
+  CountWithKind( KMUTEX_KIND_ADAPTIVE, 0 );
+  CountWithKind( KMUTEX_KIND_PRIO_INHERIT, 0 );
+  CountWithKind( KMUTEX_KIND_PRIO_CEILING, SEMANTIC_THREAD_PRIORITY_HIGH );
+}
+
+static void CeilingMutexesNest( void )
+{
+  KMutex inner;
+  if ( !KMutexCreateEx( &s_mutexTest.mutex, "MutexTest", KMUTEX_KIND_PRIO_CEILING, SEMANTIC_THREAD_PRIORITY_HIGH ) ) {
+    //No real time priorities for this process, nothing to nest
+  } else {
+    TEST_ASSERT( KMutexCreateEx( &inner, "MutexTestInner", KMUTEX_KIND_PRIO_CEILING, SEMANTIC_THREAD_PRIORITY_HIGH ) );
+    TEST_ASSERT( KMutexLock( &s_mutexTest.mutex, WAIT_FOREVER ) );
+    TEST_ASSERT( KMutexLock( &inner, WAIT_FOREVER ) );
+    KMutexUnlock( &inner );
+    KMutexUnlock( &s_mutexTest.mutex );
+    //Once both are dropped the thread is lowered again and taking one raises it afresh
+    TEST_ASSERT( KMutexLock( &inner, NO_SLEEP ) );
+    KMutexUnlock( &inner );
+    KMutexDelete( &inner );
+    KMutexDelete( &s_mutexTest.mutex );
+  }
+}
+
+TestRef MutexTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "EveryKindExcludes", EveryKindExcludes ),
+    new_TestFixture( "CeilingMutexesNest", CeilingMutexesNest )
+  };
+  EMB_UNIT_TESTCALLER( MutexApiTest, "MutexApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&MutexApiTest;
+}
@@ -0,0 +1,165 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <RwLockInterface.h>
+#include <ThreadInterface.h>
+
+#define RWLOCK_TEST_READERS           ( 3 )
+#define RWLOCK_TEST_WRITES            ( 2000 )
+#define RWLOCK_TEST_STACK_SIZE        ( 1 << 14 )
+#define RWLOCK_TEST_WAIT_MS           ( 1000 )
+
+typedef struct _RwLockTestData
+{
+  KThread threads[ RWLOCK_TEST_READERS + 1 ];
+  uint8_t stacks[ RWLOCK_TEST_READERS + 1 ][ RWLOCK_TEST_STACK_SIZE ];
+  KRwLock lock;
+  volatile uint32_t first;
+  volatile uint32_t second;
+  volatile bool isWriting;
+  volatile bool hasWritten;
+  uint32_t tornReads;
+}RwLockTestData;
+
+static RwLockTestData s_rwLockTest;
+
+static void setUp( void )
+{
+  s_rwLockTest.first = s_rwLockTest.second = 0;
+  s_rwLockTest.isWriting = s_rwLockTest.hasWritten = false;
+  s_rwLockTest.tornReads = 0;
+  KRwLockCreate( &s_rwLockTest.lock, "RwLockTest" );
+}
+
+static void tearDown( void )
+{
+  KRwLockDelete( &s_rwLockTest.lock );
+}
+
+static void StartThread( uint32_t index, KThreadCallback fn )
+{
+  KTHREAD_CREATE_PARAMS( rwLockParams,
+                         "RwLockTest",
+                         fn,
+                         NULL,
+                         s_rwLockTest.stacks[ index ],
+                         RWLOCK_TEST_STACK_SIZE,
+                         SEMANTIC_THREAD_PRIORITY_MID );
+  TEST_ASSERT( KThreadCreate( &s_rwLockTest.threads[ index ], KTHREAD_PARAMS( rwLockParams ) ) );
+}
+
+static void Writer( void* arg )
+{
+  uint32_t i = 0;
+  for( i = 0; i < RWLOCK_TEST_WRITES; i++ ) {
+    KRwLockWriteLock( &s_rwLockTest.lock, WAIT_FOREVER );
+    s_rwLockTest.first++;
+    s_rwLockTest.second++;
+    KRwLockWriteUnlock( &s_rwLockTest.lock );
+  }
+  s_rwLockTest.isWriting = false;
+}
+
+static void Reader( void* arg )
+{
+  while( s_rwLockTest.isWriting ) {
+    KRwLockReadLock( &s_rwLockTest.lock, WAIT_FOREVER );
+    if ( s_rwLockTest.first != s_rwLockTest.second ) {
+      s_rwLockTest.tornReads++;
+    }
+    KRwLockReadUnlock( &s_rwLockTest.lock );
+  }
+}
+
+static void WriteOnce( void* arg )
+{
+  s_rwLockTest.isWriting = true;
+  KRwLockWriteLock( &s_rwLockTest.lock, WAIT_FOREVER );
+  s_rwLockTest.hasWritten = true;
+  KRwLockWriteUnlock( &s_rwLockTest.lock );
+}
+
+static void ReadersShareWritersDont( void )
+{
+  KRwLock* pLock = &s_rwLockTest.lock;
+  TEST_ASSERT( KRwLockReadLock( pLock, NO_SLEEP ) );
+  TEST_ASSERT( KRwLockReadLock( pLock, NO_SLEEP ) );
+  TEST_ASSERT( !KRwLockWriteLock( pLock, NO_SLEEP ) );
+  //A writer that gave up must not hold off the readers
+  TEST_ASSERT( KRwLockReadLock( pLock, NO_SLEEP ) );
+  KRwLockReadUnlock( pLock );
+  KRwLockReadUnlock( pLock );
+  TEST_ASSERT( !KRwLockWriteLock( pLock, 10 ) );
+  KRwLockReadUnlock( pLock );
+  TEST_ASSERT( KRwLockWriteLock( pLock, NO_SLEEP ) );
+  TEST_ASSERT( !KRwLockReadLock( pLock, 10 ) );
+  TEST_ASSERT( !KRwLockWriteLock( pLock, NO_SLEEP ) );
+  KRwLockWriteUnlock( pLock );
+  TEST_ASSERT( KRwLockReadLock( pLock, NO_SLEEP ) );
+  KRwLockReadUnlock( pLock );
+}
+
+static void ReadersNeverSeePartialWrites( void )
+{
+  uint32_t i = 0;
+  s_rwLockTest.isWriting = true;
+  for( i = 0; i < RWLOCK_TEST_READERS; i++ ) {
+    StartThread( i, Reader );
+  }
+  StartThread( RWLOCK_TEST_READERS, Writer );
+  for( i = 0; i < RWLOCK_TEST_READERS + 1; i++ ) {
+    TEST_ASSERT( KThreadDelete( &s_rwLockTest.threads[ i ] ) );
+  }
+  TEST_ASSERT_EQUAL_INT( RWLOCK_TEST_WRITES, s_rwLockTest.first );
+  TEST_ASSERT_EQUAL_INT( 0, s_rwLockTest.tornReads );
+}
+
+static void WaitingWriterHoldsOffReaders( void )
+{
+  KRwLock* pLock = &s_rwLockTest.lock;
+  uint32_t i = 0;
+  TEST_ASSERT( KRwLockReadLock( pLock, NO_SLEEP ) );
+  StartThread( 0, WriteOnce );
+  //Give the writer time to start waiting for this reader
+  for( i = 0; i < RWLOCK_TEST_WAIT_MS && !s_rwLockTest.isWriting; i++ ) {
+    KThreadSleep( 1 );
+  }
+  KThreadSleep( 10 );
+  TEST_ASSERT( !KRwLockReadLock( pLock, NO_SLEEP ) );
+  TEST_ASSERT( !s_rwLockTest.hasWritten );
+  KRwLockReadUnlock( pLock );
+  TEST_ASSERT( KThreadDelete( &s_rwLockTest.threads[ 0 ] ) );
+  TEST_ASSERT( s_rwLockTest.hasWritten );
+}
+
+TestRef RwLockTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "ReadersShareWritersDont", ReadersShareWritersDont ),
+    new_TestFixture( "ReadersNeverSeePartialWrites", ReadersNeverSeePartialWrites ),
+    new_TestFixture( "WaitingWriterHoldsOffReaders", WaitingWriterHoldsOffReaders )
+  };
+  EMB_UNIT_TESTCALLER( RwLockApiTest, "RwLockApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&RwLockApiTest;
+}
@@ -0,0 +1,131 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <SeqLock.h>
+#include <ThreadInterface.h>
+#include <AtomicInterface.h>
+#include <string.h>
+
+#define SEQLOCK_TEST_READERS          ( 3 )
+#define SEQLOCK_TEST_WRITES           ( 20000 )
+#define SEQLOCK_TEST_READS            ( 1000 )
+#define SEQLOCK_TEST_WORDS            ( 50 )
+#define SEQLOCK_TEST_STACK_SIZE       ( 1 << 16 )
+
+typedef struct _SeqLockTestSnapshot
+{
+  uint32_t words[ SEQLOCK_TEST_WORDS ];
+}SeqLockTestSnapshot;
+
+typedef struct _SeqLockTestData
+{
+  KThread readers[ SEQLOCK_TEST_READERS ];
+  uint8_t stacks[ SEQLOCK_TEST_READERS ][ SEQLOCK_TEST_STACK_SIZE ];
+  KSeqLock lock;
+  SeqLockTestSnapshot shared;
+  KAtomicU32 isWriting;
+  KAtomicU32 torn;
+  KAtomicU32 reads;
+}SeqLockTestData;
+
+static SeqLockTestData s_seqTest;
+
+static void setUp( void )
+{
+  memset( &s_seqTest.shared, 0, sizeof( s_seqTest.shared ) );
+  KSeqLockInit( &s_seqTest.lock );
+  KAtomicStore32( &s_seqTest.torn, 0, KATOMIC_RELAXED );
+  KAtomicStore32( &s_seqTest.reads, 0, KATOMIC_RELAXED );
+}
+
+static void tearDown( void )
+{
+}
+
+static void Reader( void* arg )
+{
+  SeqLockTestSnapshot copy;
+  uint32_t i = 0;
+  while( KAtomicLoad32( &s_seqTest.isWriting, KATOMIC_ACQUIRE ) ) {
+    KSeqLockRead( &s_seqTest.lock, &copy, &s_seqTest.shared, sizeof( copy ) );
+    for( i = 1; i < SEQLOCK_TEST_WORDS; i++ ) {
+      if ( copy.words[ i ] != copy.words[ 0 ] ) {
+        KAtomicFetchAdd32( &s_seqTest.torn, 1, KATOMIC_RELAXED );
+        break;
+      }
+    }
+    KAtomicFetchAdd32( &s_seqTest.reads, 1, KATOMIC_RELAXED );
+  }
+}
+
+static void ReadersNeverSeeTornSnapshots( void )
+{
+  SeqLockTestSnapshot next;
+  uint32_t i = 0, j = 0;
+  KAtomicStore32( &s_seqTest.isWriting, true, KATOMIC_RELAXED );
+  for( i = 0; i < SEQLOCK_TEST_READERS; i++ ) {
+    KTHREAD_CREATE_PARAMS( readerParams,
+                           "SeqLockTest",
+                           Reader,
+                           NULL,
+                           s_seqTest.stacks[ i ],
+                           SEQLOCK_TEST_STACK_SIZE,
+                           SEMANTIC_THREAD_PRIORITY_MID );
+    TEST_ASSERT( KThreadCreate( &s_seqTest.readers[ i ], KTHREAD_PARAMS( readerParams ) ) );
+  }
+  //Keep writing till the readers have had a fair go at it
+  for( i = 1; i <= SEQLOCK_TEST_WRITES || KAtomicLoad32( &s_seqTest.reads, KATOMIC_RELAXED ) < SEQLOCK_TEST_READS; i++ ) {
+    for( j = 0; j < SEQLOCK_TEST_WORDS; j++ ) {
+      next.words[ j ] = i;
+    }
+    KSeqLockWrite( &s_seqTest.lock, &s_seqTest.shared, &next, sizeof( next ) );
+  }
+  KAtomicStore32( &s_seqTest.isWriting, false, KATOMIC_RELEASE );
+  for( i = 0; i < SEQLOCK_TEST_READERS; i++ ) {
+    TEST_ASSERT( KThreadDelete( &s_seqTest.readers[ i ] ) );
+  }
+  TEST_ASSERT_EQUAL_INT( 0, KAtomicLoad32( &s_seqTest.torn, KATOMIC_RELAXED ) );
+}
+
+static void RetryFlagsOverlappingWrites( void )
+{
+  KSeqLock* pLock = &s_seqTest.lock;
+  uint32_t seq = KSeqLockReadBegin( pLock );
+  TEST_ASSERT( !KSeqLockReadRetry( pLock, seq ) );
+  KSeqLockWriteBegin( pLock );
+  KSeqLockWriteEnd( pLock );
+  TEST_ASSERT( KSeqLockReadRetry( pLock, seq ) );
+  seq = KSeqLockReadBegin( pLock );
+  TEST_ASSERT( !KSeqLockReadRetry( pLock, seq ) );
+}
+
+TestRef SeqLockTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "ReadersNeverSeeTornSnapshots", ReadersNeverSeeTornSnapshots ),
+    new_TestFixture( "RetryFlagsOverlappingWrites", RetryFlagsOverlappingWrites )
+  };
+  EMB_UNIT_TESTCALLER( SeqLockApiTest, "SeqLockApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&SeqLockApiTest;
+}
@@ -0,0 +1,154 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <SpinLockInterface.h>
+#include <ThreadInterface.h>
+#include <string.h>
+
+#define SPINLOCK_TEST_THREADS         ( 4 )
+#define SPINLOCK_TEST_ROUNDS          ( 10000 )
+#define SPINLOCK_TEST_HOLD            ( 32 )
+#define SPINLOCK_TEST_STACK_SIZE      ( 1 << 16 )
+
+typedef struct _SpinLockTestData
+{
+  KThread threads[ SPINLOCK_TEST_THREADS ];
+  uint8_t stacks[ SPINLOCK_TEST_THREADS ][ SPINLOCK_TEST_STACK_SIZE ];
+  KSpinLock spinLock;
+  KMcsLock mcsLock;
+  //Updated without atomics, a broken lock loses increments
+  volatile uint32_t counter;
+  volatile uint32_t shadow;
+  uint32_t mismatches;
+}SpinLockTestData;
+
+static SpinLockTestData s_spinTest;
+
+static void setUp( void )
+{
+  KSpinLockInit( &s_spinTest.spinLock );
+  KMcsLockInit( &s_spinTest.mcsLock );
+  s_spinTest.counter = 0;
+  s_spinTest.shadow = 0;
+  s_spinTest.mismatches = 0;
+}
+
+static void tearDown( void )
+{
+}
+
+static void Increment( void )
+{
+  uint32_t counter = s_spinTest.counter;
+  uint32_t i = 0;
+  //Widens the window in which a broken lock lets another thread in
+  for( i = 0; i < SPINLOCK_TEST_HOLD; i++ ) {
+    KCPU_RELAX();
+  }
+  if ( counter != s_spinTest.shadow ) {
+    s_spinTest.mismatches++;
+  }
+  s_spinTest.counter = counter + 1;
+  s_spinTest.shadow = counter + 1;
+}
+
+static void TicketIncrementer( void* arg )
+{
+  uint32_t i = 0;
+  for( i = 0; i < SPINLOCK_TEST_ROUNDS; i++ ) {
+    KSpinLockLock( &s_spinTest.spinLock );
+    Increment();
+    KSpinLockUnlock( &s_spinTest.spinLock );
+  }
+}
+
+static void McsIncrementer( void* arg )
+{
+  KMcsNode node;
+  uint32_t i = 0;
+  for( i = 0; i < SPINLOCK_TEST_ROUNDS; i++ ) {
+    KMcsLockLock( &s_spinTest.mcsLock, &node );
+    Increment();
+    KMcsLockUnlock( &s_spinTest.mcsLock, &node );
+  }
+}
+
+static void RunIncrementers( KThreadCallback fn )
+{
+  uint32_t i = 0;
+  for( i = 0; i < SPINLOCK_TEST_THREADS; i++ ) {
+    KTHREAD_CREATE_PARAMS( incrementerParams,
+                           "SpinLockTest",
+                           fn,
+                           NULL,
+                           s_spinTest.stacks[ i ],
+                           SPINLOCK_TEST_STACK_SIZE,
+                           SEMANTIC_THREAD_PRIORITY_MID );
+    TEST_ASSERT( KThreadCreate( &s_spinTest.threads[ i ], KTHREAD_PARAMS( incrementerParams ) ) );
+  }
+  for( i = 0; i < SPINLOCK_TEST_THREADS; i++ ) {
+    TEST_ASSERT( KThreadDelete( &s_spinTest.threads[ i ] ) );
+  }
+  TEST_ASSERT_EQUAL_INT( SPINLOCK_TEST_THREADS * SPINLOCK_TEST_ROUNDS, s_spinTest.counter );
+  TEST_ASSERT_EQUAL_INT( 0, s_spinTest.mismatches );
+}
+
+static void TicketLockIsExclusive( void )
+{
+  RunIncrementers( TicketIncrementer );
+}
+
+static void McsLockIsExclusive( void )
+{
+  RunIncrementers( McsIncrementer );
+}
+
+static void TryLockFailsWhileHeld( void )
+{
+  KMcsNode node, otherNode;
+  TEST_ASSERT( KSpinLockTryLock( &s_spinTest.spinLock ) );
+  TEST_ASSERT( !KSpinLockTryLock( &s_spinTest.spinLock ) );
+  KSpinLockUnlock( &s_spinTest.spinLock );
+  KSpinLockLock( &s_spinTest.spinLock );
+  KSpinLockUnlock( &s_spinTest.spinLock );
+  TEST_ASSERT( KSpinLockTryLock( &s_spinTest.spinLock ) );
+  KSpinLockUnlock( &s_spinTest.spinLock );
+
+  TEST_ASSERT( KMcsLockTryLock( &s_spinTest.mcsLock, &node ) );
+  TEST_ASSERT( !KMcsLockTryLock( &s_spinTest.mcsLock, &otherNode ) );
+  KMcsLockUnlock( &s_spinTest.mcsLock, &node );
+  TEST_ASSERT( KMcsLockTryLock( &s_spinTest.mcsLock, &otherNode ) );
+  KMcsLockUnlock( &s_spinTest.mcsLock, &otherNode );
+}
+
+TestRef SpinLockTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "TicketLockIsExclusive", TicketLockIsExclusive ),
+    new_TestFixture( "McsLockIsExclusive", McsLockIsExclusive ),
+    new_TestFixture( "TryLockFailsWhileHeld", TryLockFailsWhileHeld )
+  };
+  EMB_UNIT_TESTCALLER( SpinLockApiTest, "SpinLockApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&SpinLockApiTest;
+}
@@ -0,0 +1,116 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <ThreadPool.h>
+#include <SemaphoreInterface.h>
+#include <AtomicInterface.h>
+
+#define THREAD_POOL_TEST_THREADS        ( 2 )
+#define THREAD_POOL_TEST_STACK_SIZE     ( 1 << 16 )
+#define THREAD_POOL_TEST_RUNS           ( 200 )
+
+typedef struct _ThreadPoolTestData
+{
+  KThreadPool pool;
+  uint8_t stacks[ THREAD_POOL_TEST_THREADS ][ THREAD_POOL_TEST_STACK_SIZE ];
+  KAtomicU32 runs;
+  KSema releaseSema;
+}ThreadPoolTestData;
+
+static ThreadPoolTestData s_poolTest;
+
+static void setUp( void )
+{
+  KThreadPoolDef def = { 
+    .pName = "ThreadPoolTest",
+    .threadCount = THREAD_POOL_TEST_THREADS,
+    .stackSize = THREAD_POOL_TEST_STACK_SIZE,
+    .priority = SEMANTIC_THREAD_PRIORITY_MID,
+    .pStack = s_poolTest.stacks
+  };
+  KAtomicStore32( &s_poolTest.runs, 0, KATOMIC_RELAXED );
+  KSemaCreate( &s_poolTest.releaseSema, "ThreadPoolTest", 0 );
+  KThreadPoolCreate( &s_poolTest.pool, &def );
+}
+
+static void tearDown( void )
+{
+  KThreadPoolDestroy( &s_poolTest.pool );
+  KSemaDelete( &s_poolTest.releaseSema );
+}
+
+static void CountRun( void* arg )
+{
+  KAtomicFetchAdd32( &s_poolTest.runs, 1, KATOMIC_RELAXED );
+}
+
+static void WaitForRelease( void* arg )
+{
+  KSemaGet( &s_poolTest.releaseSema, WAIT_FOREVER );
+  CountRun( arg );
+}
+
+static void ThreadsAreReused( void )
+{
+  uint32_t i = 0;
+  for( i = 0; i < THREAD_POOL_TEST_RUNS; i++ ) {
+    KPooledThread* pThread = KThreadPoolStart( &s_poolTest.pool, CountRun, NULL, NO_SLEEP );
+    TEST_ASSERT( pThread != NULL );
+    KThreadPoolJoin( pThread );
+    TEST_ASSERT_EQUAL_INT( i + 1, KAtomicLoad32( &s_poolTest.runs, KATOMIC_RELAXED ) );
+  }
+}
+
+static void StartFailsWhileAllThreadsRun( void )
+{
+  KPooledThread* pThreads[ THREAD_POOL_TEST_THREADS ] = { NULL };
+  KPooledThread* pLast = NULL;
+  uint32_t i = 0;
+  for( i = 0; i < THREAD_POOL_TEST_THREADS; i++ ) {
+    pThreads[ i ] = KThreadPoolStart( &s_poolTest.pool, WaitForRelease, NULL, NO_SLEEP );
+    TEST_ASSERT( pThreads[ i ] != NULL );
+  }
+  TEST_ASSERT( KThreadPoolStart( &s_poolTest.pool, CountRun, NULL, 10 ) == NULL );
+  for( i = 0; i < THREAD_POOL_TEST_THREADS; i++ ) {
+    KSemaPut( &s_poolTest.releaseSema );
+  }
+  for( i = 0; i < THREAD_POOL_TEST_THREADS; i++ ) {
+    KThreadPoolJoin( pThreads[ i ] );
+  }
+  //The thread parked last is handed out first
+  pLast = KThreadPoolStart( &s_poolTest.pool, CountRun, NULL, NO_SLEEP );
+  TEST_ASSERT( pLast == pThreads[ THREAD_POOL_TEST_THREADS - 1 ] );
+  KThreadPoolJoin( pLast );
+  TEST_ASSERT_EQUAL_INT( THREAD_POOL_TEST_THREADS + 1, KAtomicLoad32( &s_poolTest.runs, KATOMIC_RELAXED ) );
+}
+
+TestRef ThreadPoolTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "ThreadsAreReused", ThreadsAreReused ),
+    new_TestFixture( "StartFailsWhileAllThreadsRun", StartFailsWhileAllThreadsRun )
+  };
+  EMB_UNIT_TESTCALLER( ThreadPoolApiTest, "ThreadPoolApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&ThreadPoolApiTest;
+}
@@ -0,0 +1,149 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <TimerWheel.h>
+
+#define TIMER_WHEEL_TEST_ENTRIES        ( 8 )
+
+typedef struct _TimerWheelTestData
+{
+  TimerWheel wheel;
+  TimerWheelEntry entries[ TIMER_WHEEL_TEST_ENTRIES ];
+  TimerWheelEntry* pFired[ TIMER_WHEEL_TEST_ENTRIES ];
+  uint64_t firedAt[ TIMER_WHEEL_TEST_ENTRIES ];
+  uint32_t numFired;
+  uint64_t rearmTicks;
+}TimerWheelTestData;
+
+static TimerWheelTestData s_wheelTest;
+
+static void Expired( void* pContext, TimerWheelEntry* pEntry )
+{
+  TimerWheelTestData* pData = ( TimerWheelTestData* )pContext;
+  if ( pData->numFired < TIMER_WHEEL_TEST_ENTRIES ) {
+    pData->pFired[ pData->numFired ] = pEntry;
+    pData->firedAt[ pData->numFired ] = pData->wheel.now;
+  }
+  pData->numFired++;
+  if ( pData->rearmTicks ) {
+    TimerWheelAdd( &pData->wheel, pEntry, pData->rearmTicks );
+  }
+}
+
+static void setUp( void )
+{
+  uint32_t i = 0;
+  //Start off an odd tick so that slot boundaries are not aligned with the test delays
+  TimerWheelInit( &s_wheelTest.wheel, 1000003 );
+  for( i = 0; i < TIMER_WHEEL_TEST_ENTRIES; i++ ) {
+    TimerWheelEntryInit( &s_wheelTest.entries[ i ] );
+    s_wheelTest.pFired[ i ] = 0;
+    s_wheelTest.firedAt[ i ] = 0;
+  }
+  s_wheelTest.numFired = 0;
+  s_wheelTest.rearmTicks = 0;
+}
+
+static void tearDown( void )
+{
+}
+
+static void EntryFiresOnItsTick( void )
+{
+  TimerWheel* pWheel = &s_wheelTest.wheel;
+  uint64_t start = pWheel->now;
+  TimerWheelAdd( pWheel, &s_wheelTest.entries[ 0 ], 10 );
+  TEST_ASSERT( TimerWheelIsArmed( &s_wheelTest.entries[ 0 ] ) );
+  TEST_ASSERT( TimerWheelTicksToNextExpiry( pWheel ) == 10 );
+  TimerWheelAdvance( pWheel, start + 9, Expired, &s_wheelTest );
+  TEST_ASSERT_EQUAL_INT( 0, s_wheelTest.numFired );
+  TimerWheelAdvance( pWheel, start + 10, Expired, &s_wheelTest );
+  TEST_ASSERT_EQUAL_INT( 1, s_wheelTest.numFired );
+  TEST_ASSERT( !TimerWheelIsArmed( &s_wheelTest.entries[ 0 ] ) );
+  TEST_ASSERT( TimerWheelTicksToNextExpiry( pWheel ) == TIMER_WHEEL_NO_EXPIRY );
+}
+
+static void RemovedEntryDoesNotFire( void )
+{
+  TimerWheel* pWheel = &s_wheelTest.wheel;
+  uint64_t start = pWheel->now;
+  TimerWheelAdd( pWheel, &s_wheelTest.entries[ 0 ], 5 );
+  TimerWheelAdd( pWheel, &s_wheelTest.entries[ 1 ], 5 );
+  TimerWheelAdd( pWheel, &s_wheelTest.entries[ 2 ], 5 );
+  //Remove the head and then the tail of the slot list
+  TEST_ASSERT( TimerWheelRemove( pWheel, &s_wheelTest.entries[ 2 ] ) );
+  TEST_ASSERT( !TimerWheelRemove( pWheel, &s_wheelTest.entries[ 2 ] ) );
+  TEST_ASSERT( TimerWheelRemove( pWheel, &s_wheelTest.entries[ 0 ] ) );
+  TimerWheelAdvance( pWheel, start + 100, Expired, &s_wheelTest );
+  TEST_ASSERT_EQUAL_INT( 1, s_wheelTest.numFired );
+  TEST_ASSERT( s_wheelTest.pFired[ 0 ] == &s_wheelTest.entries[ 1 ] );
+  TEST_ASSERT_EQUAL_INT( 0, pWheel->count );
+}
+
+static void FarEntriesCascadeInOrder( void )
+{
+  TimerWheel* pWheel = &s_wheelTest.wheel;
+  uint64_t start = pWheel->now;
+  uint64_t delays[] = { 300000, 70, 5000, 1, 4096, 20000000 };
+  uint32_t i = 0;
+  for( i = 0; i < sizeof( delays ) / sizeof( delays[ 0 ] ); i++ ) {
+    TimerWheelAdd( pWheel, &s_wheelTest.entries[ i ], delays[ i ] );
+  }
+  TimerWheelAdvance( pWheel, start + 30000000, Expired, &s_wheelTest );
+  TEST_ASSERT_EQUAL_INT( 6, s_wheelTest.numFired );
+  TEST_ASSERT( s_wheelTest.pFired[ 0 ] == &s_wheelTest.entries[ 3 ] );
+  TEST_ASSERT( s_wheelTest.pFired[ 1 ] == &s_wheelTest.entries[ 1 ] );
+  TEST_ASSERT( s_wheelTest.pFired[ 2 ] == &s_wheelTest.entries[ 4 ] );
+  TEST_ASSERT( s_wheelTest.pFired[ 3 ] == &s_wheelTest.entries[ 2 ] );
+  TEST_ASSERT( s_wheelTest.pFired[ 4 ] == &s_wheelTest.entries[ 0 ] );
+  TEST_ASSERT( s_wheelTest.pFired[ 5 ] == &s_wheelTest.entries[ 5 ] );
+  TEST_ASSERT( s_wheelTest.firedAt[ 4 ] == start + 300000 );
+  //Beyond the range of the wheel
+  TEST_ASSERT( s_wheelTest.firedAt[ 5 ] == start + 20000000 );
+}
+
+static void EntryCanBeRearmedFromCallback( void )
+{
+  TimerWheel* pWheel = &s_wheelTest.wheel;
+  uint64_t start = pWheel->now;
+  s_wheelTest.rearmTicks = 100;
+  TimerWheelAdd( pWheel, &s_wheelTest.entries[ 0 ], 100 );
+  TimerWheelAdvance( pWheel, start + 450, Expired, &s_wheelTest );
+  TEST_ASSERT_EQUAL_INT( 4, s_wheelTest.numFired );
+  TEST_ASSERT( s_wheelTest.firedAt[ 3 ] == start + 400 );
+  TEST_ASSERT( TimerWheelIsArmed( &s_wheelTest.entries[ 0 ] ) );
+  TEST_ASSERT( TimerWheelTicksToNextExpiry( pWheel ) <= 50 );
+}
+
+TestRef TimerWheelTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "EntryFiresOnItsTick", EntryFiresOnItsTick ),
+    new_TestFixture( "RemovedEntryDoesNotFire", RemovedEntryDoesNotFire ),
+    new_TestFixture( "FarEntriesCascadeInOrder", FarEntriesCascadeInOrder ),
+    new_TestFixture( "EntryCanBeRearmedFromCallback", EntryCanBeRearmedFromCallback )
+  };
+  EMB_UNIT_TESTCALLER( TimerWheelApiTest, "TimerWheelApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&TimerWheelApiTest;
+}
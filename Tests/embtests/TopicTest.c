@@ -0,0 +1,199 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <embUnit.h>
+#include <Topic.h>
+#include <ThreadInterface.h>
+#include <SemaphoreInterface.h>
+
+#define TOPIC_TEST_PAYLOADS             ( 4 )
+#define TOPIC_TEST_SUBSCRIBERS          ( 2 )
+#define TOPIC_TEST_QUEUE_DEPTH          ( 4 )
+#define TOPIC_TEST_STACK_SIZE           ( 1 << 16 )
+#define TOPIC_TEST_WAIT_MS              ( 1000 )
+
+typedef struct _TopicTestPayload
+{
+  uint32_t value;
+}TopicTestPayload;
+
+KTOPIC_DEF( topicTest, TOPIC_TEST_PAYLOADS, TopicTestPayload );
+
+typedef struct _TopicTestData
+{
+  uint8_t msgStore[ TOPIC_TEST_SUBSCRIBERS ][ MESSAGE_THREAD_BACKING_STORE_SIZE( TOPIC_TEST_QUEUE_DEPTH, TopicTestPayload ) ];
+  MessageThreadHandle hSubscribers[ TOPIC_TEST_SUBSCRIBERS ];
+  MessageHandle hReceived[ TOPIC_TEST_SUBSCRIBERS ];
+  KSema receivedSema;
+  bool topicCreated;
+}TopicTestData;
+
+static TopicTestData s_topicTest;
+
+static void SubscriberInit( MessageThreadHandle hThread )
+{
+}
+
+static void SubscriberProcess( MessageThreadHandle hThread, MessageHandle hMessage )
+{
+  uint32_t i = *( uint32_t* )MessageThreadGetPrivateData( hThread );
+  s_topicTest.hReceived[ i ] = hMessage;
+  KSemaPut( &s_topicTest.receivedSema );
+}
+
+static bool OddValuesOnly( void* pContext, MessageHandle hPayload )
+{
+  return ( ( TopicTestPayload* )hPayload )->value & 1;
+}
+
+static const uint32_t s_subscriberIds[ TOPIC_TEST_SUBSCRIBERS ] = { 0, 1 };
+MESSAGE_THREAD_DEF( topicSubscriber0, TOPIC_TEST_STACK_SIZE, SEMANTIC_THREAD_PRIORITY_MID, s_topicTest.msgStore[ 0 ],
+                    TOPIC_TEST_QUEUE_DEPTH, TopicTestPayload, ( void* )&s_subscriberIds[ 0 ], SubscriberInit, SubscriberProcess );
+MESSAGE_THREAD_DEF( topicSubscriber1, TOPIC_TEST_STACK_SIZE, SEMANTIC_THREAD_PRIORITY_MID, s_topicTest.msgStore[ 1 ],
+                    TOPIC_TEST_QUEUE_DEPTH, TopicTestPayload, ( void* )&s_subscriberIds[ 1 ], SubscriberInit, SubscriberProcess );
+
+static void setUp( void )
+{
+  if ( !s_topicTest.hSubscribers[ 0 ] ) {
+    //The subscriber threads live for the rest of the test run
+    MessageThreadSystemInit();
+    KSemaCreate( &s_topicTest.receivedSema, "TopicTestSema", 0 );
+    s_topicTest.hSubscribers[ 0 ] = MessageThreadCreate( MESSAGE_THREAD( topicSubscriber0 ) );
+    s_topicTest.hSubscribers[ 1 ] = MessageThreadCreate( MESSAGE_THREAD( topicSubscriber1 ) );
+  }
+  s_topicTest.hReceived[ 0 ] = s_topicTest.hReceived[ 1 ] = NULL;
+  s_topicTest.topicCreated = KTopicCreate( &KTOPIC( topicTest ),
+                                           "topicTest",
+                                           KTOPIC_STORE( topicTest ),
+                                           TOPIC_TEST_PAYLOADS,
+                                           sizeof( TopicTestPayload ) );
+}
+
+static void tearDown( void )
+{
+  KTopicUnsubscribe( &KTOPIC( topicTest ), s_topicTest.hSubscribers[ 0 ] );
+  KTopicUnsubscribe( &KTOPIC( topicTest ), s_topicTest.hSubscribers[ 1 ] );
+  KTopicDestroy( &KTOPIC( topicTest ) );
+}
+
+static bool WaitForDeliveries( uint32_t count )
+{
+  bool retval = true;
+  while( count-- && retval ) {
+    retval = KSemaGet( &s_topicTest.receivedSema, TOPIC_TEST_WAIT_MS );
+  }
+  return retval;
+}
+
+//Payloads are released after the subscribers are done with them
+static bool AllPayloadsReturned( void )
+{
+  bool retval = false;
+  uint32_t tries = TOPIC_TEST_WAIT_MS;
+  while( !retval && tries-- ) {
+    MessageHandle hPayloads[ TOPIC_TEST_PAYLOADS ];
+    uint32_t i = 0;
+    retval = true;
+    for( i = 0; i < TOPIC_TEST_PAYLOADS; i++ ) {
+      hPayloads[ i ] = KTopicAllocatePayload( &KTOPIC( topicTest ) );
+      retval = retval && hPayloads[ i ];
+    }
+    for( i = 0; i < TOPIC_TEST_PAYLOADS; i++ ) {
+      KTopicDestroyPayload( &KTOPIC( topicTest ), &hPayloads[ i ] );
+    }
+    if ( !retval ) {
+      KThreadSleep( 1 );
+    }
+  }
+  return retval;
+}
+
+static void TopicCanBeCreated( void )
+{
+  TEST_ASSERT( s_topicTest.topicCreated );
+  TEST_ASSERT( s_topicTest.hSubscribers[ 0 ] && s_topicTest.hSubscribers[ 1 ] );
+}
+
+static void PublishSharesOnePayload( void )
+{
+  TopicTestPayload* pPayload = NULL;
+  TEST_ASSERT( KTopicSubscribe( &KTOPIC( topicTest ), s_topicTest.hSubscribers[ 0 ], NULL, NULL ) );
+  TEST_ASSERT( KTopicSubscribe( &KTOPIC( topicTest ), s_topicTest.hSubscribers[ 1 ], NULL, NULL ) );
+  pPayload = ( TopicTestPayload* )KTopicAllocatePayload( &KTOPIC( topicTest ) );
+  TEST_ASSERT( pPayload );
+  pPayload->value = 2;
+  TEST_ASSERT_EQUAL_INT( 2, KTopicPublish( &KTOPIC( topicTest ), pPayload ) );
+  TEST_ASSERT( WaitForDeliveries( 2 ) );
+  TEST_ASSERT( s_topicTest.hReceived[ 0 ] == pPayload );
+  TEST_ASSERT( s_topicTest.hReceived[ 1 ] == pPayload );
+  TEST_ASSERT( AllPayloadsReturned() );
+}
+
+static void FilterSkipsSubscriber( void )
+{
+  TopicTestPayload* pPayload = NULL;
+  TEST_ASSERT( KTopicSubscribe( &KTOPIC( topicTest ), s_topicTest.hSubscribers[ 0 ], NULL, NULL ) );
+  TEST_ASSERT( KTopicSubscribe( &KTOPIC( topicTest ), s_topicTest.hSubscribers[ 1 ], OddValuesOnly, NULL ) );
+  pPayload = ( TopicTestPayload* )KTopicAllocatePayload( &KTOPIC( topicTest ) );
+  pPayload->value = 4;
+  TEST_ASSERT_EQUAL_INT( 1, KTopicPublish( &KTOPIC( topicTest ), pPayload ) );
+  TEST_ASSERT( WaitForDeliveries( 1 ) );
+  TEST_ASSERT( s_topicTest.hReceived[ 0 ] == pPayload );
+  TEST_ASSERT( s_topicTest.hReceived[ 1 ] == NULL );
+  TEST_ASSERT( AllPayloadsReturned() );
+}
+
+static void UnsubscribedThreadIsSkipped( void )
+{
+  MessageHandle hPayload = NULL;
+  TEST_ASSERT( KTopicSubscribe( &KTOPIC( topicTest ), s_topicTest.hSubscribers[ 0 ], NULL, NULL ) );
+  TEST_ASSERT( KTopicSubscribe( &KTOPIC( topicTest ), s_topicTest.hSubscribers[ 1 ], NULL, NULL ) );
+  TEST_ASSERT( KTopicUnsubscribe( &KTOPIC( topicTest ), s_topicTest.hSubscribers[ 0 ] ) );
+  TEST_ASSERT( !KTopicUnsubscribe( &KTOPIC( topicTest ), s_topicTest.hSubscribers[ 0 ] ) );
+  hPayload = KTopicAllocatePayload( &KTOPIC( topicTest ) );
+  TEST_ASSERT_EQUAL_INT( 1, KTopicPublish( &KTOPIC( topicTest ), hPayload ) );
+  TEST_ASSERT( WaitForDeliveries( 1 ) );
+  TEST_ASSERT( s_topicTest.hReceived[ 0 ] == NULL );
+  TEST_ASSERT( s_topicTest.hReceived[ 1 ] == hPayload );
+  TEST_ASSERT( AllPayloadsReturned() );
+}
+
+static void PayloadWithoutSubscribersIsReleased( void )
+{
+  MessageHandle hPayload = KTopicAllocatePayload( &KTOPIC( topicTest ) );
+  TEST_ASSERT_EQUAL_INT( 0, KTopicPublish( &KTOPIC( topicTest ), hPayload ) );
+  TEST_ASSERT( AllPayloadsReturned() );
+}
+
+TestRef TopicTest_ApiTests( void )
+{
+  EMB_UNIT_TESTFIXTURES( fixtures ) {
+    new_TestFixture( "TopicCanBeCreated", TopicCanBeCreated ),
+    new_TestFixture( "PublishSharesOnePayload", PublishSharesOnePayload ),
+    new_TestFixture( "FilterSkipsSubscriber", FilterSkipsSubscriber ),
+    new_TestFixture( "UnsubscribedThreadIsSkipped", UnsubscribedThreadIsSkipped ),
+    new_TestFixture( "PayloadWithoutSubscribersIsReleased", PayloadWithoutSubscribersIsReleased )
+  };
+  EMB_UNIT_TESTCALLER( TopicApiTest, "TopicApiTest", setUp, tearDown, fixtures );
+  return ( TestRef )&TopicApiTest;
+}
@@ -89,7 +89,8 @@ bool TsLogBufferInit( TsLogBuffer* pLb, char* pBuffer, uint32_t bufferSize, char
 {
   bool retval = false;
   if ( pLb ) {
-    if ( KMutexCreate( &pLb->mtx, logBufferName ) ) {
+    //Held for a short copy into the ring, no need for owner checks or priority inheritance
+    if ( KMutexCreateEx( &pLb->mtx, logBufferName, KMUTEX_KIND_ADAPTIVE, 0 ) ) {
       retval = LogBufferInit( &pLb->lb, pBuffer, bufferSize );
     }
   }
@@ -0,0 +1,179 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "TimerWheel.h"
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif 
+
+#define LEVEL_SHIFT( level )        ( TIMER_WHEEL_SLOT_BITS * ( level ) )
+#define SLOT_MASK                   ( TIMER_WHEEL_SLOTS - 1 )
+#define WHEEL_RANGE                 ( ( uint64_t )1 << LEVEL_SHIFT( TIMER_WHEEL_LEVELS ) )
+
+static void Insert( TimerWheel* pWheel, TimerWheelEntry* pEntry )
+{
+  uint64_t expiry = ( pEntry->expiry > pWheel->now ) ? pEntry->expiry : pWheel->now;
+  uint32_t level = 0;
+  KListHead** ppSlot = 0;
+  if ( expiry - pWheel->now >= WHEEL_RANGE ) {
+    //Out of reach. Park it in the furthest slot, it is placed again when that slot is cascaded.
+    expiry = pWheel->now + WHEEL_RANGE - 1;
+  }
+  while( level < TIMER_WHEEL_LEVELS - 1 &&
+         expiry - pWheel->now >= ( ( uint64_t )1 << LEVEL_SHIFT( level + 1 ) ) ) {
+    level++;
+  }
+  ppSlot = &pWheel->slots[ level ][ ( expiry >> LEVEL_SHIFT( level ) ) & SLOT_MASK ];
+  KLIST_HEAD_INIT( &pEntry->listElem );
+  KLIST_HEAD_PREPEND( *ppSlot, &pEntry->listElem );
+  pEntry->ppSlot = ppSlot;
+  pWheel->count++;
+}
+
+static KListElem* TakeSlot( TimerWheel* pWheel, KListHead** ppSlot )
+{
+  KListElem* pList = *ppSlot;
+  KListElem* pElem = pList;
+  *ppSlot = 0;
+  while( pElem ) {
+    ( ( TimerWheelEntry* )pElem )->ppSlot = 0;
+    pWheel->count--;
+    pElem = pElem->next;
+  }
+  return pList;
+}
+
+static void Tick( TimerWheel* pWheel, TimerWheelExpired fnExpired, void* pContext )
+{
+  uint64_t now = pWheel->now;
+  KListElem* pElem = 0;
+  int32_t level = 0;
+  //Cascade the upper levels whose slot boundary was reached, outermost first
+  for( level = TIMER_WHEEL_LEVELS - 1; level > 0; level-- ) {
+    if ( ( now & ( ( ( uint64_t )1 << LEVEL_SHIFT( level ) ) - 1 ) ) == 0 ) {
+      pElem = TakeSlot( pWheel, &pWheel->slots[ level ][ ( now >> LEVEL_SHIFT( level ) ) & SLOT_MASK ] );
+      while( pElem ) {
+        KListElem* pNext = pElem->next;
+        Insert( pWheel, ( TimerWheelEntry* )pElem );
+        pElem = pNext;
+      }
+    }
+  }
+  pElem = TakeSlot( pWheel, &pWheel->slots[ 0 ][ now & SLOT_MASK ] );
+  while( pElem ) {
+    KListElem* pNext = pElem->next;
+    pElem->next = pElem->prev = 0;
+    fnExpired( pContext, ( TimerWheelEntry* )pElem );
+    pElem = pNext;
+  }
+}
+
+void TimerWheelInit( TimerWheel* pWheel, uint64_t now )
+{
+  if ( pWheel ) {
+    memset( pWheel->slots, 0, sizeof( pWheel->slots ) );
+    pWheel->now = now;
+    pWheel->count = 0;
+  }
+}
+
+void TimerWheelEntryInit( TimerWheelEntry* pEntry )
+{
+  if ( pEntry ) {
+    KLIST_HEAD_INIT( &pEntry->listElem );
+    pEntry->ppSlot = 0;
+    pEntry->expiry = 0;
+  }
+}
+
+bool TimerWheelIsArmed( TimerWheelEntry* pEntry )
+{
+  return ( pEntry && pEntry->ppSlot );
+}
+
+void TimerWheelAdd( TimerWheel* pWheel, TimerWheelEntry* pEntry, uint64_t ticks )
+{
+  if ( pWheel && pEntry ) {
+    TimerWheelRemove( pWheel, pEntry );
+    pEntry->expiry = pWheel->now + ( ( ticks ) ? ticks : 1 );
+    Insert( pWheel, pEntry );
+  }
+}
+
+bool TimerWheelRemove( TimerWheel* pWheel, TimerWheelEntry* pEntry )
+{
+  bool retval = false;
+  if ( pWheel && TimerWheelIsArmed( pEntry ) ) {
+    if ( *pEntry->ppSlot == &pEntry->listElem ) {
+      *pEntry->ppSlot = pEntry->listElem.next;
+    }
+    KLIST_REMOVE_ELEM( &pEntry->listElem );
+    pEntry->ppSlot = 0;
+    pWheel->count--;
+    retval = true;
+  }
+  return retval;
+}
+
+uint64_t TimerWheelTicksToNextExpiry( TimerWheel* pWheel )
+{
+  uint64_t retval = TIMER_WHEEL_NO_EXPIRY;
+  if ( pWheel && pWheel->count ) {
+    uint32_t level = 0;
+    for( level = 0; level < TIMER_WHEEL_LEVELS; level++ ) {
+      uint64_t base = pWheel->now >> LEVEL_SHIFT( level );
+      uint64_t i = 0;
+      //The slot of the current tick was already handled, its entries belong to the next turn
+      for( i = 1; i <= TIMER_WHEEL_SLOTS; i++ ) {
+        if ( pWheel->slots[ level ][ ( base + i ) & SLOT_MASK ] ) {
+          uint64_t ticks = ( ( base + i ) << LEVEL_SHIFT( level ) ) - pWheel->now;
+          retval = ( ticks < retval ) ? ticks : retval;
+          break;
+        }
+      }
+    }
+  }
+  return retval;
+}
+
+void TimerWheelAdvance( TimerWheel* pWheel, uint64_t now, TimerWheelExpired fnExpired, void* pContext )
+{
+  if ( pWheel && fnExpired ) {
+    while( pWheel->now < now ) {
+      uint64_t ticks = TimerWheelTicksToNextExpiry( pWheel );
+      if ( ticks > now - pWheel->now ) {
+        //Nothing to do till now
+        pWheel->now = now;
+      } else {
+        pWheel->now += ticks;
+        Tick( pWheel, fnExpired, pContext );
+      }
+    }
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif 
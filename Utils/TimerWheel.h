@@ -0,0 +1,162 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) <2014> <Kartik Aiyer>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "klist.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup TimerWheel - a hierarchical timing wheel
+ *  Keeps a large number of timers with O(1) insert and remove.
+ *  Time is counted in abstract ticks. Level 0 has one slot per
+ *  tick, every level above it has slots that are
+ *  TIMER_WHEEL_SLOTS times wider. Timers in the upper levels are
+ *  cascaded down as the wheel turns. Timers are intrusive, the
+ *  client embeds a @ref TimerWheelEntry in its own data, so
+ *  arming a timer never allocates. This is not thread safe.
+ **/
+
+#define TIMER_WHEEL_LEVELS          ( 4 )
+#define TIMER_WHEEL_SLOT_BITS       ( 6 )
+#define TIMER_WHEEL_SLOTS           ( 1 << TIMER_WHEEL_SLOT_BITS )
+#define TIMER_WHEEL_NO_EXPIRY       ( ( uint64_t )-1 )
+
+/**
+ * @struct TimerWheelEntry - A timer that can be armed in a 
+ *         TimerWheel. 
+ *  
+ * Embed this in the data structure that is to be timed and 
+ * initialize it with TimerWheelEntryInit(). 
+ */
+typedef struct _TimerWheelEntry
+{
+  KListElem listElem;     /**< Must be first, links the entry into its slot */
+  KListHead** ppSlot;     /**< Slot holding the entry, 0 when not armed */
+  uint64_t expiry;        /**< Absolute tick at which the entry expires */
+}TimerWheelEntry;
+
+/**
+ * @struct TimerWheel - The wheel. Owned by the client.
+ */
+typedef struct _TimerWheel
+{
+  KListHead* slots[ TIMER_WHEEL_LEVELS ][ TIMER_WHEEL_SLOTS ];
+  uint64_t now;           /**< Last tick the wheel was advanced to */
+  uint32_t count;         /**< Number of armed entries */
+}TimerWheel;
+
+/**
+ * Called by TimerWheelAdvance() for each entry that expires. 
+ * The entry is no longer armed and can be re-armed from the 
+ * callback. 
+ */
+typedef void (*TimerWheelExpired)( void* pContext, TimerWheelEntry* pEntry );
+
+/**
+ * TimerWheelInit - Initializes an empty wheel.
+ * 
+ * 
+ * @param pWheel - Allocated wheel owned by the client.
+ * @param now - Current tick.
+ */
+void TimerWheelInit( TimerWheel* pWheel, uint64_t now );
+
+/**
+ * TimerWheelEntryInit - Initializes an entry so that it is not 
+ * armed. 
+ * 
+ * 
+ * @param pEntry - Entry to initialize.
+ */
+void TimerWheelEntryInit( TimerWheelEntry* pEntry );
+
+/**
+ * TimerWheelIsArmed - Queries if the entry is in a wheel.
+ * 
+ * 
+ * @param pEntry - Initialized entry.
+ * 
+ * @return bool - true if armed.
+ */
+bool TimerWheelIsArmed( TimerWheelEntry* pEntry );
+
+/**
+ * TimerWheelAdd - Arms an entry to expire ticks after the tick 
+ * the wheel was last advanced to. An entry that is already 
+ * armed is re-armed. 
+ * 
+ * 
+ * @param pWheel - Initialized wheel.
+ * @param pEntry - Initialized entry.
+ * @param ticks - Ticks till expiry. 0 is treated as 1.
+ */
+void TimerWheelAdd( TimerWheel* pWheel, TimerWheelEntry* pEntry, uint64_t ticks );
+
+/**
+ * TimerWheelRemove - Disarms an entry.
+ * 
+ * 
+ * @param pWheel - Wheel the entry was added to.
+ * @param pEntry - Entry to disarm.
+ * 
+ * @return bool - true if the entry was armed.
+ */
+bool TimerWheelRemove( TimerWheel* pWheel, TimerWheelEntry* pEntry );
+
+/**
+ * TimerWheelTicksToNextExpiry - Gets the number of ticks the 
+ * client can wait before it has to advance the wheel again. 
+ * This can be earlier than the next expiry when entries have 
+ * to be cascaded. 
+ * 
+ * 
+ * @param pWheel - Initialized wheel.
+ * 
+ * @return uint64_t - Ticks, TIMER_WHEEL_NO_EXPIRY if the wheel 
+ *         is empty.
+ */
+uint64_t TimerWheelTicksToNextExpiry( TimerWheel* pWheel );
+
+/**
+ * TimerWheelAdvance - Turns the wheel to now and calls 
+ * fnExpired for every entry that expires on the way, in order of 
+ * expiry. Ticks with nothing to do are skipped. 
+ * 
+ * 
+ * @param pWheel - Initialized wheel.
+ * @param now - Current tick.
+ * @param fnExpired - Expiry callback.
+ * @param pContext - Passed to fnExpired.
+ */
+void TimerWheelAdvance( TimerWheel* pWheel, uint64_t now, TimerWheelExpired fnExpired, void* pContext );
+
+#ifdef __cplusplus
+}
+#endif 
+#endif //__TIMER_WHEEL_H__